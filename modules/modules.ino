@@ -9,11 +9,53 @@
 
 #include "src/BMI160.hpp"
 #include "src/BLE_HID.hpp"
+#include "src/BondStore.hpp"
 #include "src/ButtonMatrix.hpp"
+#include "src/FixedPipeline.hpp"
+#include "src/PointerBallistics.hpp"
+#include "src/TaskScheduler.hpp"
+#include "src/Telemetry.hpp"
+
+// Uncomment to drive the cursor from the integer only pipeline instead of the float chain of the BMI160 class.
+//#define USE_FIXED_PIPELINE
+
+// Uncomment to print the scheduler statistics every few seconds.
+//#define PRINT_SCHEDULER_STATS
+
+// Uncomment to print the motion to report latencies every few seconds. Needs ENABLE_LATENCY_TRACING in
+// src/LatencyStats.hpp.
+//#define PRINT_LATENCY_STATS
+
+// Uncomment to stream every sample as binary telemetry over the Serial (decode with tools/telemetry_decode.py). Text
+// output would end up inside the frames, so the sketch prints nothing while the telemetry runs.
+//#define USE_TELEMETRY
+
+#if defined(PRINT_LATENCY_STATS) && !defined(ENABLE_LATENCY_TRACING)
+#error "PRINT_LATENCY_STATS needs ENABLE_LATENCY_TRACING in src/LatencyStats.hpp"
+#endif
+
+#if defined(USE_TELEMETRY) && (defined(PRINT_SCHEDULER_STATS) || defined(PRINT_LATENCY_STATS) || \
+                               defined(ENABLE_PROFILING))
+#error "The statistics and the profile are printed as text, which corrupts the telemetry frames on the same Serial"
+#endif
 
 #define MAX_MOVEMENT_STRENGHT 64
-#define MOUSE_MOVEMENT_GAIN_X 200.0
-#define MOUSE_MOVEMENT_GAIN_Y 200.0
+
+// Every run of the sensor task advances the bus transfer by one phase. Reads only start on data ready, so polling
+// faster than the output data rate is cheap and finishes a read well within one sample period.
+#define SENSOR_TASK_PERIOD_US 1000
+// The transfer timeout runs from the start of a read, which spans three runs of the sensor task (one per bus phase)
+// on top of the bus time of a full FIFO batch.
+#define SENSOR_READ_TIMEOUT_US (3 * SENSOR_TASK_PERIOD_US + BMI160_READ_TIMEOUT_US)
+#define MATRIX_TASK_PERIOD_US 1000
+#define MATRIX_IDLE_TASK_PERIOD_US 10000    // While idle the task only checks for a wake edge
+#define REPORT_TASK_PERIOD_US BLE_HID_MIN_REPORT_INTERVAL_US
+#define STATS_TASK_PERIOD_US 5000000
+#define TELEMETRY_TASK_PERIOD_US 1000
+#define PROFILE_TASK_PERIOD_US 100000
+#define BOND_TASK_PERIOD_US 1000000     // Writing flash stalls the CPU, so changed bonds are only written once a second
+
+#define BMI160_INT1_PIN 2
 
 #define BUTTON_ROW_1 12
 #define BUTTON_ROW_2 10
@@ -23,20 +65,264 @@
 float data[6] = {0};
 BMI160 bmi160;
 BLE_HID input_device;
-ButtonMatrix buttons;
+BondStore bond_store;
+ButtonMatrix<2, 2> buttons;
+PointerBallistics pointer(MAX_MOVEMENT_STRENGHT);
+TaskScheduler scheduler;
+int8_t matrix_task;
+uint32_t advertising_time;
+bool boot_time_reported = false;
+
+#ifdef USE_FIXED_PIPELINE
+FixedPipeline fixed_pipeline;
+#endif
+
+#ifdef USE_TELEMETRY
+Telemetry telemetry(Serial);
+#endif
+
+// Called by the BMI160 for every new sample, so the cursor integrates each sample exactly once no matter how often
+// the loop runs.
+void processSample(int16_t raw_data[6])
+{
+#ifdef USE_FIXED_PIPELINE
+    int16_t fixed_data[6];
+    fixed_pipeline.process(raw_data);
+    fixed_pipeline.getProcessedData(fixed_data);
+    for(int i = 0; i < 6; i++)
+        data[i] = fixed_data[i] / (float)FIXED_PIPELINE_ONE;
+#else
+    (void)raw_data;
+    bmi160.getProcessedData(data);
+#endif
+
+    pointer.addMotion(-data[GYR_Z], data[GYR_X], bmi160.getSampleTimestamp());
+
+#ifdef USE_TELEMETRY
+    telemetry.sendSample(bmi160.getSampleTimestamp(), raw_data, data);
+#endif
+}
+
+// Advance the sensor read by one bus phase and start the next one once it finished.
+void sensorTask()
+{
+    if(bmi160.pollSensorRead() != BMI160_READ_BUSY)
+        bmi160.startSensorRead();
+}
+
+void matrixTask()
+{
+    buttons.fetchButtonPresses();
+    scheduler.setTaskPeriod(matrix_task, buttons.isIdle() ? MATRIX_IDLE_TASK_PERIOD_US : MATRIX_TASK_PERIOD_US);
+}
+
+void reportTask()
+{
+    if(!input_device.checkRemoteAvailability(false) || !input_device.checkRemoteConnection())
+    {
+        // Do not let movement pile up while nobody receives it
+        pointer.reset();
+        return;
+    }
+
+    int8_t x_movement;
+    int8_t y_movement;
+    uint32_t sample_time;
+    pointer.takeReport(x_movement, y_movement, sample_time);
+    float click_movement = data[GYR_Y];
+
+    input_device.setMouseMove(x_movement, y_movement, sample_time);
+
+    /*if(click_movement > 0.1)
+    {
+        Serial.println("Left Click");
+        input_device.setMouseButtonPress(MOUSE_LEFT);
+    }
+    else if(click_movement < -0.1)
+    {
+        Serial.println("Right Click");
+        input_device.setMouseButtonPress(MOUSE_RIGHT);
+    }*/
+
+    if(buttons.checkButtonPress(0, 0))
+    {
+#ifndef USE_TELEMETRY
+        Serial.println("Button up");
+#endif
+        input_device.setKeyboardButtonPress('w', MOD_LEFT_CTR | MOD_LEFT_ALT);
+    }
+    if(buttons.checkButtonPress(0, 1))
+    {
+#ifndef USE_TELEMETRY
+        Serial.println("Button down");
+#endif
+        input_device.setKeyboardButtonPress('s', MOD_LEFT_CTR | MOD_LEFT_ALT);
+    }
+    if(buttons.checkButtonPress(1, 0))
+    {
+#ifndef USE_TELEMETRY
+        Serial.println("Button left");
+#endif
+        input_device.setKeyboardButtonPress('a', MOD_LEFT_CTR | MOD_LEFT_ALT);
+    }
+    if(buttons.checkButtonPress(1, 1))
+    {
+#ifndef USE_TELEMETRY
+        Serial.println("Button right");
+#endif
+        input_device.setKeyboardButtonPress('d', MOD_LEFT_CTR | MOD_LEFT_ALT);
+    }
+
+    input_device.sendKeyboardMessage();
+    input_device.sendMouseMessage();
+
+#ifndef USE_TELEMETRY
+    if(!boot_time_reported && input_device.getFirstReportTime())
+    {
+        boot_time_reported = true;
+        Serial.print("Boot to advertising: ");
+        Serial.print(advertising_time);
+        Serial.print("us, to connection: ");
+        Serial.print(input_device.getFirstConnectionTime());
+        Serial.print("us, to first report: ");
+        Serial.print(input_device.getFirstReportTime());
+        Serial.println("us");
+    }
+#endif
+}
+
+// Writes new bonds and the last host to flash.
+void bondTask()
+{
+    bond_store.commit();
+}
+
+#ifdef USE_TELEMETRY
+void telemetryTask()
+{
+    telemetry.flush();
+}
+#endif
+
+#ifdef ENABLE_PROFILING
+// Send 'p' over the Serial to print the profile, 'r' to reset it.
+void profileTask()
+{
+    if(!Serial.available())
+        return;
+
+    int command = Serial.read();
+    if(command == 'p')
+        Profiler::print(Serial);
+    else if(command == 'r')
+        Profiler::reset();
+}
+#endif
+
+#ifdef PRINT_SCHEDULER_STATS
+void statsTask()
+{
+    scheduler.printStats();
+}
+#endif
+
+#ifdef PRINT_LATENCY_STATS
+// The end to end latency splits into the handoff (sampling, reading, processing and waiting for the report task) and
+// the report queue (waiting for the minimum report interval).
+void latencyTask()
+{
+    bmi160.getProcessingLatency().print(Serial, "Sample to processed");
+    input_device.getHandoffLatency().print(Serial, "Sample to handoff");
+    input_device.getReportQueueDelay().print(Serial, "Handoff to report");
+    input_device.getReportLatency().print(Serial, "Sample to report");
+
+    // The host picks the interval the connection runs with from the requested range
+    BLEConnectionParameters parameters;
+    BLEConnectionParameters requested;
+    if(input_device.getConnectionParameters(parameters))
+    {
+        Serial.print("Connection interval ");
+        Serial.print(parameters.min_interval * 1.25f);
+        Serial.print("ms, latency ");
+        Serial.print(parameters.latency);
+        Serial.print(", timeout ");
+        Serial.print(parameters.supervision_timeout * 10);
+        Serial.print("ms");
+        if(input_device.getRequestedConnectionParameters(requested))
+        {
+            Serial.print(", profile ");
+            Serial.print(input_device.getConnectionProfile() == BLE_HID_PROFILE_ACTIVE ? "active" : "idle");
+            Serial.print(" requested ");
+            Serial.print(requested.min_interval * 1.25f);
+            Serial.print("-");
+            Serial.print(requested.max_interval * 1.25f);
+            Serial.print("ms");
+        }
+        Serial.print(", failed updates ");
+        Serial.println(input_device.getConnectionUpdateFailures());
+    }
+}
+#endif
 
 void setup()
 {
+    // Do not wait for a Serial monitor, the device has to work on its own. Output without a monitor is dropped.
     Serial.begin(9600);
-    while (!Serial);
+#ifdef ENABLE_PROFILING
+    Profiler::begin();
+#endif
+    // Advertise first, so the host can already connect while the rest is set up
+    bond_store.begin();
+    input_device.useBondStore(bond_store);
     input_device.initService("Cyber Device");
+    advertising_time = micros();
+#ifdef USE_TELEMETRY
+    // Ends the text the BLE setup printed, so the first frame decodes
+    Serial.write((uint8_t)0x00);
+#endif
+
     Wire.begin();
-    bmi160.configureBMI160();
+    if(!bmi160.configureBMI160())
+    {
+#ifndef USE_TELEMETRY
+        Serial.println("[BMI160 ERROR] Configuration failed.");
+#endif
+    }
+    bmi160.setReadTimeout(SENSOR_READ_TIMEOUT_US);
+    pointer.setSampleRate(bmi160.getSampleRate());
+#ifdef USE_FIXED_PIPELINE
+    fixed_pipeline.setRanges(bmi160.getAccelerometerRange(), bmi160.getGyroscopeRange());
+#endif
+    if(!bmi160.enableFifo())
+    {
+#ifndef USE_TELEMETRY
+        Serial.println("[BMI160 ERROR] FIFO needs equal output data rates.");
+#endif
+    }
+    bmi160.enableDataReadyInterrupt(BMI160_INT1_PIN);
+    bmi160.setSampleCallback(processSample);
 
     buttons.addRowPin(BUTTON_ROW_1);
     buttons.addRowPin(BUTTON_ROW_2);
     buttons.addColPin(BUTTON_COL_1);
     buttons.addColPin(BUTTON_COL_2);
+
+    scheduler.addTask(sensorTask, SENSOR_TASK_PERIOD_US);
+    matrix_task = scheduler.addTask(matrixTask, MATRIX_TASK_PERIOD_US);
+    scheduler.addTask(reportTask, REPORT_TASK_PERIOD_US);
+    scheduler.addTask(bondTask, BOND_TASK_PERIOD_US);
+#ifdef USE_TELEMETRY
+    scheduler.addTask(telemetryTask, TELEMETRY_TASK_PERIOD_US);
+#endif
+#ifdef ENABLE_PROFILING
+    scheduler.addTask(profileTask, PROFILE_TASK_PERIOD_US);
+#endif
+#ifdef PRINT_SCHEDULER_STATS
+    scheduler.addTask(statsTask, STATS_TASK_PERIOD_US);
+#endif
+#ifdef PRINT_LATENCY_STATS
+    scheduler.addTask(latencyTask, STATS_TASK_PERIOD_US);
+#endif
 }
 
 void loop()
@@ -44,63 +330,5 @@ void loop()
     //bmi160.testRoutine(true);
     //input_device.testRoutine();
 
-    buttons.fetchButtonPresses();
-    bmi160.fetchSensorData();
-    bmi160.getProcessedData(data);
-
-    if(input_device.checkRemoteAvailability(false))
-    {
-        if(input_device.checkRemoteConnection())
-        {
-            int16_t x_movement = data[GYR_Z] * MOUSE_MOVEMENT_GAIN_X * -1.0;
-            int16_t y_movement = data[GYR_X] * MOUSE_MOVEMENT_GAIN_Y;
-            float click_movement = data[GYR_Y];
-
-            if(x_movement > MAX_MOVEMENT_STRENGHT)
-                x_movement = MAX_MOVEMENT_STRENGHT;
-            if(x_movement < -MAX_MOVEMENT_STRENGHT)
-                x_movement = -MAX_MOVEMENT_STRENGHT;
-            if(y_movement > MAX_MOVEMENT_STRENGHT)
-                y_movement = MAX_MOVEMENT_STRENGHT;
-            if(y_movement < -MAX_MOVEMENT_STRENGHT)
-                y_movement = -MAX_MOVEMENT_STRENGHT;
-
-            input_device.setMouseMove(x_movement, y_movement);
-
-            /*if(click_movement > 0.1)
-            {
-                Serial.println("Left Click");
-                input_device.setMouseButtonPress(MOUSE_LEFT);
-            }
-            else if(click_movement < -0.1)
-            {
-                Serial.println("Right Click");
-                input_device.setMouseButtonPress(MOUSE_RIGHT);
-            }*/
-
-            if(buttons.checkButtonPress(0, 0))
-            {
-                Serial.println("Button up");
-                input_device.setKeyboardButtonPress('w', MOD_LEFT_CTR | MOD_LEFT_ALT);
-            }
-            if(buttons.checkButtonPress(0, 1))
-            {
-                Serial.println("Button down");
-                input_device.setKeyboardButtonPress('s', MOD_LEFT_CTR | MOD_LEFT_ALT);
-            }
-            if(buttons.checkButtonPress(1, 0))
-            {
-                Serial.println("Button left");
-                input_device.setKeyboardButtonPress('a', MOD_LEFT_CTR | MOD_LEFT_ALT);
-            }
-            if(buttons.checkButtonPress(1, 1))
-            {
-                Serial.println("Button right");
-                input_device.setKeyboardButtonPress('d', MOD_LEFT_CTR | MOD_LEFT_ALT);
-            }
-
-            input_device.sendKeyboardMessage();
-            input_device.sendMouseMessage();
-        }
-    }
+    scheduler.run();
 }
@@ -8,6 +8,21 @@
  **********************************************************************/
 
 #include "BLE_HID.hpp"
+#include <string.h>
+#include <stdlib.h>
+#include <utility/ATT.h>
+#include <utility/HCI.h>
+
+// Advertising parameters for HCI
+#define __ADV_DIRECT_IND_HIGH_DUTY 0x01
+#define __ADDRESS_PUBLIC 0x00
+#define __ADDRESS_RANDOM 0x01
+#define __ADV_ALL_CHANNELS 0x07
+
+// Length of an address as text, "aa:bb:cc:dd:ee:ff"
+#define __ADDRESS_TEXT_LEN 17
+
+BondStore* BLE_HID::_bond_store = nullptr;
 
 //-----------------------------------------------------------------------------------------------------------------
 BLE_HID::BLE_HID() :
@@ -16,9 +31,40 @@ BLE_HID::BLE_HID() :
     _hid_control_point("2A4C", BLEWriteWithoutResponse, 1, true),
     _keyboard_report("2A4D", BLERead | BLENotify, KEYBOARD_MESSAGE_LEN, true),
     _mouse_report("2A4D", BLERead | BLENotify, MOUSE_MESSAGE_LEN, true),
-    _key_report_message({0x01, 0, 0, 0, 0, 0, 0, 0, 0}),
-    _mouse_report_message({0x02, 0, 0, 0, 0}),
-    _curr_keyboard_button{0}
+    _connected{false},
+    _connection_handle{HCI_EVENT_TAP_NO_HANDLE},
+    _update_pending{false},
+    _curr_keyboard_button{0},
+    _keyboard_overflow{false},
+    _key_report_message{KEYBOARD_ID, 0, 0, 0, 0, 0, 0, 0, 0},
+    _mouse_report_message{MOUSE_ID, 0, 0, 0, 0},
+    _last_key_report_message{KEYBOARD_ID, 0, 0, 0, 0, 0, 0, 0, 0},
+    _last_mouse_report_message{MOUSE_ID, 0, 0, 0, 0},
+    _pending_mouse_x{0},
+    _pending_mouse_y{0},
+    _pending_mouse_wheel{0},
+    _last_mouse_report_time{0},
+    _pending_sample_time{0},
+    _pending_handoff_time{0},
+    _pending_time_set{false},
+    _min_report_interval_us{BLE_HID_MIN_REPORT_INTERVAL_US},
+    _sent_reports{0},
+    _suppressed_reports{0},
+    _coalesced_reports{0},
+    _directed_advertising{false},
+    _advertising_start{0},
+    _first_connection_time{0},
+    _first_report_time{0},
+    _profiles{{BLE_HID_ACTIVE_MIN_INTERVAL, BLE_HID_ACTIVE_MAX_INTERVAL, BLE_HID_ACTIVE_LATENCY, BLE_HID_ACTIVE_TIMEOUT},
+              {BLE_HID_IDLE_MIN_INTERVAL, BLE_HID_IDLE_MAX_INTERVAL, BLE_HID_IDLE_LATENCY, BLE_HID_IDLE_TIMEOUT}},
+    _connection_parameters{0, 0, 0, 0},
+    _negotiated_parameters{0, 0, 0, 0},
+    _negotiated{false},
+    _auto_profile{true},
+    _connection_profile{BLE_HID_PROFILE_NONE},
+    _profile_request_time{0},
+    _last_motion_time{0},
+    _connection_update_failures{0}
 { }
 
 //-----------------------------------------------------------------------------------------------------------------
@@ -47,11 +93,30 @@ void BLE_HID::initService(const char* device_name)
     _hid_report_map.writeValue(HID_REPORT_DESCRIPTOR, sizeof(HID_REPORT_DESCRIPTOR));
     _hid_control_point.writeValue((uint8_t)0x00);
 
-    BLE.advertise();
+    if(_bond_store)
+    {
+        BLE.setStoreLTK(__storeLTK);
+        BLE.setGetLTK(__getLTK);
+        BLE.setStoreIRK(__storeIRK);
+        BLE.setGetIRKs(__getIRKs);
+        BLE.setPairable(Pairable::YES);
+    }
+
+    // Ends up in the preferred connection parameters and is requested by the BLE stack right after connecting
+    BLE.setConnectionInterval(_profiles[BLE_HID_PROFILE_ACTIVE].min_interval,
+                              _profiles[BLE_HID_PROFILE_ACTIVE].max_interval);
+
+    __startAdvertising();
 
     Serial.println("Bluetooth device active, waiting for connections...");
 }
 
+//-----------------------------------------------------------------------------------------------------------------
+void BLE_HID::useBondStore(BondStore& store)
+{
+    _bond_store = &store;
+}
+
 //-----------------------------------------------------------------------------------------------------------------
 bool BLE_HID::checkRemoteAvailability(bool verbose)
 {
@@ -65,6 +130,8 @@ bool BLE_HID::checkRemoteAvailability(bool verbose)
         }
         return true;
     }
+    __updateConnection(false);
+    __updateAdvertising();
     return false;
 }
 
@@ -73,19 +140,42 @@ bool BLE_HID::checkRemoteConnection()
 {
     if (_remote_device)
     {
-        return _remote_device.connected();
+        return __updateConnection(_remote_device.connected());
     }
-    return false;
+    return __updateConnection(false);
 }
 
 //-----------------------------------------------------------------------------------------------------------------
 void BLE_HID::setKeyboardButtonPress(char button, uint8_t modifier)
 {
-    if(_curr_keyboard_button >= MAX_KEYBOARD_KEYS)
+    HIDKey key = asciiToKey(button);
+    if(key.keycode == KEY_NONE)
+        return;
+
+    setKeyPress(key.keycode, modifier | key.modifier);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void BLE_HID::setKeyPress(uint8_t keycode, uint8_t modifier)
+{
+    if(keycode == KEY_NONE || keycode > HID_KEYCODE_MAX)
         return;
 
     _key_report_message[KEYBOARD_FIELD_MODIFIER] |= modifier;
-    _key_report_message[KEYBOARD_FIELD_BUTTON + _curr_keyboard_button] = button - 93;
+
+    for(int i = 0; i < _curr_keyboard_button; i++)
+    {
+        if(_key_report_message[KEYBOARD_FIELD_BUTTON + i] == keycode)
+            return;
+    }
+
+    if(_curr_keyboard_button >= MAX_KEYBOARD_KEYS)
+    {
+        _keyboard_overflow = true;
+        return;
+    }
+
+    _key_report_message[KEYBOARD_FIELD_BUTTON + _curr_keyboard_button] = keycode;
     _curr_keyboard_button++;
 }
 
@@ -98,14 +188,39 @@ void BLE_HID::setMouseButtonPress(uint8_t button)
 //-----------------------------------------------------------------------------------------------------------------
 void BLE_HID::setMouseScroll(int8_t wheel)
 {
-    _mouse_report_message[MOUSE_FIELD_WHEEL] = wheel;
+    _pending_mouse_wheel = constrain(_pending_mouse_wheel + wheel, -BLE_HID_MAX_PENDING_MOVEMENT,
+                                     BLE_HID_MAX_PENDING_MOVEMENT);
 }
 
 //-----------------------------------------------------------------------------------------------------------------
 void BLE_HID::setMouseMove(int8_t x, int8_t y)
 {
-    _mouse_report_message[MOUSE_FIELD_X] = x;
-    _mouse_report_message[MOUSE_FIELD_Y] = y;
+    if(x != 0 || y != 0)
+        _last_motion_time = micros();
+
+    _pending_mouse_x = constrain(_pending_mouse_x + x, -BLE_HID_MAX_PENDING_MOVEMENT, BLE_HID_MAX_PENDING_MOVEMENT);
+    _pending_mouse_y = constrain(_pending_mouse_y + y, -BLE_HID_MAX_PENDING_MOVEMENT, BLE_HID_MAX_PENDING_MOVEMENT);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void BLE_HID::setMouseMove(int8_t x, int8_t y, uint32_t sample_time)
+{
+    setMouseMove(x, y);
+    if(x == 0 && y == 0)
+        return;
+
+    uint32_t now = micros();
+#ifdef ENABLE_LATENCY_TRACING
+    _handoff_latency.record(now - sample_time);
+#endif
+
+    // Movement added to a pending one is sent together with it, the oldest sample counts
+    if(!_pending_time_set)
+    {
+        _pending_sample_time = sample_time;
+        _pending_handoff_time = now;
+        _pending_time_set = true;
+    }
 }
 
 //-----------------------------------------------------------------------------------------------------------------
@@ -115,6 +230,7 @@ void BLE_HID::resetKeyboardMessage()
         _key_report_message[i] = 0;
     _key_report_message[0] = KEYBOARD_ID;
     _curr_keyboard_button = 0;
+    _keyboard_overflow = false;
 }
 
 //-----------------------------------------------------------------------------------------------------------------
@@ -123,36 +239,171 @@ void BLE_HID::resetMouseMessage()
     for(int i = 1; i < MOUSE_MESSAGE_LEN; i++)
         _mouse_report_message[i] = 0;
     _mouse_report_message[0] = MOUSE_ID;
+    _pending_mouse_x = 0;
+    _pending_mouse_y = 0;
+    _pending_mouse_wheel = 0;
+    _pending_time_set = false;
 }
 
 //-----------------------------------------------------------------------------------------------------------------
 void BLE_HID::sendKeyboardRelease()
 {
     uint8_t release_key_report_message[KEYBOARD_MESSAGE_LEN] = {KEYBOARD_ID, 0, 0, 0, 0, 0, 0, 0, 0};
-    _keyboard_report.writeValue(release_key_report_message, sizeof(release_key_report_message));
+    __writeReport(_keyboard_report, release_key_report_message, _last_key_report_message,
+                  sizeof(release_key_report_message));
 }
 
 //-----------------------------------------------------------------------------------------------------------------
 void BLE_HID::sendMouseRelease()
 {
     uint8_t release_mouse_report_message[MOUSE_MESSAGE_LEN] = {MOUSE_ID, 0, 0, 0, 0};
-    _mouse_report.writeValue(release_mouse_report_message, sizeof(release_mouse_report_message));
+    __writeReport(_mouse_report, release_mouse_report_message, _last_mouse_report_message,
+                  sizeof(release_mouse_report_message));
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool BLE_HID::queueMacro(const MacroStep steps[], uint16_t step_n)
+{
+    return _macros.queue(steps, step_n);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool BLE_HID::typeString(const char* text)
+{
+    uint16_t length = 0;
+    for(const char* c = text; *c != '\0'; c++)
+    {
+        if(asciiToKey(*c).keycode != KEY_NONE)
+            length++;
+    }
+
+    if(length > _macros.getFreeSteps())
+        return false;
+
+    for(const char* c = text; *c != '\0'; c++)
+    {
+        MacroStep step = macroHold(*c);
+        if(step.keycode != KEY_NONE)
+            _macros.queue(&step, 1);
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool BLE_HID::isMacroActive()
+{
+    return _macros.isActive();
 }
 
 //-----------------------------------------------------------------------------------------------------------------
 void BLE_HID::sendKeyboardMessage()
 {
-    _keyboard_report.writeValue(_key_report_message, sizeof(_key_report_message));
+    PROFILE_SCOPE(PROFILE_HID_KEYBOARD);
+
+    if(!__buildMacroReport())
+        __normalizeKeyReport();
+
+    if(memcmp(_key_report_message, _last_key_report_message, sizeof(_key_report_message)) == 0)
+        _suppressed_reports++;
+    else
+        __writeReport(_keyboard_report, _key_report_message, _last_key_report_message, sizeof(_key_report_message));
+
     resetKeyboardMessage();
 }
 
 //-----------------------------------------------------------------------------------------------------------------
 void BLE_HID::sendMouseMessage()
 {
-    _mouse_report.writeValue(_mouse_report_message, sizeof(_mouse_report_message));
-    resetMouseMessage();
+    PROFILE_SCOPE(PROFILE_HID_MOUSE);
+
+    bool has_movement = _pending_mouse_x != 0 || _pending_mouse_y != 0 || _pending_mouse_wheel != 0;
+    bool same_buttons = _mouse_report_message[MOUSE_FIELD_BUTTON] == _last_mouse_report_message[MOUSE_FIELD_BUTTON];
+
+    if(!has_movement && same_buttons)
+    {
+        _suppressed_reports++;
+        resetMouseMessage();
+        return;
+    }
+
+    // Keep everything for the next call, it is sent together with whatever is added until then
+    uint32_t now = micros();
+    if((uint32_t)(now - _last_mouse_report_time) <
+       _min_report_interval_us - _min_report_interval_us / BLE_HID_REPORT_EARLY_DIVISOR)
+    {
+        _coalesced_reports++;
+        return;
+    }
+
+    // The interval counts from the start of the write, so the time the write takes does not add to it
+    _last_mouse_report_time = now;
+    _mouse_report_message[MOUSE_FIELD_X] = __takeMovement(_pending_mouse_x);
+    _mouse_report_message[MOUSE_FIELD_Y] = __takeMovement(_pending_mouse_y);
+    _mouse_report_message[MOUSE_FIELD_WHEEL] = __takeMovement(_pending_mouse_wheel);
+    __writeReport(_mouse_report, _mouse_report_message, _last_mouse_report_message, sizeof(_mouse_report_message));
+
+    if(_pending_time_set)
+    {
+#ifdef ENABLE_LATENCY_TRACING
+        uint32_t sent_time = micros();
+        _report_latency.record(sent_time - _pending_sample_time);
+        _report_queue_delay.record(sent_time - _pending_handoff_time);
+#endif
+
+        // Movement left for the next report keeps its tag
+        if(_pending_mouse_x == 0 && _pending_mouse_y == 0)
+            _pending_time_set = false;
+    }
+
+    // Movement which did not fit into this report stays pending
+    for(int i = 1; i < MOUSE_MESSAGE_LEN; i++)
+        _mouse_report_message[i] = 0;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void BLE_HID::setMinReportInterval(uint32_t interval_us)
+{
+    _min_report_interval_us = interval_us;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint32_t BLE_HID::getSentReports()
+{
+    return _sent_reports;
 }
 
+//-----------------------------------------------------------------------------------------------------------------
+uint32_t BLE_HID::getSuppressedReports()
+{
+    return _suppressed_reports;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint32_t BLE_HID::getCoalescedReports()
+{
+    return _coalesced_reports;
+}
+
+#ifdef ENABLE_LATENCY_TRACING
+//-----------------------------------------------------------------------------------------------------------------
+LatencyStats& BLE_HID::getReportLatency()
+{
+    return _report_latency;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+LatencyStats& BLE_HID::getHandoffLatency()
+{
+    return _handoff_latency;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+LatencyStats& BLE_HID::getReportQueueDelay()
+{
+    return _report_queue_delay;
+}
+#endif
+
 //-----------------------------------------------------------------------------------------------------------------
 void BLE_HID::testRoutine()
 {
@@ -205,4 +456,371 @@ void BLE_HID::__debugPrintMessage(const char* name, uint8_t message[], uint8_t s
             Serial.print(" | ");
     }
     Serial.println("");
-}
\ No newline at end of file
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint32_t BLE_HID::getFirstConnectionTime()
+{
+    return _first_connection_time;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint32_t BLE_HID::getFirstReportTime()
+{
+    return _first_report_time;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool BLE_HID::isDirectedAdvertising()
+{
+    return _directed_advertising;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void BLE_HID::setConnectionProfile(uint8_t profile, const BLEConnectionParameters& parameters)
+{
+    if(profile >= BLE_HID_PROFILE_N)
+        return;
+
+    _profiles[profile] = parameters;
+
+    // Apply the new parameters with the next update
+    if(_connection_profile == profile)
+        _connection_profile = BLE_HID_PROFILE_NONE;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void BLE_HID::setAutoConnectionProfile(bool enabled)
+{
+    _auto_profile = enabled;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint8_t BLE_HID::getConnectionProfile()
+{
+    return _connection_profile;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool BLE_HID::getConnectionParameters(BLEConnectionParameters& parameters)
+{
+    if(!_connected || !_negotiated)
+        return false;
+
+    parameters = _negotiated_parameters;
+    return true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool BLE_HID::getRequestedConnectionParameters(BLEConnectionParameters& parameters)
+{
+    if(_connection_profile == BLE_HID_PROFILE_NONE)
+        return false;
+
+    parameters = _connection_parameters;
+    return true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint32_t BLE_HID::getConnectionUpdateFailures()
+{
+    return _connection_update_failures;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void BLE_HID::__writeReport(BLECharacteristic& characteristic, const uint8_t message[], uint8_t last_message[],
+                            uint8_t size)
+{
+    PROFILE_SCOPE(PROFILE_HID_WRITE);
+
+    characteristic.writeValue(message, size);
+    memcpy(last_message, message, size);
+    _sent_reports++;
+
+    // The releases sent while a connection is set up do not count, the device is usable with the first real report
+    if(_connected && _first_report_time == 0)
+        _first_report_time = micros();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+int8_t BLE_HID::__takeMovement(int16_t& pending)
+{
+    int16_t movement = constrain(pending, -127, 127);
+    pending -= movement;
+    return (int8_t)movement;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool BLE_HID::__updateConnection(bool connected)
+{
+    if(!connected && _connected)
+    {
+        _macros.reset();
+
+        // An update still outstanding ends with the connection
+        if(_update_pending)
+        {
+            HCI.noDebug();
+            _update_pending = false;
+        }
+        _connection_handle = HCI_EVENT_TAP_NO_HANDLE;
+        _negotiated = false;
+
+        // The host forgets the keys and buttons held with the connection. What is still held is sent again as a new
+        // press to the next host, nothing is compared against reports which went to the one that left.
+        resetKeyboardMessage();
+        resetMouseMessage();
+        for(int i = 1; i < KEYBOARD_MESSAGE_LEN; i++)
+            _last_key_report_message[i] = 0;
+        for(int i = 1; i < MOUSE_MESSAGE_LEN; i++)
+            _last_mouse_report_message[i] = 0;
+
+        __startAdvertising();
+    }
+
+    if(connected && !_connected)
+    {
+        _directed_advertising = false;
+        if(_first_connection_time == 0)
+            _first_connection_time = micros();
+
+        // The connection starts with whatever the host picked, a new host starts out active
+        _connection_profile = BLE_HID_PROFILE_NONE;
+        _profile_request_time = micros();
+        _last_motion_time = micros();
+
+        // The host may still hold keys from before a disconnect, start from a clean state
+        sendKeyboardRelease();
+        sendMouseRelease();
+        resetKeyboardMessage();
+        resetMouseMessage();
+    }
+    _connected = connected;
+    if(connected)
+    {
+        __finishConnectionUpdate();
+        __updateConnectionProfile();
+    }
+    return connected;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void BLE_HID::__startAdvertising()
+{
+    BLE.stopAdvertise();
+
+    // ArduinoBLE only advertises to everyone, so directed advertising is set up on the HCI directly. No advertising
+    // data is sent, the known host connects right away as soon as it receives the first packet.
+    uint8_t host[BOND_ADDRESS_LEN];
+    if(_bond_store && _bond_store->getLastHost(host) &&
+       HCI.leSetAdvertisingParameters(0, 0, __ADV_DIRECT_IND_HIGH_DUTY, __ADDRESS_PUBLIC, __ADDRESS_PUBLIC, host,
+                                      __ADV_ALL_CHANNELS, 0x00) == 0 &&
+       HCI.leSetAdvertiseEnable(0x01) == 0)
+    {
+        _directed_advertising = true;
+        _advertising_start = micros();
+        return;
+    }
+
+    _directed_advertising = false;
+    BLE.advertise();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void BLE_HID::__updateAdvertising()
+{
+    if(!_directed_advertising || micros() - _advertising_start < BLE_HID_DIRECTED_ADV_US)
+        return;
+
+    _directed_advertising = false;
+    BLE.stopAdvertise();
+    BLE.advertise();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void BLE_HID::__updateConnectionProfile()
+{
+    uint32_t now = micros();
+    uint8_t profile = BLE_HID_PROFILE_ACTIVE;
+    if(_auto_profile && now - _last_motion_time >= BLE_HID_IDLE_AFTER_US)
+        profile = BLE_HID_PROFILE_IDLE;
+
+    if(_update_pending || profile == _connection_profile || now - _profile_request_time < BLE_HID_PROFILE_HOLDOFF_US)
+        return;
+
+    __requestConnectionProfile(profile);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool BLE_HID::__requestConnectionProfile(uint8_t profile)
+{
+    const BLEConnectionParameters& parameters = _profiles[profile];
+
+    // The stack may not know the connection yet right after connecting, it is looked up again after the holdoff time
+    if(_connection_handle == HCI_EVENT_TAP_NO_HANDLE)
+        _connection_handle = __findConnectionHandle();
+    if(_connection_handle == HCI_EVENT_TAP_NO_HANDLE)
+    {
+        _profile_request_time = micros();
+        return false;
+    }
+
+    // The outcome is only reported in an HCI event, so the tap listens to the HCI from before the request until the
+    // update ended. The controller negotiates the update with the host on its own, a busy or rejecting controller is
+    // retried after the holdoff time.
+    _hci_events.expectUpdate(_connection_handle);
+    HCI.debug(_hci_events);
+    if(HCI.leConnUpdate(_connection_handle, parameters.min_interval, parameters.max_interval, parameters.latency,
+                        parameters.supervision_timeout) != 0)
+    {
+        HCI.noDebug();
+        _profile_request_time = micros();
+        _connection_update_failures++;
+        return false;
+    }
+
+    _update_pending = true;
+    _connection_profile = profile;
+    _connection_parameters = parameters;
+    return true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void BLE_HID::__finishConnectionUpdate()
+{
+    // The controller always ends an update with its complete event, unless the connection is lost first
+    if(!_update_pending || _hci_events.isPending())
+        return;
+
+    HCI.noDebug();
+    _update_pending = false;
+
+    // A rejected update leaves the connection as it was, the profile is requested again after the holdoff time
+    if(!_hci_events.isUpdated())
+    {
+        _connection_profile = BLE_HID_PROFILE_NONE;
+        _profile_request_time = micros();
+        _connection_update_failures++;
+        return;
+    }
+
+    _negotiated_parameters.min_interval = _hci_events.getConnectionInterval();
+    _negotiated_parameters.max_interval = _hci_events.getConnectionInterval();
+    _negotiated_parameters.latency = _hci_events.getConnectionLatency();
+    _negotiated_parameters.supervision_timeout = _hci_events.getSupervisionTimeout();
+    _negotiated = true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint16_t BLE_HID::__findConnectionHandle()
+{
+    // The address is printed most significant byte first, the stack keeps it the other way round. Its type is not
+    // exposed, so both are tried.
+    String text = _remote_device.address();
+    if(text.length() != __ADDRESS_TEXT_LEN)
+        return HCI_EVENT_TAP_NO_HANDLE;
+
+    uint8_t address[BOND_ADDRESS_LEN];
+    for(int i = 0; i < BOND_ADDRESS_LEN; i++)
+        address[BOND_ADDRESS_LEN - 1 - i] = (uint8_t)strtoul(&text.c_str()[3 * i], nullptr, 16);
+
+    uint16_t handle = ATT.connectionHandle(__ADDRESS_PUBLIC, address);
+    if(handle == HCI_EVENT_TAP_NO_HANDLE)
+        handle = ATT.connectionHandle(__ADDRESS_RANDOM, address);
+    return handle;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+int BLE_HID::__storeLTK(uint8_t* address, uint8_t* ltk)
+{
+    _bond_store->storeLTK(address, ltk);
+    return 1;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+int BLE_HID::__getLTK(uint8_t* address, uint8_t* ltk)
+{
+    return _bond_store->getLTK(address, ltk) ? 1 : 0;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+int BLE_HID::__storeIRK(uint8_t* address, uint8_t* irk)
+{
+    _bond_store->storeIRK(address, irk);
+    return 1;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+int BLE_HID::__getIRKs(uint8_t* irk_n, uint8_t** address_types, uint8_t*** addresses, uint8_t*** irks)
+{
+    // The BLE stack takes ownership of the arrays and deletes them after resolving an address
+    uint8_t count = 0;
+    for(uint8_t i = 0; i < _bond_store->getBondCount(); i++)
+    {
+        if(_bond_store->getBond(i)->flags & BOND_HAS_IRK)
+            count++;
+    }
+
+    *irk_n = count;
+    *address_types = new uint8_t[count];
+    *addresses = new uint8_t*[count];
+    *irks = new uint8_t*[count];
+
+    uint8_t irk = 0;
+    for(uint8_t i = 0; i < _bond_store->getBondCount(); i++)
+    {
+        const BondEntry* bond = _bond_store->getBond(i);
+        if(!(bond->flags & BOND_HAS_IRK))
+            continue;
+
+        (*address_types)[irk] = __ADDRESS_PUBLIC;
+        (*addresses)[irk] = new uint8_t[BOND_ADDRESS_LEN];
+        (*irks)[irk] = new uint8_t[BOND_KEY_LEN];
+        memcpy((*addresses)[irk], bond->address, BOND_ADDRESS_LEN);
+        memcpy((*irks)[irk], bond->irk, BOND_KEY_LEN);
+        irk++;
+    }
+    return 1;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void BLE_HID::__normalizeKeyReport()
+{
+    uint8_t* keys = &_key_report_message[KEYBOARD_FIELD_BUTTON];
+
+    if(_keyboard_overflow)
+    {
+        for(int i = 0; i < MAX_KEYBOARD_KEYS; i++)
+            keys[i] = KEY_ERROR_ROLLOVER;
+        return;
+    }
+
+    // Insertion sort of the used slots, the unused ones are 0 and stay at the end
+    for(int i = 1; i < _curr_keyboard_button; i++)
+    {
+        uint8_t key = keys[i];
+        int j = i - 1;
+        while(j >= 0 && keys[j] > key)
+        {
+            keys[j + 1] = keys[j];
+            j--;
+        }
+        keys[j + 1] = key;
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool BLE_HID::__buildMacroReport()
+{
+    if(!_macros.isActive())
+        return false;
+
+    _macros.tick(micros());
+
+    resetKeyboardMessage();
+    _key_report_message[KEYBOARD_FIELD_MODIFIER] = _macros.getModifier();
+    for(uint8_t i = 0; i < _macros.getHeldKeyCount(); i++)
+        setKeyPress(_macros.getHeldKey(i), MOD_NONE);
+    __normalizeKeyReport();
+    return true;
+}
@@ -9,6 +9,26 @@
 *   2. Define messages with functions upon desired events
 *   3. Send out report messages with dedicated functions
 *      (reports are cleared afterwards automatically)
+* Reports which would not change anything on the host are not sent.
+* The keyboard report describes the set of currently held keys, so a
+* held key is only sent once when pressed and once when released.
+* Mouse movement is added up and sent at most once per report
+* interval, so the radio is not flooded with tiny reports.
+* Macros and whole strings can be queued with queueMacro() and
+* typeString(). They are played back one step per keyboard report.
+* With a BondStore the keys of paired hosts survive a reset. After boot
+* and after every disconnect the device then first advertises directed
+* to the last host, so it reconnects without scanning or pairing again,
+* and falls back to normal advertising if that host does not show up.
+* The connection parameters follow the use of the device: while the
+* mouse moves the shortest connection interval is requested, after a
+* while without movement a slower profile which lets the radio skip
+* connection events takes over.
+* ArduinoBLE does not tell the connection handle or the parameters the
+* host settled on. The handle is looked up in its ATT layer by the
+* address of the central. The parameters are taken from the HCI event
+* which ends an update, the HCI is only listened to while an update is
+* outstanding (see HCIEventTap).
 * 
 * Author: Cyril Marx
 * Created: July 2024
@@ -19,16 +39,12 @@
 
 #include <Arduino.h>
 #include <ArduinoBLE.h>
-
-#define MOD_NONE 0x00
-#define MOD_LEFT_CTR 0x01
-#define MOD_LEFT_SHIFT 0x02
-#define MOD_LEFT_ALT 0x04
-#define MOD_LEFT_GUI 0x08
-#define MOD_RIGHT_CTR 0x10
-#define MOD_RIGHT_SHIFT 0x20
-#define MOD_RIGHT_ALT 0x40
-#define MOD_RIGHT_GUI 0x80
+#include "HIDKeycodes.hpp"
+#include "MacroSequencer.hpp"
+#include "Profiler.hpp"
+#include "LatencyStats.hpp"
+#include "BondStore.hpp"
+#include "HCIEventTap.hpp"
 
 #define MOUSE_LEFT 0x01
 #define MOUSE_RIGHT 0x02
@@ -57,6 +73,57 @@
 
 #define MAX_KEYBOARD_KEYS 6
 
+// Usage reported in all key slots if more keys are held than fit into a report
+#define KEY_ERROR_ROLLOVER 0x01
+
+// Mouse reports are sent at most about once per this interval, movement in between is added up
+#define BLE_HID_MIN_REPORT_INTERVAL_US 7500
+
+// A mouse report may go out up to 1/BLE_HID_REPORT_EARLY_DIVISOR of the interval early. The scheduler releases a
+// caller running at the report interval a little early now and then, which must not cost it a whole interval. Reports
+// never come closer than 3/4 of the interval.
+#define BLE_HID_REPORT_EARLY_DIVISOR 4
+
+// Movement which is not yet sent is capped at this many pixels per axis
+#define BLE_HID_MAX_PENDING_MOVEMENT 2048
+
+// High duty cycle directed advertising is stopped by the controller after this time
+#define BLE_HID_DIRECTED_ADV_US 1280000
+
+// Connection parameter profiles
+#define BLE_HID_PROFILE_ACTIVE 0
+#define BLE_HID_PROFILE_IDLE 1
+#define BLE_HID_PROFILE_N 2
+#define BLE_HID_PROFILE_NONE 0xFF
+
+// Active pointing: one report per connection event at the minimum report interval
+#define BLE_HID_ACTIVE_MIN_INTERVAL 6       // 7.5ms
+#define BLE_HID_ACTIVE_MAX_INTERVAL 12      // 15ms
+#define BLE_HID_ACTIVE_LATENCY 0
+#define BLE_HID_ACTIVE_TIMEOUT 200          // 2s
+
+// Idle typing: key presses are still sent on the next event, only the events without data are skipped
+#define BLE_HID_IDLE_MIN_INTERVAL 12        // 15ms
+#define BLE_HID_IDLE_MAX_INTERVAL 24        // 30ms
+#define BLE_HID_IDLE_LATENCY 4
+#define BLE_HID_IDLE_TIMEOUT 400            // 4s
+
+// Time without mouse movement until the idle profile is requested
+#define BLE_HID_IDLE_AFTER_US 2000000
+
+// Time after connecting or after a failed request until parameters are requested (again). Gives the host time to
+// discover the services first.
+#define BLE_HID_PROFILE_HOLDOFF_US 1000000
+
+// Connection parameters in the units of the controller
+struct BLEConnectionParameters
+{
+    uint16_t min_interval;          // In 1.25ms
+    uint16_t max_interval;          // In 1.25ms
+    uint16_t latency;               // Number of connection events the device may skip if it has nothing to send
+    uint16_t supervision_timeout;   // In 10ms, has to exceed (1 + latency) * max_interval * 2
+};
+
 //The descriptor for the human interface device. Needed to format messages, and
 // how the host device should interpret the incoming messages.
 //
@@ -89,10 +156,10 @@ const uint8_t HID_REPORT_DESCRIPTOR[] = {
     0x95, 0x06,        // Report Count (6)
     0x75, 0x08,        // Report Size (8)
     0x15, 0x00,        // Logical Minimum (0)
-    0x25, 0x65,        // Logical Maximum (101)
+    0x25, HID_KEYCODE_MAX, // Logical Maximum (101)
     0x05, 0x07,        // Usage Page (Key codes)
     0x19, 0x00,        // Usage Minimum (0)
-    0x29, 0x65,        // Usage Maximum (101)
+    0x29, HID_KEYCODE_MAX, // Usage Maximum (101)
     0x81, 0x00,        // Input (Data, Array) Key array(6 bytes)
     0xC0,              // End Collection (Application)
 
@@ -139,12 +206,22 @@ class BLE_HID
     //-----------------------------------------------------------------------------------------------------------------
     ///
     /// Initializes the BLE service. Sets the device name, setups all subsystems and advertises the service
-    /// at the end.
+    /// at the end. Advertises directed to the last host first if a bond store is used (see useBondStore()).
     ///
     /// @param  device_name         The name the device should be advertised as.
     //
     void initService(const char* device_name);
 
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Persists the keys of paired hosts in the given store and reconnects to the last host with directed advertising.
+    /// Must be called before initService(), the store must be loaded with BondStore::begin() already. Writing the
+    /// store to flash is left to the caller (BondStore::commit()).
+    ///
+    /// @param store        The store to keep the bonds in.
+    //
+    void useBondStore(BondStore& store);
+
     //-----------------------------------------------------------------------------------------------------------------
     ///
     /// Checks if a remote device exists yet.
@@ -158,7 +235,8 @@ class BLE_HID
     //-----------------------------------------------------------------------------------------------------------------
     ///
     /// Checks if a remote device is connected. Needs to be checked regularly in the main loop to allow a connection to
-    /// happen.
+    /// happen. On every new connection all keys and mouse buttons are released first, so no key stays stuck from before
+    /// a disconnect.
     ///
     /// @return True if a remote device is connected.
     //
@@ -166,17 +244,66 @@ class BLE_HID
 
     //-----------------------------------------------------------------------------------------------------------------
     ///
-    /// Adds a new keyboard button to press to the buffer. If called consequtively it can store up to 6 buttons. Afterwards
-    /// the call is ignored. Either sendKeyboardMessage() or resetKeyboardMessage() need to be called to allow for new buttons
-    /// to be pressed again.
+    /// Adds a new keyboard button to the set of held buttons. Call it for every held button before each
+    /// sendKeyboardMessage(), buttons which are not added anymore are released. Adding a button twice has no effect.
+    /// If more than 6 buttons are held at once, the report signals a rollover error to the host instead of dropping
+    /// buttons silently.
     /// Does not yet send the instruction to the remote device. Call sendKeyboardMessage() afterwards to do so.
     ///
-    /// @param button       The button which should be pressed as a char.
+    /// @param button       The button which should be pressed as a char. Upper case letters and shifted symbols add
+    ///                     MOD_LEFT_SHIFT on their own. Characters without a key are ignored.
     /// @param modifier     The modifier which is used (alt, ctr, shift). If multiple should be used, just or them together
-    ///                     (see macros above).
+    ///                     (see HIDKeycodes.hpp).
     //
     void setKeyboardButtonPress(char button, uint8_t modifier);
 
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Same as setKeyboardButtonPress() but takes the usage ID of the key, so keys without a character (arrows, F-keys,
+    /// ...) can be pressed as well.
+    ///
+    /// @param keycode      The usage ID of the key (see KEY_ macros in HIDKeycodes.hpp). Usage IDs beyond
+    ///                     HID_KEYCODE_MAX are ignored.
+    /// @param modifier     The modifier which is used.
+    //
+    void setKeyPress(uint8_t keycode, uint8_t modifier);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Queues a macro to be played back. Every sendKeyboardMessage() executes at most one step of it, so the macro
+    /// runs without blocking while the rest of the loop goes on. While a macro runs, its keys replace the held
+    /// buttons in the reports.
+    ///
+    /// @param steps        The steps of the macro (see MacroSequencer.hpp).
+    /// @param step_n       The number of steps.
+    ///
+    /// @return False if the queue has not enough space left, nothing is queued in that case.
+    //
+    bool queueMacro(const MacroStep steps[], uint16_t step_n);
+
+    template<uint16_t N>
+    bool queueMacro(const MacroStep (&steps)[N])
+    {
+        return queueMacro(steps, N);
+    }
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Queues a string to be typed as a macro. Every character is pressed in one keyboard report and released in the
+    /// next.
+    ///
+    /// @param text         The string to type. Characters without a key are skipped.
+    ///
+    /// @return False if the queue has not enough space left, nothing is queued in that case.
+    //
+    bool typeString(const char* text);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns true as long as a queued macro or string is not fully played back.
+    //
+    bool isMacroActive();
+
     //-----------------------------------------------------------------------------------------------------------------
     ///
     /// Adds a mouse button to be pressed to the buffer.
@@ -189,7 +316,7 @@ class BLE_HID
     //-----------------------------------------------------------------------------------------------------------------
     ///
     /// Adds a mouse wheel command (see macros above) to the buffer. Can scroll up or down depending on the sign of the wheel
-    /// parameter.
+    /// parameter. Consecutive calls add up the scrolling until it is sent, like the movement.
     /// Does not yet send the instruction to the remote device. Call sendMouseMessage() afterwards to do so.
     ///
     /// @param wheel       The strength and direction of the scroll wheel.
@@ -198,7 +325,7 @@ class BLE_HID
 
     //-----------------------------------------------------------------------------------------------------------------
     ///
-    /// Adds a mouse move command to the buffer.
+    /// Adds a mouse move command to the buffer. Consecutive calls add up the movement until it is sent.
     /// Does not yet send the instruction to the remote device. Call sendMouseMessage() afterwards to do so.
     ///
     /// @param x       The movement strenght on the x axis in pixels.
@@ -206,6 +333,17 @@ class BLE_HID
     //
     void setMouseMove(int8_t x, int8_t y);
 
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Same as setMouseMove() but tags the movement with the acquisition time of the oldest sensor sample it stems from.
+    /// Once the movement is sent, the latency from that sample to the report is recorded (see getReportLatency()).
+    ///
+    /// @param x            The movement strenght on the x axis in pixels.
+    /// @param y            The movement strenght on the y axis in pixels.
+    /// @param sample_time  The acquisition time of the sample in microseconds.
+    //
+    void setMouseMove(int8_t x, int8_t y, uint32_t sample_time);
+
     //-----------------------------------------------------------------------------------------------------------------
     ///
     /// Resets the keyboard message buffer and clears all commands out of it.
@@ -215,7 +353,7 @@ class BLE_HID
 
     //-----------------------------------------------------------------------------------------------------------------
     ///
-    /// Resets the mouse message buffer and clears all commands out of it.
+    /// Resets the mouse message buffer and clears all commands out of it, including movement not sent yet.
     /// Does not yet send the instruction to the remote device. Call sendMouseMessage() afterwards to do so.
     //
     void resetMouseMessage();
@@ -237,15 +375,146 @@ class BLE_HID
     //-----------------------------------------------------------------------------------------------------------------
     ///
     /// Sends the previously defined keyboard message buffer to the remote device. Automatically clears the buffer afterwards.
+    /// The held buttons are sorted, so the same set of buttons always results in the same report. The report is skipped
+    /// if it is identical to the last keyboard report sent, so only presses and releases are sent.
     //
     void sendKeyboardMessage();
 
     //-----------------------------------------------------------------------------------------------------------------
     ///
     /// Sends the previously defined mouse message buffer to the remote device. Automatically clears the buffer afterwards.
+    /// If the last mouse report was sent less than the minimum report interval ago, nothing is sent and the buffer is
+    /// kept, so the movement is sent together with the next one. A quarter of the interval is tolerated, so a caller
+    /// running at the interval itself gets every slot despite its jitter. Movement beyond the range of one report is kept for the
+    /// next report. Reports without movement are skipped if they are identical to the last mouse report sent.
     //
     void sendMouseMessage();
 
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Sets the minimum time between two mouse reports.
+    ///
+    /// @param interval_us  The interval in microseconds. 0 sends every report right away.
+    //
+    void setMinReportInterval(uint32_t interval_us);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns how many reports (keyboard and mouse) were sent to the remote device.
+    //
+    uint32_t getSentReports();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns how many reports were skipped because they would not have changed anything on the host.
+    //
+    uint32_t getSuppressedReports();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns how many mouse reports were merged into a later report because of the minimum report interval.
+    //
+    uint32_t getCoalescedReports();
+
+#ifdef ENABLE_LATENCY_TRACING
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the latency from the acquisition of a sample until its movement is sent in a mouse report.
+    //
+    LatencyStats& getReportLatency();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the latency from the acquisition of a sample until its movement is handed to setMouseMove(). Covers the
+    /// processing of the sample and the wait for the next report to be built.
+    //
+    LatencyStats& getHandoffLatency();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the time tagged movement waits in the mouse buffer until it is sent, e.g. because of the minimum report
+    /// interval.
+    //
+    LatencyStats& getReportQueueDelay();
+#endif
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns when the first remote device connected.
+    ///
+    /// @return The time since boot in microseconds, 0 if no device connected yet.
+    //
+    uint32_t getFirstConnectionTime();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns when the first report was sent to a connected device, which is the time from boot until the device is
+    /// usable.
+    ///
+    /// @return The time since boot in microseconds, 0 if no report was sent yet.
+    //
+    uint32_t getFirstReportTime();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns true while the device advertises directed to the last host.
+    //
+    bool isDirectedAdvertising();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Sets the connection parameters of a profile. The active profile is also requested right when a host connects,
+    /// so it has to be set before initService() to take effect there.
+    ///
+    /// @param profile      BLE_HID_PROFILE_ACTIVE or BLE_HID_PROFILE_IDLE.
+    /// @param parameters   The parameters to request.
+    //
+    void setConnectionProfile(uint8_t profile, const BLEConnectionParameters& parameters);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Enables or disables switching the connection parameters with the mouse movement. Enabled by default. While
+    /// disabled the active profile is kept.
+    //
+    void setAutoConnectionProfile(bool enabled);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the profile the connection currently runs with.
+    ///
+    /// @return The profile or BLE_HID_PROFILE_NONE if no profile was applied yet on this connection.
+    //
+    uint8_t getConnectionProfile();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the parameters the connection runs with since the last completed update, as reported by the
+    /// controller. The interval is the one the host picked, so minimum and maximum interval are the same.
+    ///
+    /// @param parameters   Where to store the parameters.
+    ///
+    /// @return False if no device is connected or no update completed on this connection yet. The parameters the
+    ///         host picks when connecting are not known.
+    //
+    bool getConnectionParameters(BLEConnectionParameters& parameters);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the connection parameters of the last update the controller accepted. The host picks the final
+    /// interval from the requested range, see getConnectionParameters().
+    ///
+    /// @param parameters   Where to store the parameters.
+    ///
+    /// @return False if no parameters were accepted on this connection yet.
+    //
+    bool getRequestedConnectionParameters(BLEConnectionParameters& parameters);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns how often a connection parameter update was rejected by the controller or did not complete.
+    //
+    uint32_t getConnectionUpdateFailures();
+
     //-----------------------------------------------------------------------------------------------------------------
     ///
     /// A test routine to quickly check if the system works in general. Captures the whole main loop of the program.
@@ -265,13 +534,155 @@ class BLE_HID
     BLECharacteristic _keyboard_report;
     BLECharacteristic _mouse_report;
     BLEDevice _remote_device;
+    bool _connected;
+    uint16_t _connection_handle;
+    HCIEventTap _hci_events;
+    bool _update_pending;
 
     uint8_t _curr_keyboard_button;
+    bool _keyboard_overflow;
+
+    MacroSequencer _macros;
 
     uint8_t _key_report_message[KEYBOARD_MESSAGE_LEN];
     uint8_t _mouse_report_message[MOUSE_MESSAGE_LEN];
+    uint8_t _last_key_report_message[KEYBOARD_MESSAGE_LEN];
+    uint8_t _last_mouse_report_message[MOUSE_MESSAGE_LEN];
+
+    int16_t _pending_mouse_x;
+    int16_t _pending_mouse_y;
+    int16_t _pending_mouse_wheel;
+    uint32_t _last_mouse_report_time;
+    uint32_t _pending_sample_time;
+    uint32_t _pending_handoff_time;
+    bool _pending_time_set;
+    uint32_t _min_report_interval_us;
+
+    uint32_t _sent_reports;
+    uint32_t _suppressed_reports;
+    uint32_t _coalesced_reports;
+
+#ifdef ENABLE_LATENCY_TRACING
+    LatencyStats _report_latency;
+    LatencyStats _handoff_latency;
+    LatencyStats _report_queue_delay;
+#endif
+
+    static BondStore* _bond_store;
+    bool _directed_advertising;
+    uint32_t _advertising_start;
+    uint32_t _first_connection_time;
+    uint32_t _first_report_time;
+
+    BLEConnectionParameters _profiles[BLE_HID_PROFILE_N];
+    BLEConnectionParameters _connection_parameters;
+    BLEConnectionParameters _negotiated_parameters;
+    bool _negotiated;
+    bool _auto_profile;
+    uint8_t _connection_profile;
+    uint32_t _profile_request_time;
+    uint32_t _last_motion_time;
+    uint32_t _connection_update_failures;
 
     void __debugPrintMessage(const char* name, uint8_t message[], uint8_t size);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Tracks connection changes. Forgets the reports sent to a lost device and releases everything on a new one.
+    ///
+    /// @param connected        True if a remote device is connected right now.
+    ///
+    /// @return The given connection state.
+    //
+    bool __updateConnection(bool connected);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Starts advertising. Advertises directed to the last host if a bond is known, otherwise to everyone.
+    //
+    void __startAdvertising();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Falls back to advertising to everyone once directed advertising timed out.
+    //
+    void __updateAdvertising();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Requests the profile which fits the recent mouse movement, if it is not applied already.
+    //
+    void __updateConnectionProfile();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Asks the controller to update the parameters of the connection to a profile.
+    ///
+    /// @param profile      The profile to apply.
+    ///
+    /// @return True if the controller accepted the request.
+    //
+    bool __requestConnectionProfile(uint8_t profile);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Detaches the HCI tap once the outstanding update ended and takes over the parameters it ended with.
+    //
+    void __finishConnectionUpdate();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Looks up the handle of the connection to the remote device in the ATT layer of ArduinoBLE.
+    ///
+    /// @return The handle or HCI_EVENT_TAP_NO_HANDLE if the connection is not known (yet).
+    //
+    uint16_t __findConnectionHandle();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Callbacks of the BLE stack to store and look up the keys of paired hosts (see BondStore).
+    //
+    static int __storeLTK(uint8_t* address, uint8_t* ltk);
+    static int __getLTK(uint8_t* address, uint8_t* ltk);
+    static int __storeIRK(uint8_t* address, uint8_t* irk);
+    static int __getIRKs(uint8_t* irk_n, uint8_t** address_types, uint8_t*** addresses, uint8_t*** irks);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Brings the key slots of the keyboard report into a canonical form: sorted ascending, empty slots at the end, or
+    /// all slots set to KEY_ERROR_ROLLOVER if too many keys are held.
+    //
+    void __normalizeKeyReport();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Advances the macro playback and replaces the keyboard report with the keys held by the macro.
+    ///
+    /// @return False if no macro is running, the report is untouched then.
+    //
+    bool __buildMacroReport();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Writes a report to its characteristic and remembers it as the last report sent.
+    ///
+    /// @param characteristic   The characteristic to write to.
+    /// @param message          The report to send.
+    /// @param last_message     The buffer holding the last report sent on this characteristic.
+    /// @param size             The length of the report.
+    //
+    void __writeReport(BLECharacteristic& characteristic, const uint8_t message[], uint8_t last_message[],
+                       uint8_t size);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Takes as much of the pending movement of one axis as fits into one report.
+    ///
+    /// @param pending          The pending movement of the axis. The part taken is subtracted.
+    ///
+    /// @return The movement for the report.
+    //
+    int8_t __takeMovement(int16_t& pending);
 };
 
 #endif // BLE_HID_HPP
\ No newline at end of file
@@ -9,46 +9,362 @@
 
 #include "BMI160.hpp"
 
+// Stages of an ongoing sensor read
+#define __READ_IDLE 0
+#define __READ_OUTPUT 1
+#define __READ_FIFO_LENGTH 2
+#define __READ_FIFO_DATA 3
+
+// Power modes in the PMU status register
+#define __PMU_ACC_SHIFT 4
+#define __PMU_GYR_SHIFT 2
+#define __PMU_NORMAL 0b01
+
+// Fatal error bit and error code in the error register
+#define __ERROR_MASK 0x1F
+
+// Full scale of the accelerometer, the range in g is spread over it
+#define __ACC_LSB_PER_RANGE 32768.0
+
+// Memory the processing chain may take: the windows of its grounding and smoothing stages and one previous sample
+#define __CHAIN_SIZE_MAX ((3 + 6) * (SMOOTH_WINDOW_N + 2) * sizeof(float) + 12 * sizeof(float))
+
+// The members of BMI160 in their order. Its size is the exact size the object has to have, so any state added to the
+// class, e.g. a history of samples again, breaks the check below until it is accounted for here.
+struct __BMI160Members
+{
+    I2CTransfer transfer;
+    uint8_t transfer_buffer[BMI160_FIFO_BATCH_N * BMI160_FIFO_FRAME_LEN];
+    uint8_t read_stage;
+    BMI160SampleCallback sample_callback;
+    SPSCRing<uint32_t, BMI160_SAMPLE_RING_N> sample_times;
+    uint32_t isr_overflows;
+    uint32_t dropped_samples;
+    bool interrupt_enabled;
+    bool fifo_enabled;
+    BMI160Config config;
+    float acc_scale;
+    float gyr_scale;
+    uint32_t startup_time;
+    int16_t raw_data[6];
+    uint32_t timestamp;
+    uint8_t filter_mode;
+    BMI160ProcessingChain chain;
+    BMI160OneEuroChain one_euro_chain;
+#ifdef ENABLE_LATENCY_TRACING
+    LatencyStats processing_latency;
+#endif
+    float final_data[6];
+    float grad_data[6];
+};
+
+static_assert(sizeof(BMI160ProcessingChain) <= __CHAIN_SIZE_MAX, "Processing chain keeps more than its windows");
+static_assert(sizeof(BMI160) == sizeof(__BMI160Members), "BMI160 keeps more than its streaming state");
+
+BMI160* BMI160::_isr_instance = nullptr;
+
 //-----------------------------------------------------------------------------------------------------------------
 BMI160::BMI160() :
-_curr_n{0}
-{ }
+_transfer{BMI160_ADDRESS},
+_read_stage{__READ_IDLE},
+_sample_callback{nullptr},
+_isr_overflows{0},
+_dropped_samples{0},
+_interrupt_enabled{false},
+_fifo_enabled{false},
+_config{BMI160_DEFAULT_CONFIG},
+_acc_scale{(float)(__accRangeToG(BMI160_DEFAULT_CONFIG.acc_range) / __ACC_LSB_PER_RANGE)},
+_gyr_scale{(float)BMI160_GYR_SCALE_2000DPS},
+_startup_time{0},
+_timestamp{0},
+_filter_mode{BMI160_FILTER_CHAIN}
+{
+    for(int i = 0; i < 6; i++)
+    {
+        _raw_data[i] = 0;
+        _final_data[i] = 0.0f;
+        _grad_data[i] = 0.0f;
+    }
+    _transfer.setTimeout(BMI160_READ_TIMEOUT_US);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool BMI160::configureBMI160()
+{
+    return configureBMI160(BMI160_DEFAULT_CONFIG);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool BMI160::configureBMI160(const BMI160Config& config)
+{
+    uint32_t start = micros();
+
+    // The module drops commands sent while a power mode change is still running, so each one is awaited
+    bool success = __setNormalMode(__BMI160_CMD_ACC_NORMAL, __PMU_ACC_SHIFT) &&
+                   __setNormalMode(__BMI160_CMD_GYR_NORMAL, __PMU_GYR_SHIFT) &&
+                   setConfig(config);
+
+    _startup_time = micros() - start;
+    return success;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool BMI160::setConfig(const BMI160Config& config)
+{
+    // The registers are written with blocking bus transfers, which must not interleave with a running read
+    if(_read_stage != __READ_IDLE || !__isValidConfig(config))
+        return false;
+
+    // Writes need no delay in normal mode, the bus transfer itself is longer than the required idle time
+    bool verified = __writeVerified(__BMI160_ACC_CONF, (config.acc_bandwidth << 4) | config.acc_odr);
+    verified &= __writeVerified(__BMI160_ACC_RANGE, config.acc_range);
+    verified &= __writeVerified(__BMI160_GYR_CONF, (config.gyr_bandwidth << 4) | config.gyr_odr);
+    verified &= __writeVerified(__BMI160_GYR_RANGE, config.gyr_range);
+    verified &= (__read8(__BMI160_ERROR) & __ERROR_MASK) == 0;
+
+    // Frames still buffered were sampled with the old configuration
+    if(_fifo_enabled)
+        __writeRegister(__BMI160_CMD, __BMI160_CMD_FIFO_FLUSH);
+
+    if(!verified)
+        return false;
+
+    _config = config;
+    _acc_scale = (float)(__accRangeToG(config.acc_range) / __ACC_LSB_PER_RANGE);
+    _gyr_scale = (float)(BMI160_GYR_SCALE_2000DPS * __gyrRangeToDps(config.gyr_range) / 2000.0);
+
+    float rate = getSampleRate();
+    _chain.setSampleRate(rate);
+    _one_euro_chain.setSampleRate(rate);
+    return true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+BMI160Config BMI160::getConfig()
+{
+    return _config;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+float BMI160::getSampleRate()
+{
+    return __odrToHz(_config.gyr_odr);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint8_t BMI160::getAccelerometerRange()
+{
+    return __accRangeToG(_config.acc_range);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint16_t BMI160::getGyroscopeRange()
+{
+    return __gyrRangeToDps(_config.gyr_range);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint32_t BMI160::getStartupTime()
+{
+    return _startup_time;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool BMI160::enableFifo()
+{
+  if(_config.acc_odr != _config.gyr_odr || _config.gyr_odr > BMI160_MAX_ODR_FIFO)
+    return false;
+
+  __writeRegister(__BMI160_FIFO_CONFIG_1, 0b11000000);  // Store gyroscope and accelerometer data without headers
+  __writeRegister(__BMI160_CMD, __BMI160_CMD_FIFO_FLUSH);  // Flush stale frames
+  _fifo_enabled = true;
+  return true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool BMI160::disableFifo()
+{
+  if(_config.acc_odr > BMI160_MAX_ODR_DIRECT || _config.gyr_odr > BMI160_MAX_ODR_DIRECT)
+    return false;
+
+  __writeRegister(__BMI160_FIFO_CONFIG_1, 0b00000000);
+  _fifo_enabled = false;
+  return true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void BMI160::enableDataReadyInterrupt(uint8_t pin)
+{
+  __writeRegister(__BMI160_INT_OUT_CTRL, 0b00001010);  // Enable INT1 output as active high push-pull
+  __writeRegister(__BMI160_INT_MAP_1, 0b10000000);  // Map data ready interrupt to INT1
+  __writeRegister(__BMI160_INT_EN_1, 0b00010000);  // Enable data ready interrupt
+
+  _isr_instance = this;
+  _interrupt_enabled = true;
+  pinMode(pin, INPUT);
+  attachInterrupt(digitalPinToInterrupt(pin), __dataReadyISR, RISING);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void BMI160::setFilterMode(uint8_t mode)
+{
+    _filter_mode = mode;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint8_t BMI160::getFilterMode()
+{
+    return _filter_mode;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint8_t BMI160::fetchSensorData()
+{
+    startSensorRead();
+
+    int8_t samples;
+    while((samples = pollSensorRead()) == BMI160_READ_BUSY);
+    return samples;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool BMI160::startSensorRead()
+{
+    if(_read_stage != __READ_IDLE)
+        return false;
+
+    // Nothing new to read yet
+    if(_interrupt_enabled && _sample_times.empty())
+        return false;
+
+    if(_fifo_enabled)
+    {
+        _read_stage = __READ_FIFO_LENGTH;
+        return _transfer.start(__BMI160_FIFO_LENGTH, _transfer_buffer, 2);
+    }
+
+    _read_stage = __READ_OUTPUT;
+    return _transfer.start(__BMI160_OUTPUT_REG, _transfer_buffer, BMI160_OUTPUT_LEN);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+int8_t BMI160::pollSensorRead()
+{
+    if(_read_stage == __READ_IDLE)
+        return 0;
+
+    uint8_t state;
+    {
+        PROFILE_SCOPE(PROFILE_BMI160_TRANSFER);
+        state = _transfer.poll();
+    }
+    if(state == I2C_TRANSFER_BUSY)
+        return BMI160_READ_BUSY;
+
+    if(state == I2C_TRANSFER_ERROR)
+    {
+        _read_stage = __READ_IDLE;
+        return 0;
+    }
+
+    int8_t samples = 0;
+    switch(_read_stage)
+    {
+        case __READ_OUTPUT:
+            __decodeOutputData(_transfer_buffer, _raw_data);
+            __processSample(__takeSampleTime(true));
+            samples = 1;
+            break;
+
+        case __READ_FIFO_LENGTH:
+        {
+            uint16_t frames = __getFifoFrames(_transfer_buffer);
+            if(frames == 0)
+                break;
+
+            _read_stage = __READ_FIFO_DATA;
+            _transfer.start(__BMI160_FIFO_DATA, _transfer_buffer, frames * BMI160_FIFO_FRAME_LEN);
+            return BMI160_READ_BUSY;
+        }
+
+        case __READ_FIFO_DATA:
+            samples = _transfer.getReceived() / BMI160_FIFO_FRAME_LEN;
+            for(int8_t frame = 0; frame < samples; frame++)
+            {
+                __decodeFifoFrame(&_transfer_buffer[frame * BMI160_FIFO_FRAME_LEN], _raw_data);
+                __processSample(__takeSampleTime(false));
+            }
+            break;
+    }
+
+    _read_stage = __READ_IDLE;
+    return samples;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void BMI160::setReadTimeout(uint32_t timeout_us)
+{
+    _transfer.setTimeout(timeout_us);
+}
 
 //-----------------------------------------------------------------------------------------------------------------
-void BMI160::configureBMI160()
+uint32_t BMI160::getReadErrorCount(uint8_t error)
 {
-  __writeRegister(__BMI160_CMD, 0x11);  // Set accelerometer to normal mode
-  delay(10);
-  __writeRegister(__BMI160_ACC_RANGE, 0b00000011);  // Set accelerometer range to 2G
-  delay(10);
-  __writeRegister(__BMI160_ACC_CONF, 0b00101000);  // Set accelerometer output data rate to 100Hz
-  delay(10);
+    return _transfer.getErrorCount(error);
+}
 
-  __writeRegister(__BMI160_CMD, 0x15);  // Set gyroscope to normal mode
-  delay(10);
-  __writeRegister(__BMI160_GYR_RANGE, 0b00000000);  // Set gyroscope range to 2000 degree/s 
-  delay(10);
-  __writeRegister(__BMI160_GYR_CONF, 0b00101000);  // Set gyroscope output data rate to 100Hz
-  delay(10);
+//-----------------------------------------------------------------------------------------------------------------
+void BMI160::setSampleCallback(BMI160SampleCallback callback)
+{
+    _sample_callback = callback;
 }
 
 //-----------------------------------------------------------------------------------------------------------------
-void BMI160::fetchSensorData()
+void BMI160::__dataReadyISR()
 {
-    int8_t prev_n = __getPrevN(_curr_n);
+    if(!_isr_instance->_sample_times.push(micros()))
+        _isr_instance->_isr_overflows++;
+}
 
-    __readOutputData(_raw_data[_curr_n]);
-    __normalizeData(_raw_data[_curr_n], _filtered_data[_curr_n]);
-    __filterData(_filtered_data[_curr_n], _filtered_data[prev_n], _filtered_data[_curr_n],
-                 (float)ALPHA_HIGH, (float)ALPHA_LOW);
-    __sqrRootData(_filtered_data[_curr_n], _filtered_data[_curr_n]);
+//-----------------------------------------------------------------------------------------------------------------
+uint32_t BMI160::__takeSampleTime(bool newest_only)
+{
+    uint32_t timestamp = micros();
+    if(!_interrupt_enabled)
+        return timestamp;
 
-    __groundData(_filtered_data, _grounded_data[_curr_n]);
-    __smoothData(_grounded_data, _final_data[_curr_n]);
+    if(!_sample_times.pop(timestamp))
+        return micros();
 
-    __computeGradient(_final_data[_curr_n], _final_data[prev_n], _grad_data[_curr_n]);
+    if(newest_only)
+    {
+        while(_sample_times.pop(timestamp))
+            _dropped_samples++;
+    }
+    return timestamp;
+}
 
-    _curr_n = __getNextN(_curr_n);
+//-----------------------------------------------------------------------------------------------------------------
+void BMI160::__processSample(uint32_t timestamp)
+{
+    float prev_final_data[6];
+    for(int i = 0; i < 6; i++)
+        prev_final_data[i] = _final_data[i];
+
+    _timestamp = timestamp;
+    __normalizeData(_raw_data, _final_data);
+    if(_filter_mode == BMI160_FILTER_ONE_EURO)
+        _one_euro_chain.process(_final_data);
+    else
+        _chain.process(_final_data);
+
+    __computeGradient(_final_data, prev_final_data, _grad_data);
+#ifdef ENABLE_LATENCY_TRACING
+    _processing_latency.record(micros() - timestamp);
+#endif
+
+    if(_sample_callback)
+        _sample_callback(_raw_data);
 }
 
 //-----------------------------------------------------------------------------------------------------------------
@@ -81,25 +397,50 @@ int16_t BMI160::readMetaData(uint8_t api_reg)
 //-----------------------------------------------------------------------------------------------------------------
 void BMI160::getRawData(float output[6])
 {
-    int8_t fetched_data = __getPrevN(_curr_n);
     for(int i = 0; i < 6; i++)
-        output[i] = _raw_data[fetched_data][i];
+        output[i] = _raw_data[i];
 }
 
 //-----------------------------------------------------------------------------------------------------------------
 void BMI160::getProcessedData(float output[6])
 {
-    int8_t fetched_data = __getPrevN(_curr_n);
     for(int i = 0; i < 6; i++)
-        output[i] = _final_data[fetched_data][i];
+        output[i] = _final_data[i];
 }
 
 //-----------------------------------------------------------------------------------------------------------------
 void BMI160::getGradientData(float output[6])
 {
-    int8_t fetched_data = __getPrevN(_curr_n);
     for(int i = 0; i < 6; i++)
-        output[i] = _grad_data[fetched_data][i];
+        output[i] = _grad_data[i];
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint32_t BMI160::getSampleTimestamp()
+{
+    return _timestamp;
+}
+
+#ifdef ENABLE_LATENCY_TRACING
+//-----------------------------------------------------------------------------------------------------------------
+LatencyStats& BMI160::getProcessingLatency()
+{
+    return _processing_latency;
+}
+#endif
+
+//-----------------------------------------------------------------------------------------------------------------
+uint32_t BMI160::getDroppedSamples()
+{
+    return _dropped_samples + _isr_overflows;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void BMI160::processRawSample(const int16_t raw_data[6], uint32_t timestamp)
+{
+    for(int i = 0; i < 6; i++)
+        _raw_data[i] = raw_data[i];
+    __processSample(timestamp);
 }
 
 //-----------------------------------------------------------------------------------------------------------------
@@ -151,28 +492,6 @@ void BMI160::testRoutine(bool filtered)
     }
 }
 
-//-----------------------------------------------------------------------------------------------------------------
-int8_t BMI160::__getNextN(int8_t n, uint8_t steps)
-{
-    int8_t next_n = n + steps;
-    if(next_n >= SMOOTH_WINDOW_N)
-    {
-        next_n = next_n - SMOOTH_WINDOW_N;
-    }
-    return next_n;
-}
-
-//-----------------------------------------------------------------------------------------------------------------
-int8_t BMI160::__getPrevN(int8_t n, uint8_t steps)
-{
-    int8_t prev_n = n - steps;
-    if(prev_n < 0)
-    {
-        prev_n = prev_n + SMOOTH_WINDOW_N;
-    }
-    return prev_n;
-}
-
 //-----------------------------------------------------------------------------------------------------------------
 void BMI160::__writeRegister(uint8_t reg, uint8_t value)
 {
@@ -197,120 +516,144 @@ int8_t BMI160::__read8(uint8_t reg)
 }
 
 //-----------------------------------------------------------------------------------------------------------------
-void BMI160::__readOutputData(int16_t buffer[6])
+bool BMI160::__writeVerified(uint8_t reg, uint8_t value)
 {
-    Wire.beginTransmission(BMI160_ADDRESS);
-    Wire.write(__BMI160_OUTPUT_REG);
-    Wire.endTransmission(false);
-    Wire.requestFrom(BMI160_ADDRESS, 20);
+    __writeRegister(reg, value);
+    return (uint8_t)__read8(reg) == value;
+}
 
-    while(Wire.available() != 20);
+//-----------------------------------------------------------------------------------------------------------------
+bool BMI160::__setNormalMode(uint8_t command, uint8_t shift)
+{
+    __writeRegister(__BMI160_CMD, command);
 
-    uint8_t data[20];
-    for(int i = 0; i < 20; i++) {
-        data[i] = Wire.read();
+    uint32_t start = micros();
+    while(((uint8_t)__read8(__BMI160_PMU_STATUS) >> shift & 0b11) != __PMU_NORMAL)
+    {
+        if(micros() - start > BMI160_PMU_TIMEOUT_US)
+            return false;
     }
+    return true;
+}
 
-    // Gyroscope data
-    buffer[GYR_X] = (int16_t)((data[9] << 8) | data[8]);
-    buffer[GYR_Y] = (int16_t)((data[11] << 8) | data[10]);
-    buffer[GYR_Z] = (int16_t)((data[13] << 8) | data[12]);
-
-    // Accelerometer data
-    buffer[ACC_X] = (int16_t)((data[15] << 8) | data[14]);
-    buffer[ACC_Y] = (int16_t)((data[17] << 8) | data[16]);
-    buffer[ACC_Z] = (int16_t)((data[19] << 8) | data[18]);
+//-----------------------------------------------------------------------------------------------------------------
+bool BMI160::__isValidConfig(const BMI160Config& config)
+{
+    if(config.acc_odr < BMI160_ODR_25HZ || config.acc_odr > BMI160_ODR_1600HZ)
+        return false;
+    if(config.gyr_odr < BMI160_ODR_25HZ || config.gyr_odr > BMI160_ODR_3200HZ)
+        return false;
+    if(config.acc_bandwidth > BMI160_BW_NORMAL || config.gyr_bandwidth > BMI160_BW_NORMAL)
+        return false;
+    if(__accRangeToG(config.acc_range) == 0 || __gyrRangeToDps(config.gyr_range) == 0)
+        return false;
+
+    // The sensor accepts faster rates, but the reads would fall behind and lose samples
+    uint8_t max_odr = _fifo_enabled ? BMI160_MAX_ODR_FIFO : BMI160_MAX_ODR_DIRECT;
+    if(config.acc_odr > max_odr || config.gyr_odr > max_odr)
+        return false;
+
+    // Headerless frames hold both sensors, which only works if they sample at the same rate
+    return !_fifo_enabled || config.acc_odr == config.gyr_odr;
 }
 
 //-----------------------------------------------------------------------------------------------------------------
-void BMI160::__normalizeData(int16_t input_data[6], float output_data[6])
+uint8_t BMI160::__accRangeToG(uint8_t range)
 {
-    output_data[GYR_X] = input_data[GYR_X] * 3.14 / 180.0 / 150.0;
-    output_data[GYR_Y] = input_data[GYR_Y] * 3.14 / 180.0 / 150.0;
-    output_data[GYR_Z] = input_data[GYR_Z] * 3.14 / 180.0 / 150.0;
+    switch(range)
+    {
+        case BMI160_ACC_RANGE_2G: return 2;
+        case BMI160_ACC_RANGE_4G: return 4;
+        case BMI160_ACC_RANGE_8G: return 8;
+        case BMI160_ACC_RANGE_16G: return 16;
+        default: return 0;
+    }
+}
 
-    output_data[ACC_X] = input_data[ACC_X] / 16384.0;
-    output_data[ACC_Y] = input_data[ACC_Y] / 16384.0;
-    output_data[ACC_Z] = input_data[ACC_Z] / 16384.0;
+//-----------------------------------------------------------------------------------------------------------------
+uint16_t BMI160::__gyrRangeToDps(uint8_t range)
+{
+    if(range > BMI160_GYR_RANGE_125DPS)
+        return 0;
 
-    // To fix the constant gravity offset from the z axis.
-    output_data[ACC_Z] -= 1.0;
+    // The range halves with every step
+    return 2000 >> range;
 }
 
 //-----------------------------------------------------------------------------------------------------------------
-void BMI160::__filterData(float input_data[6], float prev_input_data[6], float output_data[6],
-                          float alpha_high, float alpha_low)
+float BMI160::__odrToHz(uint8_t odr)
 {
-  for(int i = 0; i < 6; i++)
-  {
-    // High pass filter
-    output_data[i] = alpha_high * (prev_input_data[i] + input_data[i] - prev_input_data[i]);
+    // 100Hz at BMI160_ODR_100HZ, doubling with every step
+    if(odr >= BMI160_ODR_100HZ)
+        return 100.0f * (1 << (odr - BMI160_ODR_100HZ));
+    return 100.0f / (1 << (BMI160_ODR_100HZ - odr));
+}
 
-    // Low pass filter
-    output_data[i] = alpha_low * input_data[i] + (1 - alpha_low) * prev_input_data[i];
-  }
+//-----------------------------------------------------------------------------------------------------------------
+uint16_t BMI160::__getFifoFrames(uint8_t length_data[2])
+{
+    // The fill level is an 11 bit byte count
+    uint16_t fifo_length = ((length_data[1] & 0x07) << 8) | length_data[0];
+    uint16_t frames = fifo_length / BMI160_FIFO_FRAME_LEN;
+    if(frames > BMI160_FIFO_BATCH_N)
+        frames = BMI160_FIFO_BATCH_N;
+    return frames;
 }
 
 //-----------------------------------------------------------------------------------------------------------------
-void BMI160::__sqrRootData(float input_data[6], float output_data[6])
+void BMI160::__decodeFifoFrame(uint8_t frame[], int16_t buffer[6])
 {
-    for(int i = 3; i < 6; i++)
-    {
-        bool is_neg = input_data[i] < 0;
-        int factor = 1;
-        if(is_neg) factor = -1;
+    PROFILE_SCOPE(PROFILE_BMI160_DECODE);
 
-        output_data[i] = sqrt(input_data[i] * factor) * factor;
-    }
+    // Gyroscope data comes first in a frame
+    buffer[GYR_X] = (int16_t)((frame[1] << 8) | frame[0]);
+    buffer[GYR_Y] = (int16_t)((frame[3] << 8) | frame[2]);
+    buffer[GYR_Z] = (int16_t)((frame[5] << 8) | frame[4]);
+
+    // Accelerometer data
+    buffer[ACC_X] = (int16_t)((frame[7] << 8) | frame[6]);
+    buffer[ACC_Y] = (int16_t)((frame[9] << 8) | frame[8]);
+    buffer[ACC_Z] = (int16_t)((frame[11] << 8) | frame[10]);
 }
 
 //-----------------------------------------------------------------------------------------------------------------
-void BMI160::__groundData(float input_data[][6], float output_data[])
+void BMI160::__decodeOutputData(uint8_t data[], int16_t buffer[6])
 {
-    float sum_value[6] = {0};
-    for(int i = 0; i < SMOOTH_WINDOW_N; i++)
-    {
-        for(int data_id = 3; data_id < 6; data_id++)
-        {
-            sum_value[data_id] += input_data[i][data_id];
-        }
+    PROFILE_SCOPE(PROFILE_BMI160_DECODE);
 
-    }
+    // Gyroscope data
+    buffer[GYR_X] = (int16_t)((data[9] << 8) | data[8]);
+    buffer[GYR_Y] = (int16_t)((data[11] << 8) | data[10]);
+    buffer[GYR_Z] = (int16_t)((data[13] << 8) | data[12]);
 
-    for(int data_id = 0; data_id < 3; data_id++)
-    {
-        output_data[data_id] = input_data[_curr_n][data_id];
-    }    
-    for(int data_id = 3; data_id < 6; data_id++)
-    {
-        float average_value = sum_value[data_id] / SMOOTH_WINDOW_N;
-        output_data[data_id] = input_data[_curr_n][data_id] - average_value;
-    }
+    // Accelerometer data
+    buffer[ACC_X] = (int16_t)((data[15] << 8) | data[14]);
+    buffer[ACC_Y] = (int16_t)((data[17] << 8) | data[16]);
+    buffer[ACC_Z] = (int16_t)((data[19] << 8) | data[18]);
 }
 
 //-----------------------------------------------------------------------------------------------------------------
-void BMI160::__smoothData(float input_data[][6], float output_data[])
+void BMI160::__normalizeData(int16_t input_data[6], float output_data[6])
 {
-    float sum_value[6] = {0};
-    for(int i = 0; i < SMOOTH_WINDOW_N; i++)
-    {
-        for(int data_id = 0; data_id < 6; data_id++)
-        {
-            sum_value[data_id] += input_data[i][data_id];
-        }
+    PROFILE_SCOPE(PROFILE_BMI160_NORMALIZE);
 
-    }
-    
-    for(int data_id = 0; data_id < 6; data_id++)
-    {
-        float average_value = sum_value[data_id] / SMOOTH_WINDOW_N;
-        output_data[data_id] = average_value;
-    }
+    output_data[GYR_X] = input_data[GYR_X] * _gyr_scale;
+    output_data[GYR_Y] = input_data[GYR_Y] * _gyr_scale;
+    output_data[GYR_Z] = input_data[GYR_Z] * _gyr_scale;
+
+    output_data[ACC_X] = input_data[ACC_X] * _acc_scale;
+    output_data[ACC_Y] = input_data[ACC_Y] * _acc_scale;
+    output_data[ACC_Z] = input_data[ACC_Z] * _acc_scale;
+
+    // To fix the constant gravity offset from the z axis.
+    output_data[ACC_Z] -= 1.0f;
 }
 
 //-----------------------------------------------------------------------------------------------------------------
 void BMI160::__computeGradient(float input_data[6], float prev_input_data[6], float output_data[6])
 {
+    PROFILE_SCOPE(PROFILE_BMI160_GRADIENT);
+
     for(int i = 0; i < 6; i++)
     {
         output_data[i] = prev_input_data[i] - input_data[i];
@@ -6,6 +6,9 @@
  * Filters and processes data for better use.
  * Uses a windowed approach which grounds accelerator data to account
  * for gravitational pull and smoothes accelerator and gyroscope data.
+ * Output data rate, range and filter bandwidth of both sensors can be
+ * changed at runtime with setConfig(). The normalization follows the
+ * selected ranges, so the processed data keeps its scale.
  * 
  * Author: Cyril Marx
  * Created: July 2024
@@ -16,6 +19,11 @@
 
 #include <Arduino.h>
 #include <Wire.h>
+#include "I2CTransfer.hpp"
+#include "SPSCRing.hpp"
+#include "FilterStages.hpp"
+#include "Profiler.hpp"
+#include "LatencyStats.hpp"
 
 #define BMI160_ADDRESS 0x69
 
@@ -39,18 +47,89 @@
 #define __BMI160_PMU_STATUS 0x03
 
 #define __BMI160_OUTPUT_REG 0x04
+#define __BMI160_FIFO_LENGTH 0x22
+#define __BMI160_FIFO_DATA 0x24
 
 #define __BMI160_ACC_CONF 0x40
 #define __BMI160_ACC_RANGE 0x41
 #define __BMI160_GYR_CONF 0x42
 #define __BMI160_GYR_RANGE 0x43
+#define __BMI160_FIFO_CONFIG_1 0x47
+#define __BMI160_INT_EN_1 0x51
+#define __BMI160_INT_OUT_CTRL 0x53
+#define __BMI160_INT_MAP_1 0x56
 #define __BMI160_CMD 0x7E
 
+// Commands
+#define __BMI160_CMD_ACC_NORMAL 0x11
+#define __BMI160_CMD_GYR_NORMAL 0x15
+#define __BMI160_CMD_FIFO_FLUSH 0xB0
+
+// Output data rates (ODR field of ACC_CONF and GYR_CONF), the rate doubles with every step
+#define BMI160_ODR_25HZ 0x06
+#define BMI160_ODR_50HZ 0x07
+#define BMI160_ODR_100HZ 0x08
+#define BMI160_ODR_200HZ 0x09
+#define BMI160_ODR_400HZ 0x0A
+#define BMI160_ODR_800HZ 0x0B
+#define BMI160_ODR_1600HZ 0x0C
+#define BMI160_ODR_3200HZ 0x0D      // Gyroscope only
+
+// Accelerometer ranges (ACC_RANGE register)
+#define BMI160_ACC_RANGE_2G 0x03
+#define BMI160_ACC_RANGE_4G 0x05
+#define BMI160_ACC_RANGE_8G 0x08
+#define BMI160_ACC_RANGE_16G 0x0C
+
+// Gyroscope ranges (GYR_RANGE register)
+#define BMI160_GYR_RANGE_2000DPS 0x00
+#define BMI160_GYR_RANGE_1000DPS 0x01
+#define BMI160_GYR_RANGE_500DPS 0x02
+#define BMI160_GYR_RANGE_250DPS 0x03
+#define BMI160_GYR_RANGE_125DPS 0x04
+
+// Filter bandwidths (BWP field of ACC_CONF and GYR_CONF), oversampling lowers the cutoff frequency
+#define BMI160_BW_OSR4 0x00         // 4 times oversampling, cutoff at about 1/10 of the ODR
+#define BMI160_BW_OSR2 0x01         // 2 times oversampling, cutoff at about 1/5 of the ODR
+#define BMI160_BW_NORMAL 0x02       // Cutoff at about 2/5 of the ODR
+
+// Longest wait for a sensor to reach normal mode (the gyroscope needs up to 80ms from suspend)
+#define BMI160_PMU_TIMEOUT_US 100000
+
 // Data processing parameters
 #define SMOOTH_WINDOW_N 6
 #define ALPHA_HIGH 0.7
 #define ALPHA_LOW 0.7
 
+// Filter modes
+#define BMI160_FILTER_CHAIN 0       // Low pass, grounding and boxcar smoothing on all axes
+#define BMI160_FILTER_ONE_EURO 1    // Speed adaptive One Euro filter on the gyroscope axes
+
+// FIFO parameters
+#define BMI160_FIFO_FRAME_LEN 12    // Headerless frame with gyroscope and accelerometer data (2 bytes per axis)
+#define BMI160_FIFO_BATCH_N 8       // Maximum frames drained in one burst read
+
+// Default read timeout. A burst of a full batch alone keeps the bus busy for about 9ms at 100kHz.
+#define BMI160_READ_TIMEOUT_US 10000
+
+// Fastest output data rates the reads keep up with at 100kHz. A read takes three bus phases, one per run of the sensor
+// task, so with the FIFO a full batch gets through about every 15ms, a bit over 500 frames per second. Without the
+// FIFO every read gets a single sample.
+#define BMI160_MAX_ODR_FIFO BMI160_ODR_400HZ
+#define BMI160_MAX_ODR_DIRECT BMI160_ODR_100HZ
+
+// Normalization of the gyroscope at 2000dps, which the processing chains are tuned for
+#define BMI160_GYR_SCALE_2000DPS (3.14 / 180.0 / 150.0)
+
+// Register block length of the output data
+#define BMI160_OUTPUT_LEN 20
+
+// Return value of pollSensorRead() while a read is still in flight
+#define BMI160_READ_BUSY -1
+
+// Number of data ready timestamps the interrupt can queue up before samples are dropped (power of two)
+#define BMI160_SAMPLE_RING_N 16
+
 // IDs of the data in the buffers
 #define GYR_X 0
 #define GYR_Y 1
@@ -59,6 +138,58 @@
 #define ACC_Y 4
 #define ACC_Z 5
 
+// Coefficients of the default processing chain
+struct BMI160FilterCoefficients
+{
+    static constexpr float alpha_high = ALPHA_HIGH;
+    static constexpr float alpha_low = ALPHA_LOW;
+};
+
+// The chain every normalized data point runs through. Product variants add, drop or reorder stages here.
+// The square root is part of the low pass feedback loop, so the filter remembers the square rooted values.
+typedef StageChain<PROFILE_PROCESSING_STAGE, PROFILE_PROCESSING_STAGE_N,
+                   LowPassStage<BMI160FilterCoefficients, AXES_ALL, SignedSqrtStage<AXES_ACC>>,
+                   GroundStage<SMOOTH_WINDOW_N, AXES_ACC>,
+                   SmoothStage<SMOOTH_WINDOW_N, AXES_ALL>> BMI160ProcessingChain;
+
+// Parameters of the One Euro filter on the normalized gyroscope data
+struct BMI160OneEuroParameters
+{
+    static constexpr float rate = 100.0f;
+    static constexpr float min_cutoff = 0.5f;
+    static constexpr float beta = 20.0f;
+    static constexpr float d_cutoff = 1.0f;
+
+    // The high pass step of the default chain scales the data by ALPHA_HIGH, which its low pass keeps at rest. The
+    // One Euro filter passes the data unscaled, so it is scaled the same way to move the pointer equally fast.
+    static constexpr float gain = ALPHA_HIGH;
+};
+
+// The chain used in BMI160_FILTER_ONE_EURO mode. The accelerator axes are processed like in the default chain.
+typedef StageChain<PROFILE_ONE_EURO_STAGE, PROFILE_ONE_EURO_STAGE_N,
+                   OneEuroStage<BMI160OneEuroParameters, AXES_GYR>,
+                   GainStage<BMI160OneEuroParameters, AXES_GYR>,
+                   LowPassStage<BMI160FilterCoefficients, AXES_ACC, SignedSqrtStage<AXES_ACC>>,
+                   GroundStage<SMOOTH_WINDOW_N, AXES_ACC>,
+                   SmoothStage<SMOOTH_WINDOW_N, AXES_ACC>> BMI160OneEuroChain;
+
+typedef void (*BMI160SampleCallback)(int16_t raw_data[6]);
+
+// Output data rate, range and filter bandwidth of both sensors (see macros above)
+struct BMI160Config
+{
+    uint8_t acc_odr;
+    uint8_t acc_range;
+    uint8_t acc_bandwidth;
+    uint8_t gyr_odr;
+    uint8_t gyr_range;
+    uint8_t gyr_bandwidth;
+};
+
+// The configuration the processing chains are tuned for
+constexpr BMI160Config BMI160_DEFAULT_CONFIG = {BMI160_ODR_100HZ, BMI160_ACC_RANGE_2G, BMI160_BW_NORMAL,
+                                                BMI160_ODR_100HZ, BMI160_GYR_RANGE_2000DPS, BMI160_BW_NORMAL};
+
 class BMI160
 {
     public:
@@ -70,15 +201,169 @@ class BMI160
 
     //-----------------------------------------------------------------------------------------------------------------
     ///
-    /// Configures the module by setting registers to normal mode and setting to ranges to default ranges.
+    /// Configures the module by setting both sensors to normal mode and applying the default configuration. Waits for
+    /// the power mode changes by polling the PMU status instead of fixed delays.
+    ///
+    /// @return True if both sensors reached normal mode and the configuration was verified.
+    //
+    bool configureBMI160();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Configures the module like configureBMI160() but applies the given configuration.
+    ///
+    /// @param config       The configuration to apply.
+    ///
+    /// @return True if both sensors reached normal mode and the configuration was verified.
+    //
+    bool configureBMI160(const BMI160Config& config);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Writes output data rate, range and filter bandwidth of both sensors and reads the registers back. The
+    /// normalization and the sample rate of the processing chains follow the new configuration. If the FIFO is enabled
+    /// both sensors need the same output data rate, since headerless frames always hold both sensors. Output data
+    /// rates above what the reads keep up with (BMI160_MAX_ODR_FIFO with the FIFO, BMI160_MAX_ODR_DIRECT without) are
+    /// rejected.
+    /// Can be called at any time after configureBMI160() while no read is in flight.
+    ///
+    /// @param config       The configuration to apply.
+    ///
+    /// @return True if the configuration is valid, every register read back as written and the module reports no
+    ///         configuration error. Otherwise the previous configuration stays in use for processing.
+    //
+    bool setConfig(const BMI160Config& config);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the configuration currently in use.
+    //
+    BMI160Config getConfig();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the rate new samples are processed at, which is the output data rate of the gyroscope.
+    ///
+    /// @return The sample rate in Hz.
+    //
+    float getSampleRate();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the range of the accelerometer in g.
+    //
+    uint8_t getAccelerometerRange();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the range of the gyroscope in degrees per second.
+    //
+    uint16_t getGyroscopeRange();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns how long the last configureBMI160() took, most of it waiting for the sensors to power up.
+    ///
+    /// @return The duration in microseconds.
+    //
+    uint32_t getStartupTime();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Enables the FIFO of the module. Afterwards fetchSensorData() drains all buffered frames in one burst read
+    /// instead of reading only the latest data registers. Must be called after configureBMI160().
+    ///
+    /// @return False if the sensors run at different output data rates, since headerless frames always hold both
+    ///         sensors, or at a rate above BMI160_MAX_ODR_FIFO. The FIFO stays disabled then.
+    //
+    bool enableFifo();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Disables the FIFO of the module and returns to reading the latest data registers directly.
+    ///
+    /// @return False if the output data rate is above BMI160_MAX_ODR_DIRECT, the FIFO stays enabled then.
+    //
+    bool disableFifo();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Routes the data ready interrupt of the module to its INT1 pin and attaches an interrupt routine to the given
+    /// Arduino pin. The routine only timestamps each new sample and queues the timestamp. Afterwards reads are only
+    /// started if a new sample is pending, and every sample carries the time it was acquired at instead of the time
+    /// it was read at. Must be called after configureBMI160().
+    ///
+    /// @param pin          The Arduino pin the INT1 pin of the module is connected to.
+    //
+    void enableDataReadyInterrupt(uint8_t pin);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Selects which processing chain is used for new samples. The chain which is switched to starts from its own
+    /// last state, so the first few samples after switching can show a short transient.
+    ///
+    /// @param mode         The filter mode (see macros above).
     //
-    void configureBMI160();
+    void setFilterMode(uint8_t mode);
 
     //-----------------------------------------------------------------------------------------------------------------
     ///
-    /// Fetches the sensor data, processes it and stores it in the buffers.
+    /// Returns the currently used filter mode (see macros above).
     //
-    void fetchSensorData();
+    uint8_t getFilterMode();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Fetches the sensor data, processes it and stores it in the buffers. In FIFO mode every buffered frame (up to
+    /// BMI160_FIFO_BATCH_N) is processed in order, so no samples are lost between two calls.
+    /// Blocks until the read finished, but never longer than the read timeout.
+    ///
+    /// @return The number of new samples which were processed.
+    //
+    uint8_t fetchSensorData();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Starts reading the sensor data without blocking. Call pollSensorRead() regularly afterwards to advance the read.
+    /// Is ignored if a read is still in flight.
+    ///
+    /// @return True if a new read was started.
+    //
+    bool startSensorRead();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Advances a started read by at most one bus phase. Once all data arrived it is processed and stored in the buffers
+    /// like in fetchSensorData().
+    ///
+    /// @return BMI160_READ_BUSY while the read is in flight, otherwise the number of new samples which were processed
+    ///         (0 if the read failed or no read was started).
+    //
+    int8_t pollSensorRead();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Sets the time after which a read is aborted and counted as error. Defaults to BMI160_READ_TIMEOUT_US.
+    ///
+    /// @param timeout_us   The timeout in microseconds.
+    //
+    void setReadTimeout(uint32_t timeout_us);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns how often reading the sensor data failed with a certain error.
+    ///
+    /// @param error        The error type (see I2C_ERROR macros in I2CTransfer.hpp).
+    //
+    uint32_t getReadErrorCount(uint8_t error);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Sets a function which is called with the decoded raw data of every new sample after it was processed.
+    ///
+    /// @param callback     The function to call. nullptr disables the callback.
+    //
+    void setSampleCallback(BMI160SampleCallback callback);
 
     //-----------------------------------------------------------------------------------------------------------------
     ///
@@ -114,6 +399,40 @@ class BMI160
     //
     void getGradientData(float output[6]);
 
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the time the latest processed sample was acquired at.
+    ///
+    /// @return The timestamp in microseconds (micros() time base).
+    //
+    uint32_t getSampleTimestamp();
+
+#ifdef ENABLE_LATENCY_TRACING
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the latency from the acquisition of a sample until it is processed, which covers waiting for the read,
+    /// the I2C transfer and the processing chain.
+    //
+    LatencyStats& getProcessingLatency();
+#endif
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns how many samples were announced by the data ready interrupt but never processed, either because the
+    /// timestamp queue was full or because a newer sample overwrote the data registers before they were read.
+    //
+    uint32_t getDroppedSamples();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Processes a raw sample like one read from the sensor (normalization, processing chain and gradient), without
+    /// the bus. A hook for the host tests and benchmarks which feed recorded traces.
+    ///
+    /// @param raw_data     The raw sample in the order of the buffers (GYR_X to ACC_Z).
+    /// @param timestamp    The time the sample was taken in microseconds.
+    //
+    void processRawSample(const int16_t raw_data[6], uint32_t timestamp);
+
     //-----------------------------------------------------------------------------------------------------------------
     ///
     /// A test routine to quickly test the functionality of the module. Captures the main loop completely.
@@ -133,115 +452,165 @@ class BMI160
     void testRoutine(bool filtered);
 
     private:
-    int8_t _curr_n;
-    int16_t _raw_data[SMOOTH_WINDOW_N][6];
-    float _filtered_data[SMOOTH_WINDOW_N][6];
-    float _grounded_data[SMOOTH_WINDOW_N][6];
-    float _final_data[SMOOTH_WINDOW_N][6];
-    float _grad_data[SMOOTH_WINDOW_N][6];
+    I2CTransfer _transfer;
+    uint8_t _transfer_buffer[BMI160_FIFO_BATCH_N * BMI160_FIFO_FRAME_LEN];
+    uint8_t _read_stage;
+    BMI160SampleCallback _sample_callback;
+
+    static BMI160* _isr_instance;
+    SPSCRing<uint32_t, BMI160_SAMPLE_RING_N> _sample_times;
+    volatile uint32_t _isr_overflows;
+    uint32_t _dropped_samples;
+    bool _interrupt_enabled;
+
+    bool _fifo_enabled;
+    BMI160Config _config;
+    float _acc_scale;
+    float _gyr_scale;
+    uint32_t _startup_time;
+    int16_t _raw_data[6];
+    uint32_t _timestamp;
+    uint8_t _filter_mode;
+    BMI160ProcessingChain _chain;
+    BMI160OneEuroChain _one_euro_chain;
+#ifdef ENABLE_LATENCY_TRACING
+    LatencyStats _processing_latency;
+#endif
+    float _final_data[6];
+    float _grad_data[6];
 
     //-----------------------------------------------------------------------------------------------------------------
     ///
-    /// Computes a next valid id in the buffers. Wraps around if it exceeds smoothing window.
-    ///
-    /// @param n        The id to start from.
-    /// @param steps    The steps to add to the given n.
+    /// Writes a value to one of the modules registers.
     ///
-    /// @return The next valid id in the buffers.
+    /// @param reg      The register to write in.
+    /// @param value    The value to write to the register.
     //
-    int8_t __getNextN(int8_t n, uint8_t steps = 1);
+    void __writeRegister(uint8_t reg, uint8_t value);
 
     //-----------------------------------------------------------------------------------------------------------------
     ///
-    /// Computes a previous valid id in the buffers. Wraps around if it gets lower than 0.
+    /// Reads 1 byte (8 bits) from a certain register.
     ///
-    /// @param n        The id to start from.
-    /// @param steps    The steps to subtract to the given n.
+    /// @param reg      The register to read from.
     ///
-    /// @return The previous valid id in the buffers.
+    /// @return The 8 bits answer of the register.
     //
-    int8_t __getPrevN(int8_t n, uint8_t steps = 1);
+    int8_t __read8(uint8_t reg);
 
     //-----------------------------------------------------------------------------------------------------------------
     ///
-    /// Writes a value to one of the modules registers.
+    /// Writes a register and reads it back.
     ///
     /// @param reg      The register to write in.
     /// @param value    The value to write to the register.
+    ///
+    /// @return True if the register holds the written value.
     //
-    void __writeRegister(uint8_t reg, uint8_t value);
+    bool __writeVerified(uint8_t reg, uint8_t value);
 
     //-----------------------------------------------------------------------------------------------------------------
     ///
-    /// Reads 1 byte (8 bits) from a certain register.
+    /// Sends a power mode command and polls the PMU status until the sensor reached normal mode.
     ///
-    /// @param reg      The register to read from.
+    /// @param command      The power mode command.
+    /// @param shift        The position of the 2 bit power mode of the sensor in the PMU status register.
     ///
-    /// @return The 8 bits answer of the register.
+    /// @return True if normal mode was reached within BMI160_PMU_TIMEOUT_US.
     //
-    int8_t __read8(uint8_t reg);
+    bool __setNormalMode(uint8_t command, uint8_t shift);
 
     //-----------------------------------------------------------------------------------------------------------------
     ///
-    /// Requests the whole output data and stores it in the given buffer. Needs a buffer of size 6.
+    /// Checks whether a configuration only holds values the module supports.
     ///
-    /// @param buffer   The buffer to write to.
+    /// @param config       The configuration to check.
+    ///
+    /// @return True if the configuration is valid.
     //
-    void __readOutputData(int16_t buffer[6]);
+    bool __isValidConfig(const BMI160Config& config);
 
     //-----------------------------------------------------------------------------------------------------------------
     ///
-    /// Normalizes the data and brings it to a range of approximatly -1 and 1. Also casts the integer values from the
-    /// module to floats.
+    /// Converts an accelerometer range register value to g.
+    //
+    static uint8_t __accRangeToG(uint8_t range);
+
+    //-----------------------------------------------------------------------------------------------------------------
     ///
-    /// @param input_data       The data point to normalize (6 axes).
-    /// @param output_data      The array to store the normalized data in (6 axes).
+    /// Converts a gyroscope range register value to degrees per second.
     //
-    void __normalizeData(int16_t input_data[6], float output_data[6]);
+    static uint16_t __gyrRangeToDps(uint8_t range);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Converts an output data rate register value to Hz.
+    //
+    static float __odrToHz(uint8_t odr);
 
     //-----------------------------------------------------------------------------------------------------------------
     ///
-    /// Uses very rough low and high pass filters to process the data.
+    /// Computes how many complete FIFO frames can be read given the two FIFO length register bytes.
     ///
-    /// @param input_data           The data point to filter (6 axes).
-    /// @param prev_input_data      The previous data point (6 axes).
-    /// @param output_data          The array to store the filtered data in (6 axes).
-    /// @param alpha_high           The alpha value for the high pass filter.
-    /// @param alpha_low            The alpha value for the low pass filter.
+    /// @param length_data  The bytes of the FIFO length registers.
+    ///
+    /// @return The number of frames to read (at most BMI160_FIFO_BATCH_N).
     //
-    void __filterData(float input_data[6], float prev_input_data[6], float output_data[6],
-                        float alpha_high, float alpha_low);
+    uint16_t __getFifoFrames(uint8_t length_data[2]);
 
     //-----------------------------------------------------------------------------------------------------------------
     ///
-    /// Computes the square root of the accelerator data in a buffer to contrast the values.
+    /// Decodes one headerless FIFO frame into the axes order of the buffers. Needs a buffer of size 6.
+    ///
+    /// @param frame    The raw frame bytes (BMI160_FIFO_FRAME_LEN).
+    /// @param buffer   The buffer to write to.
+    //
+    void __decodeFifoFrame(uint8_t frame[], int16_t buffer[6]);
+
+    //-----------------------------------------------------------------------------------------------------------------
     ///
-    /// @param input_data           The data point to square (6 axes).
-    /// @param output_data          The array to store the squared data in (6 axes).
+    /// Interrupt routine of the data ready interrupt. Queues the current time for the next sample.
     //
-    void __sqrRootData(float input_data[6], float output_data[6]);
+    static void __dataReadyISR();
 
     //-----------------------------------------------------------------------------------------------------------------
     ///
-    /// A synthetic force to ground data back to 0 after detecting continuous changes. Acts as automatic calibration
-    /// at the cost of not being able to detect constant data changes anymore. Is a method of accounting for gravitational
-    /// pull at the module. Is currently only applied to the accelerator data.
+    /// Takes the acquisition time of the next sample to process. Uses the current time if no interrupt is used.
     ///
-    /// Works by computing the average of the whole data window and subtracting that from the latest data point.
+    /// @param newest_only  If true all queued timestamps except the newest one are discarded and counted as dropped.
+    ///                     Used if only the latest data registers are read.
     ///
-    /// @param data                 The full data buffer with all data points to ground.
-    /// @param output_data          The output buffer for the full grounded data buffer.
+    /// @return The timestamp in microseconds.
     //
-    void __groundData(float data[][6], float output_data[]);
+    uint32_t __takeSampleTime(bool newest_only);
 
     //-----------------------------------------------------------------------------------------------------------------
     ///
-    /// Smoothes the data in the given buffer.
+    /// Runs the whole processing chain on the latest raw data point. Only the latest results are kept, all history needed
+    /// for filtering lives in the stages of the chain.
     ///
-    /// @param data                 The full data buffer with all data points to smooth.
-    /// @param output_data          The output buffer for the full smoothed data buffer.
+    /// @param timestamp        The time the data point was acquired at in microseconds.
     //
-    void __smoothData(float data[][6], float output_data[]);
+    void __processSample(uint32_t timestamp);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Decodes the whole output data block and stores it in the given buffer. Needs a buffer of size 6.
+    ///
+    /// @param data     The raw register bytes (BMI160_OUTPUT_LEN).
+    /// @param buffer   The buffer to write to.
+    //
+    void __decodeOutputData(uint8_t data[], int16_t buffer[6]);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Normalizes the data and brings it to a range of approximatly -1 and 1. Also casts the integer values from the
+    /// module to floats. The scale follows the configured ranges.
+    ///
+    /// @param input_data       The data point to normalize (6 axes).
+    /// @param output_data      The array to store the normalized data in (6 axes).
+    //
+    void __normalizeData(int16_t input_data[6], float output_data[6]);
 
     //-----------------------------------------------------------------------------------------------------------------
     ///
@@ -0,0 +1,239 @@
+/**********************************************************************
+ * BondStore.cpp
+ * 
+ * Implementation of the BondStore class.
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#include "BondStore.hpp"
+#include <string.h>
+
+// Flash can only be programmed in whole words
+static_assert(sizeof(BondRecord) % 4 == 0, "Bond record must be a multiple of the flash word size");
+
+#if defined(ARDUINO_ARCH_MBED)
+#include <mbed.h>
+
+//-----------------------------------------------------------------------------------------------------------------
+static uint32_t __flashRecordAddress(mbed::FlashIAP& flash, uint32_t& sector_size)
+{
+    // The last sector, far behind the sketch
+    uint32_t flash_end = flash.get_flash_start() + flash.get_flash_size();
+    sector_size = flash.get_sector_size(flash_end - 1);
+    return flash_end - sector_size;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+static bool __flashRead(uint8_t data[], uint16_t length)
+{
+    mbed::FlashIAP flash;
+    if(flash.init() != 0)
+        return false;
+
+    uint32_t sector_size;
+    uint32_t address = __flashRecordAddress(flash, sector_size);
+    bool success = flash.read(data, address, length) == 0;
+    flash.deinit();
+    return success;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+static bool __flashWrite(const uint8_t data[], uint16_t length)
+{
+    mbed::FlashIAP flash;
+    if(flash.init() != 0)
+        return false;
+
+    uint32_t sector_size;
+    uint32_t address = __flashRecordAddress(flash, sector_size);
+    bool success = flash.erase(address, sector_size) == 0 && flash.program(data, address, length) == 0;
+    flash.deinit();
+    return success;
+}
+#else
+static constexpr BondStorageRead __flashRead = nullptr;
+static constexpr BondStorageWrite __flashWrite = nullptr;
+#endif
+
+//-----------------------------------------------------------------------------------------------------------------
+BondStore::BondStore(BondStorageRead read, BondStorageWrite write) :
+_read{read ? read : __flashRead},
+_write{write ? write : __flashWrite},
+_dirty{false}
+{
+    clear();
+    _dirty = false;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool BondStore::begin()
+{
+    _dirty = false;
+    if(_read && _read((uint8_t*)&_record, sizeof(_record)) &&
+       _record.magic == BOND_STORE_MAGIC && _record.version == BOND_STORE_VERSION &&
+       _record.count <= BOND_STORE_MAX_BONDS && _record.crc == __computeCrc())
+        return true;
+
+    // Erased flash or a record of an older layout
+    clear();
+    _dirty = false;
+    return false;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void BondStore::storeLTK(const uint8_t address[BOND_ADDRESS_LEN], const uint8_t ltk[BOND_KEY_LEN])
+{
+    BondEntry& bond = __touch(address);
+    if((bond.flags & BOND_HAS_LTK) && memcmp(bond.ltk, ltk, BOND_KEY_LEN) == 0)
+        return;
+
+    memcpy(bond.ltk, ltk, BOND_KEY_LEN);
+    bond.flags |= BOND_HAS_LTK;
+    _dirty = true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool BondStore::getLTK(const uint8_t address[BOND_ADDRESS_LEN], uint8_t ltk[BOND_KEY_LEN])
+{
+    int8_t index = __find(address);
+    if(index < 0 || !(_record.bonds[index].flags & BOND_HAS_LTK))
+        return false;
+
+    BondEntry& bond = __touch(address);
+    memcpy(ltk, bond.ltk, BOND_KEY_LEN);
+    return true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void BondStore::storeIRK(const uint8_t address[BOND_ADDRESS_LEN], const uint8_t irk[BOND_KEY_LEN])
+{
+    BondEntry& bond = __touch(address);
+    if((bond.flags & BOND_HAS_IRK) && memcmp(bond.irk, irk, BOND_KEY_LEN) == 0)
+        return;
+
+    memcpy(bond.irk, irk, BOND_KEY_LEN);
+    bond.flags |= BOND_HAS_IRK;
+    _dirty = true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint8_t BondStore::getBondCount()
+{
+    return _record.count;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+const BondEntry* BondStore::getBond(uint8_t index)
+{
+    if(index >= _record.count)
+        return nullptr;
+    return &_record.bonds[index];
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool BondStore::getLastHost(uint8_t address[BOND_ADDRESS_LEN])
+{
+    if(_record.count == 0)
+        return false;
+
+    memcpy(address, _record.bonds[0].address, BOND_ADDRESS_LEN);
+    return true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool BondStore::remove(const uint8_t address[BOND_ADDRESS_LEN])
+{
+    int8_t index = __find(address);
+    if(index < 0)
+        return false;
+
+    for(uint8_t i = index; i + 1 < _record.count; i++)
+        _record.bonds[i] = _record.bonds[i + 1];
+    _record.count--;
+    memset(&_record.bonds[_record.count], 0, sizeof(BondEntry));
+    _dirty = true;
+    return true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void BondStore::clear()
+{
+    memset(&_record, 0, sizeof(_record));
+    _record.magic = BOND_STORE_MAGIC;
+    _record.version = BOND_STORE_VERSION;
+    _dirty = true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool BondStore::commit()
+{
+    if(!_dirty)
+        return true;
+    if(!_write)
+        return false;
+
+    _record.crc = __computeCrc();
+    if(!_write((const uint8_t*)&_record, sizeof(_record)))
+        return false;
+
+    _dirty = false;
+    return true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool BondStore::isDirty()
+{
+    return _dirty;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+int8_t BondStore::__find(const uint8_t address[BOND_ADDRESS_LEN])
+{
+    for(uint8_t i = 0; i < _record.count; i++)
+    {
+        if(memcmp(_record.bonds[i].address, address, BOND_ADDRESS_LEN) == 0)
+            return i;
+    }
+    return -1;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+BondEntry& BondStore::__touch(const uint8_t address[BOND_ADDRESS_LEN])
+{
+    int8_t index = __find(address);
+    if(index == 0)
+        return _record.bonds[0];
+
+    BondEntry bond;
+    if(index > 0)
+    {
+        bond = _record.bonds[index];
+    }
+    else
+    {
+        // A new host, the least recently used bond falls off the end if the store is full
+        memset(&bond, 0, sizeof(bond));
+        memcpy(bond.address, address, BOND_ADDRESS_LEN);
+        if(_record.count < BOND_STORE_MAX_BONDS)
+            _record.count++;
+        index = _record.count - 1;
+    }
+
+    for(int8_t i = index; i > 0; i--)
+        _record.bonds[i] = _record.bonds[i - 1];
+    _record.bonds[0] = bond;
+    _dirty = true;
+    return _record.bonds[0];
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint16_t BondStore::__computeCrc()
+{
+    uint16_t stored_crc = _record.crc;
+    _record.crc = 0;
+    uint16_t crc = crc16((const uint8_t*)&_record, sizeof(_record));
+    _record.crc = stored_crc;
+    return crc;
+}
@@ -0,0 +1,206 @@
+/**********************************************************************
+ * BondStore.hpp
+ * 
+ * Keeps the bonding keys of known hosts across resets, so a host which
+ * paired once can reconnect right away instead of pairing again.
+ * Bonds are kept in a RAM copy of one flash record, ordered from the
+ * most to the least recently used one. The first bond therefore is the
+ * host the device talked to last. If the store is full the least
+ * recently used bond is replaced.
+ * Flash is only written by commit() and only if something changed,
+ * since erasing a flash sector stalls the CPU for tens of milliseconds.
+ * The storage backend can be replaced, e.g. by a RAM buffer to test the
+ * store on the host. By default the last sector of the internal flash
+ * is used on mbed boards, everywhere else bonds are only kept in RAM.
+ * Workflow:
+ *   1. Load the stored bonds with begin()
+ *   2. Hand the store to BLE_HID::useBondStore()
+ *   3. Call commit() regularly from a low priority task
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#ifndef BONDSTORE_HPP
+#define BONDSTORE_HPP
+
+#include <stdint.h>
+#include "CRC16.hpp"
+
+#define BOND_STORE_MAX_BONDS 4
+#define BOND_ADDRESS_LEN 6
+#define BOND_KEY_LEN 16
+
+// Identifies a valid record, bump the version when the layout changes
+#define BOND_STORE_MAGIC 0x444E4F42    // "BOND"
+#define BOND_STORE_VERSION 1
+
+// Keys known for a bond
+#define BOND_HAS_LTK 0x01   // Long term key to encrypt the link
+#define BOND_HAS_IRK 0x02   // Identity resolving key to recognize the private addresses of the host
+
+// A host which paired with the device
+struct BondEntry
+{
+    uint8_t address[BOND_ADDRESS_LEN];  // Identity address in the byte order of the BLE stack
+    uint8_t flags;
+    uint8_t reserved;
+    uint8_t ltk[BOND_KEY_LEN];
+    uint8_t irk[BOND_KEY_LEN];
+};
+
+// The image written to the storage
+struct BondRecord
+{
+    uint32_t magic;
+    uint8_t version;
+    uint8_t count;
+    uint16_t crc;       // CRC of the whole record with this field set to 0
+    BondEntry bonds[BOND_STORE_MAX_BONDS];
+};
+
+// Reads or writes the whole record image. Return false on failure.
+typedef bool (*BondStorageRead)(uint8_t data[], uint16_t length);
+typedef bool (*BondStorageWrite)(const uint8_t data[], uint16_t length);
+
+class BondStore
+{
+    public:
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Constructor.
+    ///
+    /// @param read         Reads the record from the storage. nullptr uses the internal flash.
+    /// @param write        Writes the record to the storage. nullptr uses the internal flash.
+    //
+    BondStore(BondStorageRead read = nullptr, BondStorageWrite write = nullptr);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Loads the bonds from the storage. Starts with an empty store if the storage holds no valid record.
+    ///
+    /// @return True if a valid record was loaded.
+    //
+    bool begin();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Stores the long term key of a host and makes it the most recently used bond.
+    ///
+    /// @param address      The identity address of the host.
+    /// @param ltk          The long term key.
+    //
+    void storeLTK(const uint8_t address[BOND_ADDRESS_LEN], const uint8_t ltk[BOND_KEY_LEN]);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Looks up the long term key of a host. A host whose key is requested is reconnecting, so it becomes the most
+    /// recently used bond.
+    ///
+    /// @param address      The identity address of the host.
+    /// @param ltk          Where to store the long term key.
+    ///
+    /// @return True if a long term key is known for the host.
+    //
+    bool getLTK(const uint8_t address[BOND_ADDRESS_LEN], uint8_t ltk[BOND_KEY_LEN]);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Stores the identity resolving key of a host.
+    ///
+    /// @param address      The identity address of the host.
+    /// @param irk          The identity resolving key.
+    //
+    void storeIRK(const uint8_t address[BOND_ADDRESS_LEN], const uint8_t irk[BOND_KEY_LEN]);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the number of stored bonds.
+    //
+    uint8_t getBondCount();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns a stored bond.
+    ///
+    /// @param index        0 for the most recently used bond up to getBondCount() - 1.
+    ///
+    /// @return The bond or nullptr if the index is out of range.
+    //
+    const BondEntry* getBond(uint8_t index);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the address of the host the device was bonded to or connected with last.
+    ///
+    /// @param address      Where to store the identity address.
+    ///
+    /// @return False if no host is known.
+    //
+    bool getLastHost(uint8_t address[BOND_ADDRESS_LEN]);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Removes the bond of a host.
+    ///
+    /// @param address      The identity address of the host.
+    ///
+    /// @return True if the host was bonded.
+    //
+    bool remove(const uint8_t address[BOND_ADDRESS_LEN]);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Removes all bonds.
+    //
+    void clear();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Writes the bonds to the storage if they changed since the last write.
+    ///
+    /// @return False if writing failed. The changes are kept and written by the next call.
+    //
+    bool commit();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns true if the bonds changed since they were loaded or written last.
+    //
+    bool isDirty();
+
+    private:
+    BondStorageRead _read;
+    BondStorageWrite _write;
+    BondRecord _record;
+    bool _dirty;
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Finds the bond of a host.
+    ///
+    /// @param address      The identity address of the host.
+    ///
+    /// @return The index of the bond or -1 if the host is not bonded.
+    //
+    int8_t __find(const uint8_t address[BOND_ADDRESS_LEN]);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Moves the bond of a host to the front. Creates the bond first if the host is not bonded yet, which replaces the
+    /// least recently used bond if the store is full. Only marks the store as changed if the order changed.
+    ///
+    /// @param address      The identity address of the host.
+    ///
+    /// @return The bond of the host.
+    //
+    BondEntry& __touch(const uint8_t address[BOND_ADDRESS_LEN]);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Computes the CRC of the record.
+    //
+    uint16_t __computeCrc();
+};
+
+#endif // BONDSTORE_HPP
@@ -4,6 +4,22 @@
 * A class to allow a button matrix by defining some digital output pins
 * which interact with some digital input pins. This allows for more
 * buttons than digital GPIO pins on the Arduino.
+* The size of the matrix is set at compile time, up to 8 rows and 7
+* columns, e.g. ButtonMatrix<2, 2> for a 2x2 matrix. The columns are
+* limited by the GPIOTE channels their wake interrupts take (see
+* MatrixIO.hpp).
+* The raw readings are debounced per button by a time based integrator,
+* so contact bounce does not turn into several presses. Every debounced
+* press and release is queued as an event with its timestamp.
+* Every button is tracked on its own, so any number of buttons can be
+* held at once (n-key rollover). For matrices without diodes, buttons
+* which could be ghosts of other buttons are held at their last state
+* until the reading is unambiguous again.
+* The pins are accessed through MatrixIO, which reads all columns of a
+* row at once.
+* After a quiet period without any button activity the matrix goes
+* idle: MatrixIO arms a wake interrupt on the columns and scans are
+* skipped until a button edge wakes the matrix again.
 * 
 * Author: Cyril Marx
 * Created: July 2024
@@ -13,27 +29,421 @@
 #define BUTTONMATRIX_HPP
 
 #include "Arduino.h"
+#include "SPSCRing.hpp"
+#include "MatrixIO.hpp"
+#include "Profiler.hpp"
 
-#define ROWS 2
-#define COLS 2
+// Time a button has to read the same for its debounced state to change
+#define BUTTON_DEFAULT_SETTLE_US 5000
 
+// Number of events which can wait in the queue, has to be a power of two
+#define BUTTON_EVENT_QUEUE_N 16
+
+// Time without any button activity after which scanning stops until a button edge
+#define BUTTON_DEFAULT_IDLE_TIMEOUT_US 100000
+
+//-----------------------------------------------------------------------------------------------------------------
+///
+/// A debounced press or release of a button.
+//
+struct ButtonEvent
+{
+    uint8_t row;
+    uint8_t col;
+    bool pressed;
+    uint32_t timestamp;     // Time of the scan which detected the change in microseconds
+};
+
+template<uint8_t R, uint8_t C>
 class ButtonMatrix
 {
+    static_assert(R > 0 && C > 0, "ButtonMatrix needs at least one row and one column");
+    static_assert(R <= MATRIX_IO_MAX_PINS && C <= MATRIX_IO_MAX_PINS, "Too many rows or columns for MatrixIO");
+    static_assert(C + MATRIX_IO_RESERVED_CHANNELS <= MATRIX_IO_INTERRUPT_CHANNELS,
+                  "Not enough GPIOTE channels left for the wake interrupts of all columns");
+
     public:
-    ButtonMatrix();
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Constructor.
+    //
+    ButtonMatrix() :
+    _settle_us{BUTTON_DEFAULT_SETTLE_US},
+    _last_scan{0},
+    _scanned{false},
+    _idle{false},
+    _idle_timeout_us{BUTTON_DEFAULT_IDLE_TIMEOUT_US},
+    _last_activity{0},
+    _wake_latency{0},
+    _max_wake_latency{0},
+    _ghost_detection{true},
+    _ghost_scans{0},
+    _dropped_events{0},
+    _scan_time{0},
+    _max_scan_time{0}
+    {
+        for(uint8_t row = 0; row < R; row++)
+        {
+            _row_states[row] = 0;
+            for(uint8_t col = 0; col < C; col++)
+                _integrators[row][col] = 0;
+        }
+    }
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Adds the next row pin. Rows are driven low one at a time while scanning.
+    ///
+    /// @return 0 on success, 1 if all rows are set already.
+    //
+    uint8_t addRowPin(uint8_t pin)
+    {
+        if(_io.getRowCount() >= R)
+            return 1;
+
+        _io.addRowPin(pin);
+        return 0;
+    }
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Adds the next column pin. Columns are read with the internal pullup enabled.
+    ///
+    /// @return 0 on success, 1 if all columns are set already.
+    //
+    uint8_t addColPin(uint8_t pin)
+    {
+        if(_io.getColCount() >= C)
+            return 1;
+
+        _io.addColPin(pin);
+        return 0;
+    }
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Scans the matrix once and updates the debounced state. Call it regularly, the debounce integrates the time
+    /// between the scans, so the scan rate does not need to be constant. While idle, it only checks for a wake edge.
+    //
+    void fetchButtonPresses()
+    {
+        uint32_t now = micros();
+
+        if(_idle)
+        {
+            uint32_t wake_time;
+            if(!_io.checkWake(wake_time))
+                return;
+
+            _io.disarmWake();
+            _idle = false;
+            _last_activity = now;
+            _wake_latency = now - wake_time;
+            if(_wake_latency > _max_wake_latency)
+                _max_wake_latency = _wake_latency;
+
+            // The time spent idle must not count for the debounce of the waking button
+            _scanned = false;
+        }
+
+        PROFILE_SCOPE(PROFILE_MATRIX_SCAN);
+
+        // The first scan has no previous one to integrate from, it only counts as a single step
+        uint32_t elapsed = _scanned ? now - _last_scan : 1;
+        if(elapsed > _settle_us)
+            elapsed = _settle_us;
+        _last_scan = now;
+        _scanned = true;
+
+        uint8_t raw[R] = {0};
+        for(uint8_t row = 0; row < _io.getRowCount(); row++)
+        {
+            _io.selectRow(row);
+            raw[row] = _io.readCols();
+            _io.releaseRow(row);
+        }
+
+        if(_ghost_detection)
+            __maskGhosts(raw);
+
+        bool active = false;
+        for(uint8_t row = 0; row < _io.getRowCount(); row++)
+        {
+            for(uint8_t col = 0; col < _io.getColCount(); col++)
+            {
+                __debounce(row, col, (raw[row] >> col) & 1, elapsed, now);
+                active |= _integrators[row][col] != 0;
+            }
+            active |= raw[row] != 0 || _row_states[row] != 0;
+        }
+
+        _scan_time = micros() - now;
+        if(_scan_time > _max_scan_time)
+            _max_scan_time = _scan_time;
+
+        if(active)
+            _last_activity = now;
+        else if(_idle_timeout_us > 0 && now - _last_activity >= _idle_timeout_us)
+        {
+            _io.armWake();
+            _idle = true;
+        }
+    }
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the debounced state of a button.
+    //
+    bool checkButtonPress(uint8_t row, uint8_t col)
+    {
+        if(row >= R || col >= C)
+            return false;
+
+        return (_row_states[row] >> col) & 1;
+    }
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the debounced state of all buttons of a row, bit col is set for a pressed button.
+    //
+    uint8_t getRowStates(uint8_t row)
+    {
+        if(row >= R)
+            return 0;
+
+        return _row_states[row];
+    }
 
-    uint8_t addRowPin(uint8_t pin);
-    uint8_t addColPin(uint8_t pin);
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the debounced state of all buttons, bit row * C + col is set for a pressed button.
+    //
+    uint64_t getButtonStates()
+    {
+        uint64_t states = 0;
+        for(uint8_t row = 0; row < R; row++)
+            states |= (uint64_t)_row_states[row] << (row * C);
+        return states;
+    }
 
-    void fetchButtonPresses();
-    bool checkButtonPress(uint8_t row, uint8_t col);
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the number of buttons held right now.
+    //
+    uint8_t getPressedCount()
+    {
+        uint8_t count = 0;
+        for(uint8_t row = 0; row < R; row++)
+            count += __builtin_popcount(_row_states[row]);
+        return count;
+    }
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Sets the debounce time. A button has to read pressed (or released) for this long in total before its debounced
+    /// state changes, readings in the other direction count back down.
+    ///
+    /// @param settle_us    The settle time in microseconds, up to 65535.
+    //
+    void setSettleTime(uint16_t settle_us)
+    {
+        _settle_us = settle_us;
+
+        for(uint8_t row = 0; row < R; row++)
+            for(uint8_t col = 0; col < C; col++)
+                _integrators[row][col] = ((_row_states[row] >> col) & 1) ? settle_us : 0;
+    }
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Enables or disables the ghost detection. Matrices with a diode per button do not produce ghosts, disabling it
+    /// there allows every combination of buttons. Enabled by default.
+    //
+    void setGhostDetection(bool enabled)
+    {
+        _ghost_detection = enabled;
+    }
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns how many scans contained possible ghost buttons.
+    //
+    uint32_t getGhostScans()
+    {
+        return _ghost_scans;
+    }
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Sets the time without any button activity after which the matrix goes idle.
+    ///
+    /// @param timeout_us   The timeout in microseconds. 0 keeps the matrix scanning all the time.
+    //
+    void setIdleTimeout(uint32_t timeout_us)
+    {
+        _idle_timeout_us = timeout_us;
+    }
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns true while the matrix is idle and waits for a button edge.
+    //
+    bool isIdle()
+    {
+        return _idle;
+    }
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the time between the last wake edge and the first scan after it in microseconds.
+    //
+    uint32_t getWakeLatency()
+    {
+        return _wake_latency;
+    }
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the longest time between a wake edge and the first scan after it so far in microseconds.
+    //
+    uint32_t getMaxWakeLatency()
+    {
+        return _max_wake_latency;
+    }
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Takes the oldest press or release event from the queue.
+    ///
+    /// @param event        The event, only written if there is one.
+    ///
+    /// @return False if the queue is empty.
+    //
+    bool popEvent(ButtonEvent& event)
+    {
+        return _events.pop(event);
+    }
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns how many events were dropped because the queue was full.
+    //
+    uint32_t getDroppedEvents()
+    {
+        return _dropped_events;
+    }
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns how long the last scan of the whole matrix took in microseconds.
+    //
+    uint32_t getScanTime()
+    {
+        return _scan_time;
+    }
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the longest scan of the whole matrix so far in microseconds.
+    //
+    uint32_t getMaxScanTime()
+    {
+        return _max_scan_time;
+    }
 
     private:
-    uint8_t _set_rows;
-    uint8_t _set_cols;
-    uint8_t _row_pins[ROWS];
-    uint8_t _col_pins[COLS];
-    bool _button_presses[ROWS][COLS];
+    MatrixIO _io;
+
+    uint8_t _row_states[R];
+    uint16_t _integrators[R][C];
+    uint16_t _settle_us;
+    uint32_t _last_scan;
+    bool _scanned;
+
+    bool _idle;
+    uint32_t _idle_timeout_us;
+    uint32_t _last_activity;
+    uint32_t _wake_latency;
+    uint32_t _max_wake_latency;
+
+    bool _ghost_detection;
+    uint32_t _ghost_scans;
+
+    SPSCRing<ButtonEvent, BUTTON_EVENT_QUEUE_N> _events;
+    uint32_t _dropped_events;
+
+    uint32_t _scan_time;
+    uint32_t _max_scan_time;
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Replaces readings which could be ghosts with the debounced state. Without diodes, three held corners of a
+    /// rectangle in the matrix make the fourth corner read as held too. So whenever two rows share two or more held
+    /// columns, these columns of both rows are ambiguous.
+    ///
+    /// @param raw          The raw readings, one column mask per row.
+    //
+    void __maskGhosts(uint8_t raw[R])
+    {
+        uint8_t ambiguous[R] = {0};
+        bool found = false;
+
+        for(uint8_t row = 0; row < R; row++)
+        {
+            for(uint8_t other = row + 1; other < R; other++)
+            {
+                uint8_t shared = raw[row] & raw[other];
+                if(__builtin_popcount(shared) >= 2)
+                {
+                    ambiguous[row] |= shared;
+                    ambiguous[other] |= shared;
+                    found = true;
+                }
+            }
+        }
+
+        if(!found)
+            return;
+
+        _ghost_scans++;
+        for(uint8_t row = 0; row < R; row++)
+            raw[row] = (raw[row] & ~ambiguous[row]) | (_row_states[row] & ambiguous[row]);
+    }
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Integrates one raw reading of a button and queues an event if its debounced state changes.
+    ///
+    /// @param row          The row of the button.
+    /// @param col          The column of the button.
+    /// @param raw_pressed  The raw reading.
+    /// @param elapsed_us   The time since the last scan.
+    /// @param now          The time of this scan.
+    //
+    void __debounce(uint8_t row, uint8_t col, bool raw_pressed, uint16_t elapsed_us, uint32_t now)
+    {
+        uint16_t& integrator = _integrators[row][col];
+        uint8_t bit = 1 << col;
+        bool pressed = _row_states[row] & bit;
+
+        // Readings count towards the settle time in one direction and back down in the other, so short bounces cancel
+        // out
+        if(raw_pressed)
+            integrator = (_settle_us - integrator > elapsed_us) ? integrator + elapsed_us : _settle_us;
+        else
+            integrator = (integrator > elapsed_us) ? integrator - elapsed_us : 0;
+
+        // The state only flips at the ends of the range, which gives the integrator its hysteresis
+        if(!pressed && integrator >= _settle_us)
+            _row_states[row] |= bit;
+        else if(pressed && integrator == 0)
+            _row_states[row] &= ~bit;
+        else
+            return;
+
+        if(!_events.push(ButtonEvent{row, col, !pressed, now}))
+            _dropped_events++;
+    }
 };
 
-#endif // BUTTONMATRIX_HPP
\ No newline at end of file
+#endif // BUTTONMATRIX_HPP
@@ -0,0 +1,36 @@
+/**********************************************************************
+ * CRC16.hpp
+ * 
+ * The CRC-16/CCITT used to protect data on the wire and in flash.
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#ifndef CRC16_HPP
+#define CRC16_HPP
+
+#include <stdint.h>
+
+//-----------------------------------------------------------------------------------------------------------------
+///
+/// Computes the CRC-16/CCITT (polynomial 0x1021, initial value 0xFFFF) of a buffer.
+///
+/// @param data         The bytes to protect.
+/// @param length       The number of bytes.
+///
+/// @return The CRC.
+//
+inline uint16_t crc16(const uint8_t data[], uint16_t length)
+{
+    uint16_t crc = 0xFFFF;
+    for(uint16_t i = 0; i < length; i++)
+    {
+        crc ^= (uint16_t)data[i] << 8;
+        for(uint8_t bit = 0; bit < 8; bit++)
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+}
+
+#endif // CRC16_HPP
@@ -0,0 +1,422 @@
+/**********************************************************************
+ * FilterStages.hpp
+ * 
+ * Building blocks for sensor processing chains which are put together
+ * at compile time. Every stage works in place on one data point of all
+ * 6 axes, keeps its own state, takes its coefficients from a struct of
+ * constexpr values and only touches the axes set in its axes mask.
+ * A StageChain runs any number of stages in the given order. Since all
+ * stages are known at compile time the whole chain can be inlined, and
+ * stages can be added, dropped or reordered without any runtime cost.
+ * Stages which depend on the sample rate pick it up at runtime from
+ * setSampleRate(), all others ignore it.
+ * Every chain is profiled in its own range of zones reserved in
+ * Profiler.hpp, and every stage names itself for the profile.
+ * 
+ * Example:
+ *   StageChain<PROFILE_MY_STAGE, PROFILE_MY_STAGE_N,
+ *              LowPassStage<MyCoefficients, AXES_ALL>,
+ *              SmoothStage<8, AXES_GYR>> chain;
+ *   chain.process(data);
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#ifndef FILTERSTAGES_HPP
+#define FILTERSTAGES_HPP
+
+#include <Arduino.h>
+#include "WindowAverage.hpp"
+#include "Profiler.hpp"
+
+// Axes masks, bit n selects axis n of the data buffers (see axes IDs in BMI160.hpp)
+#define AXES_GYR 0b000111
+#define AXES_ACC 0b111000
+#define AXES_ALL 0b111111
+
+//-----------------------------------------------------------------------------------------------------------------
+///
+/// Counts the axes set in an axes mask.
+//
+constexpr uint8_t countAxes(uint8_t axes)
+{
+    return axes == 0 ? 0 : (axes & 1) + countAxes(axes >> 1);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+///
+/// Copies the axes selected by an axes mask into a packed array (countAxes(AXES) values).
+//
+template<uint8_t AXES>
+inline void gatherAxes(const float data[6], float selected_data[])
+{
+    uint8_t axis = 0;
+    for(int i = 0; i < 6; i++)
+    {
+        if(AXES & (1 << i))
+        {
+            selected_data[axis] = data[i];
+            axis++;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+///
+/// A stage which does nothing. Used as default for optional inner stages.
+//
+struct NoStage
+{
+    static constexpr uint8_t axes = 0;
+
+    void process(float data[6])
+    {
+        (void)data;
+    }
+
+    void setSampleRate(float rate)
+    {
+        (void)rate;
+    }
+};
+
+//-----------------------------------------------------------------------------------------------------------------
+///
+/// Uses very rough high and low pass filters against the previous output of the stage. An optional inner stage is
+/// applied inside the feedback loop, so the value remembered for the next data point is the value after the inner
+/// stage.
+///
+/// Coefficients needs the constexpr float members alpha_high and alpha_low.
+//
+template<typename Coefficients, uint8_t AXES, typename Inner = NoStage>
+class LowPassStage
+{
+    public:
+    static constexpr uint8_t axes = AXES;
+
+    static const char* name()
+    {
+        return "low pass";
+    }
+
+    LowPassStage()
+    {
+        for(int i = 0; i < 6; i++)
+            _prev_data[i] = 0.0f;
+    }
+
+    void process(float data[6])
+    {
+        for(int i = 0; i < 6; i++)
+        {
+            if(!(AXES & (1 << i)))
+                continue;
+
+            // High pass filter
+            data[i] = Coefficients::alpha_high * (_prev_data[i] + data[i] - _prev_data[i]);
+
+            // Low pass filter
+            data[i] = Coefficients::alpha_low * data[i] + (1 - Coefficients::alpha_low) * _prev_data[i];
+        }
+
+        _inner.process(data);
+
+        for(int i = 0; i < 6; i++)
+            _prev_data[i] = data[i];
+    }
+
+    void setSampleRate(float rate)
+    {
+        _inner.setSampleRate(rate);
+    }
+
+    private:
+    float _prev_data[6];
+    Inner _inner;
+};
+
+//-----------------------------------------------------------------------------------------------------------------
+///
+/// Computes the signed square root of the data to contrast the values.
+//
+template<uint8_t AXES>
+class SignedSqrtStage
+{
+    public:
+    static constexpr uint8_t axes = AXES;
+
+    static const char* name()
+    {
+        return "signed sqrt";
+    }
+
+    void process(float data[6])
+    {
+        for(int i = 0; i < 6; i++)
+        {
+            if(!(AXES & (1 << i)))
+                continue;
+
+            bool is_neg = data[i] < 0;
+            int factor = 1;
+            if(is_neg) factor = -1;
+
+            data[i] = sqrt(data[i] * factor) * factor;
+        }
+    }
+
+    void setSampleRate(float rate)
+    {
+        (void)rate;
+    }
+};
+
+//-----------------------------------------------------------------------------------------------------------------
+///
+/// A synthetic force to ground data back to 0 after detecting continuous changes. Acts as automatic calibration at the
+/// cost of not being able to detect constant data changes anymore. Subtracts the average of the last N data points
+/// from the latest one.
+//
+template<uint16_t N, uint8_t AXES>
+class GroundStage
+{
+    public:
+    static constexpr uint8_t axes = AXES;
+
+    static const char* name()
+    {
+        return "ground";
+    }
+
+    void process(float data[6])
+    {
+        float window_data[countAxes(AXES)];
+        gatherAxes<AXES>(data, window_data);
+        _window.push(window_data);
+
+        uint8_t axis = 0;
+        for(int i = 0; i < 6; i++)
+        {
+            if(!(AXES & (1 << i)))
+                continue;
+
+            data[i] = data[i] - _window.getAverage(axis);
+            axis++;
+        }
+    }
+
+    void setSampleRate(float rate)
+    {
+        (void)rate;
+    }
+
+    private:
+    WindowAverage<N, countAxes(AXES)> _window;
+};
+
+//-----------------------------------------------------------------------------------------------------------------
+///
+/// Smoothes the data by replacing it with the average of the last N data points.
+//
+template<uint16_t N, uint8_t AXES>
+class SmoothStage
+{
+    public:
+    static constexpr uint8_t axes = AXES;
+
+    static const char* name()
+    {
+        return "smooth";
+    }
+
+    void process(float data[6])
+    {
+        float window_data[countAxes(AXES)];
+        gatherAxes<AXES>(data, window_data);
+        _window.push(window_data);
+
+        uint8_t axis = 0;
+        for(int i = 0; i < 6; i++)
+        {
+            if(!(AXES & (1 << i)))
+                continue;
+
+            data[i] = _window.getAverage(axis);
+            axis++;
+        }
+    }
+
+    void setSampleRate(float rate)
+    {
+        (void)rate;
+    }
+
+    private:
+    WindowAverage<N, countAxes(AXES)> _window;
+};
+
+//-----------------------------------------------------------------------------------------------------------------
+///
+/// Scales the data by a constant gain.
+///
+/// Coefficients needs the constexpr float member gain.
+//
+template<typename Coefficients, uint8_t AXES>
+class GainStage
+{
+    public:
+    static constexpr uint8_t axes = AXES;
+
+    static const char* name()
+    {
+        return "gain";
+    }
+
+    void process(float data[6])
+    {
+        for(int i = 0; i < 6; i++)
+        {
+            if(AXES & (1 << i))
+                data[i] *= Coefficients::gain;
+        }
+    }
+
+    void setSampleRate(float rate)
+    {
+        (void)rate;
+    }
+};
+
+//-----------------------------------------------------------------------------------------------------------------
+///
+/// A speed adaptive low pass filter (One Euro filter). Slow movements are filtered with a low cutoff frequency to
+/// remove jitter, fast movements raise the cutoff frequency to remove lag.
+///
+/// Parameters needs the constexpr float members:
+///   rate          The sample rate in Hz until setSampleRate() is called.
+///   min_cutoff    The cutoff frequency in Hz at rest.
+///   beta          How fast the cutoff frequency rises with the speed of the data.
+///   d_cutoff      The cutoff frequency in Hz of the speed estimation.
+//
+template<typename Parameters, uint8_t AXES>
+class OneEuroStage
+{
+    public:
+    static constexpr uint8_t axes = AXES;
+
+    static const char* name()
+    {
+        return "one euro";
+    }
+
+    OneEuroStage() :
+    _initialized{false},
+    _rate{Parameters::rate}
+    {
+        for(int i = 0; i < 6; i++)
+        {
+            _prev_data[i] = 0.0f;
+            _prev_speed[i] = 0.0f;
+        }
+    }
+
+    void process(float data[6])
+    {
+        if(!_initialized)
+        {
+            for(int i = 0; i < 6; i++)
+                _prev_data[i] = data[i];
+            _initialized = true;
+            return;
+        }
+
+        for(int i = 0; i < 6; i++)
+        {
+            if(!(AXES & (1 << i)))
+                continue;
+
+            float speed = (data[i] - _prev_data[i]) * _rate;
+            _prev_speed[i] += __alpha(Parameters::d_cutoff) * (speed - _prev_speed[i]);
+
+            float cutoff = Parameters::min_cutoff + Parameters::beta * fabsf(_prev_speed[i]);
+            _prev_data[i] += __alpha(cutoff) * (data[i] - _prev_data[i]);
+            data[i] = _prev_data[i];
+        }
+    }
+
+    void setSampleRate(float rate)
+    {
+        _rate = rate;
+    }
+
+    private:
+    bool _initialized;
+    float _rate;
+    float _prev_data[6];
+    float _prev_speed[6];
+
+    float __alpha(float cutoff)
+    {
+        float tau = 1.0f / (2.0f * (float)PI * cutoff);
+        return 1.0f / (1.0f + tau * _rate);
+    }
+};
+
+//-----------------------------------------------------------------------------------------------------------------
+///
+/// Runs all given stages in order on one data point. Every chain has its own range of profiler zones (see
+/// Profiler.hpp), starting at ZONE with ZONE_N zones. Stage n is profiled in zone ZONE + n under its name().
+//
+template<uint8_t ZONE, uint8_t ZONE_N, typename... Stages>
+class StageChain;
+
+template<uint8_t ZONE, uint8_t ZONE_N>
+class StageChain<ZONE, ZONE_N>
+{
+    public:
+    void process(float data[6])
+    {
+        (void)data;
+    }
+
+    void setSampleRate(float rate)
+    {
+        (void)rate;
+    }
+};
+
+template<uint8_t ZONE, uint8_t ZONE_N, typename Head, typename... Tail>
+class StageChain<ZONE, ZONE_N, Head, Tail...>
+{
+    static_assert(1 + sizeof...(Tail) <= ZONE_N, "The chain has more stages than profiler zones");
+
+    public:
+    StageChain()
+    {
+#ifdef ENABLE_PROFILING
+        Profiler::nameZone(ZONE, Head::name());
+#endif
+    }
+
+    void process(float data[6])
+    {
+        {
+            PROFILE_SCOPE(ZONE);
+            _head.process(data);
+        }
+        _tail.process(data);
+    }
+
+    void setSampleRate(float rate)
+    {
+        _head.setSampleRate(rate);
+        _tail.setSampleRate(rate);
+    }
+
+    private:
+    Head _head;
+    StageChain<ZONE + 1, ZONE_N - 1, Tail...> _tail;
+};
+
+#endif // FILTERSTAGES_HPP
@@ -0,0 +1,243 @@
+/**********************************************************************
+ * FixedPipeline.cpp
+ * 
+ * Implementation of the FixedPipeline class.
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#include "FixedPipeline.hpp"
+
+// Coefficients in Q15, folded at compile time
+#define __Q15(value) ((int32_t)((value) * 32768.0 + 0.5))
+#define __GYR_SCALE_Q15 __Q15(BMI160_GYR_SCALE_2000DPS * FIXED_PIPELINE_ONE)
+// The float chain filters in place, so its high pass step scales the input by ALPHA_HIGH before the low pass runs.
+#define __INPUT_GAIN_Q15 __Q15(ALPHA_HIGH * ALPHA_LOW)
+#define __FEEDBACK_GAIN_Q15 __Q15(1.0 - ALPHA_LOW)
+
+static_assert(__GYR_SCALE_Q15 < 32768, "Gyroscope scale does not fit into Q15");
+static_assert(__INPUT_GAIN_Q15 < 32768 && __FEEDBACK_GAIN_Q15 < 32768, "Filter coefficients do not fit into Q15");
+
+//-----------------------------------------------------------------------------------------------------------------
+static inline int16_t __saturate16(int32_t value)
+{
+    if(value > INT16_MAX)
+        return INT16_MAX;
+    if(value < INT16_MIN)
+        return INT16_MIN;
+    return (int16_t)value;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+static inline uint32_t __pack16(int16_t low, int16_t high)
+{
+    return ((uint32_t)(uint16_t)low) | ((uint32_t)(uint16_t)high << 16);
+}
+
+#if FIXED_PIPELINE_SIMD
+//-----------------------------------------------------------------------------------------------------------------
+static inline int32_t __dualMac(uint32_t a, uint32_t b)
+{
+    int32_t result;
+    __asm__ ("smuad %0, %1, %2" : "=r" (result) : "r" (a), "r" (b));
+    return result;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+static inline uint32_t __dualSub(uint32_t a, uint32_t b)
+{
+    uint32_t result;
+    __asm__ ("qsub16 %0, %1, %2" : "=r" (result) : "r" (a), "r" (b));
+    return result;
+}
+#endif
+
+//-----------------------------------------------------------------------------------------------------------------
+static uint32_t __sqrt32(uint32_t value)
+{
+    uint32_t result = 0;
+    uint32_t bit = 1UL << 30;
+    while(bit > value)
+        bit >>= 2;
+
+    while(bit != 0)
+    {
+        if(value >= result + bit)
+        {
+            value -= result + bit;
+            result = (result >> 1) + bit;
+        }
+        else
+        {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+    return result;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+FixedPipeline::FixedPipeline() :
+_curr_n{0},
+_gyr_scale{__GYR_SCALE_Q15},
+_acc_range{2}
+{
+    for(int i = 0; i < 6; i++)
+    {
+        _filtered[i] = 0;
+        _final[i] = 0;
+        _grad[i] = 0;
+        _smooth_sum[i] = 0;
+        for(int n = 0; n < SMOOTH_WINDOW_N; n++)
+            _smooth_values[i][n] = 0;
+    }
+    for(int i = 0; i < 3; i++)
+    {
+        _ground_sum[i] = 0;
+        for(int n = 0; n < SMOOTH_WINDOW_N; n++)
+            _ground_values[i][n] = 0;
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void FixedPipeline::process(const int16_t raw_data[6])
+{
+    int16_t data[6];
+    int16_t prev_final[6];
+    for(int i = 0; i < 6; i++)
+        prev_final[i] = _final[i];
+
+    __normalizeData(raw_data, data);
+    __filterData(data);
+    __sqrRootData(data);
+
+    // The filter feeds back its square rooted output, same as the float chain
+    for(int i = 0; i < 6; i++)
+        _filtered[i] = data[i];
+
+    __groundData(data);
+    __smoothData(data);
+
+    for(int i = 0; i < 6; i++)
+        _final[i] = data[i];
+    __computeGradient(_final, prev_final, _grad);
+
+    _curr_n++;
+    if(_curr_n >= SMOOTH_WINDOW_N)
+        _curr_n = 0;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void FixedPipeline::setRanges(uint8_t acc_range_g, uint16_t gyr_range_dps)
+{
+    _acc_range = acc_range_g;
+    _gyr_scale = (__GYR_SCALE_Q15 * gyr_range_dps + 1000) / 2000;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void FixedPipeline::getProcessedData(int16_t output[6])
+{
+    for(int i = 0; i < 6; i++)
+        output[i] = _final[i];
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void FixedPipeline::getGradientData(int16_t output[6])
+{
+    for(int i = 0; i < 6; i++)
+        output[i] = _grad[i];
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+int32_t FixedPipeline::toPixels(int16_t value, int32_t gain)
+{
+    return (int32_t)value * gain / FIXED_PIPELINE_ONE;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void FixedPipeline::__normalizeData(const int16_t input_data[6], int16_t output_data[6])
+{
+    for(int i = GYR_X; i <= GYR_Z; i++)
+        output_data[i] = (int16_t)(((int32_t)input_data[i] * _gyr_scale + (1 << 14)) >> 15);
+
+    // The full scale of 32768 LSB is the range in g, so Q12 is a multiplication by the range and a shift by 3
+    for(int i = ACC_X; i <= ACC_Z; i++)
+        output_data[i] = __saturate16(((int32_t)input_data[i] * _acc_range) >> 3);
+
+    // To fix the constant gravity offset from the z axis.
+    output_data[ACC_Z] = __saturate16((int32_t)output_data[ACC_Z] - FIXED_PIPELINE_ONE);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void FixedPipeline::__filterData(int16_t data[6])
+{
+    const uint32_t coefficients = __pack16(__INPUT_GAIN_Q15, __FEEDBACK_GAIN_Q15);
+
+    for(int i = 0; i < 6; i++)
+    {
+#if FIXED_PIPELINE_SIMD
+        int32_t sum = __dualMac(__pack16(data[i], _filtered[i]), coefficients);
+#else
+        (void)coefficients;
+        int32_t sum = (int32_t)data[i] * __INPUT_GAIN_Q15 + (int32_t)_filtered[i] * __FEEDBACK_GAIN_Q15;
+#endif
+        data[i] = __saturate16((sum + (1 << 14)) >> 15);
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void FixedPipeline::__sqrRootData(int16_t data[6])
+{
+    // sqrt(v / ONE) * ONE == sqrt(v * ONE)
+    for(int i = ACC_X; i <= ACC_Z; i++)
+    {
+        bool is_neg = data[i] < 0;
+        uint32_t magnitude = is_neg ? -(int32_t)data[i] : data[i];
+        int32_t root = __sqrt32(magnitude << FIXED_PIPELINE_Q);
+        data[i] = __saturate16(is_neg ? -root : root);
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void FixedPipeline::__groundData(int16_t data[6])
+{
+    for(int axis = 0; axis < 3; axis++)
+    {
+        int16_t value = data[ACC_X + axis];
+        _ground_sum[axis] += value - _ground_values[axis][_curr_n];
+        _ground_values[axis][_curr_n] = value;
+
+        data[ACC_X + axis] = __saturate16(value - _ground_sum[axis] / SMOOTH_WINDOW_N);
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void FixedPipeline::__smoothData(int16_t data[6])
+{
+    for(int axis = 0; axis < 6; axis++)
+    {
+        _smooth_sum[axis] += data[axis] - _smooth_values[axis][_curr_n];
+        _smooth_values[axis][_curr_n] = data[axis];
+
+        data[axis] = (int16_t)(_smooth_sum[axis] / SMOOTH_WINDOW_N);
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void FixedPipeline::__computeGradient(const int16_t input_data[6], const int16_t prev_input_data[6],
+                                      int16_t output_data[6])
+{
+    for(int i = 0; i < 6; i += 2)
+    {
+#if FIXED_PIPELINE_SIMD
+        uint32_t difference = __dualSub(__pack16(prev_input_data[i], prev_input_data[i + 1]),
+                                        __pack16(input_data[i], input_data[i + 1]));
+        output_data[i] = (int16_t)(difference & 0xFFFF);
+        output_data[i + 1] = (int16_t)(difference >> 16);
+#else
+        output_data[i] = __saturate16((int32_t)prev_input_data[i] - input_data[i]);
+        output_data[i + 1] = __saturate16((int32_t)prev_input_data[i + 1] - input_data[i + 1]);
+#endif
+    }
+}
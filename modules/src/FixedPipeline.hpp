@@ -0,0 +1,162 @@
+/**********************************************************************
+ * FixedPipeline.hpp
+ * 
+ * An integer only alternative to the float processing chain of the
+ * BMI160 class. Runs the same stages (normalize, low pass, square root,
+ * grounding, smoothing, gradient) on the raw int16_t sensor values
+ * without touching the FPU or any double precision arithmetic.
+ * 
+ * Number formats:
+ *   - Samples are stored as Q12 in int16_t (range of about -8 to 8)
+ *   - Filter coefficients are stored as Q15
+ *   - Window sums are kept exact in int32_t
+ * 
+ * On cores with the DSP extension (Cortex-M4/M7) the 6 axes kernels use
+ * packed dual 16 bit instructions (SMUAD, QSUB16). Everywhere else a
+ * portable scalar version is compiled instead. The scalar version can
+ * also be forced by defining FIXED_PIPELINE_SCALAR.
+ * Workflow:
+ *   1. Feed every raw sample with process(), e.g. from the sample
+ *      callback of the BMI160 class
+ *   2. Read the processed data or the gradient in Q12
+ *   3. Convert axes to cursor movement with toPixels()
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#ifndef FIXEDPIPELINE_HPP
+#define FIXEDPIPELINE_HPP
+
+#include <Arduino.h>
+#include "BMI160.hpp"
+
+#if defined(__ARM_FEATURE_DSP) && !defined(FIXED_PIPELINE_SCALAR)
+#define FIXED_PIPELINE_SIMD 1
+#else
+#define FIXED_PIPELINE_SIMD 0
+#endif
+
+// Fractional bits of the processed samples
+#define FIXED_PIPELINE_Q 12
+#define FIXED_PIPELINE_ONE (1 << FIXED_PIPELINE_Q)
+
+class FixedPipeline
+{
+    public:
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Constructor.
+    //
+    FixedPipeline();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Runs one raw sample of the module through the whole processing chain.
+    ///
+    /// @param raw_data     The raw data as read from the module registers (6 axes).
+    //
+    void process(const int16_t raw_data[6]);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Sets the ranges the raw data was measured with, so the normalization matches the float chain. Defaults to the
+    /// ranges of BMI160_DEFAULT_CONFIG. Accelerations beyond 8g saturate in Q12.
+    ///
+    /// @param acc_range_g      The accelerometer range in g (see BMI160::getAccelerometerRange()).
+    /// @param gyr_range_dps    The gyroscope range in degrees per second (see BMI160::getGyroscopeRange()).
+    //
+    void setRanges(uint8_t acc_range_g, uint16_t gyr_range_dps);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns a copy of the processed, filtered data of the latest sample.
+    ///
+    /// @param output  Pointer to an array of size 6 where the Q12 data should be stored in.
+    //
+    void getProcessedData(int16_t output[6]);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns a copy of the gradient (change values) of the processed data.
+    ///
+    /// @param output  Pointer to an array of size 6 where the Q12 data should be stored in.
+    //
+    void getGradientData(int16_t output[6]);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Scales a Q12 value by an integer gain and truncates it to whole pixels like the float path does.
+    ///
+    /// @param value        The Q12 value.
+    /// @param gain         The gain in pixels per unit.
+    ///
+    /// @return The movement in whole pixels.
+    //
+    static int32_t toPixels(int16_t value, int32_t gain);
+
+    private:
+    uint16_t _curr_n;
+    int32_t _gyr_scale;
+    uint8_t _acc_range;
+    int16_t _filtered[6];
+    int16_t _final[6];
+    int16_t _grad[6];
+    int16_t _ground_values[3][SMOOTH_WINDOW_N];
+    int32_t _ground_sum[3];
+    int16_t _smooth_values[6][SMOOTH_WINDOW_N];
+    int32_t _smooth_sum[6];
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Converts the raw module values to Q12 in a range of approximatly -1 and 1 like the float normalization.
+    ///
+    /// @param input_data       The raw data point (6 axes).
+    /// @param output_data      The array to store the normalized data in (6 axes).
+    //
+    void __normalizeData(const int16_t input_data[6], int16_t output_data[6]);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Low pass filters the data against the previous filter output. Uses one dual multiply accumulate per axis.
+    ///
+    /// @param data             The data point to filter in place (6 axes).
+    //
+    void __filterData(int16_t data[6]);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Computes the signed square root of the accelerator data to contrast the values.
+    ///
+    /// @param data             The data point to process in place (6 axes).
+    //
+    void __sqrRootData(int16_t data[6]);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Subtracts the window average of the accelerator data from the latest data point.
+    ///
+    /// @param data             The data point to ground in place (6 axes).
+    //
+    void __groundData(int16_t data[6]);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Replaces the data point with the window average of all axes.
+    ///
+    /// @param data             The data point to smooth in place (6 axes).
+    //
+    void __smoothData(int16_t data[6]);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Computes the discrete differentials gradient between the previous and the latest data point.
+    ///
+    /// @param input_data           The latest data point (6 axes).
+    /// @param prev_input_data      The previous data point (6 axes).
+    /// @param output_data          The array to store the gradient data in (6 axes).
+    //
+    void __computeGradient(const int16_t input_data[6], const int16_t prev_input_data[6], int16_t output_data[6]);
+};
+
+#endif // FIXEDPIPELINE_HPP
@@ -0,0 +1,200 @@
+/**********************************************************************
+ * HCIEventTap.cpp
+ * 
+ * Implementation of the HCIEventTap class.
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#include "HCIEventTap.hpp"
+
+// ArduinoBLE prints every received event as this prefix followed by the packet in hex
+#define __EVENT_PREFIX "HCI EVENT RX <- "
+#define __EVENT_PREFIX_LEN (sizeof(__EVENT_PREFIX) - 1)
+
+// Packet type, event code and parameter length in front of the event parameters
+#define __EVENT_PACKET 0x04
+#define __EVENT_HEADER_LEN 3
+
+#define __EVENT_DISCONNECTION_COMPLETE 0x05
+#define __EVENT_LE_META 0x3E
+
+#define __LE_CONNECTION_UPDATE_COMPLETE 0x03
+
+// Offset of the interval from the status in the parameters of the update event. Latency and supervision timeout follow.
+#define __CONNECTION_UPDATE_COMPLETE_OFFSET 3
+
+#define __HANDLE_MASK 0x0FFF
+
+//-----------------------------------------------------------------------------------------------------------------
+HCIEventTap::HCIEventTap() :
+_packet_length{0},
+_prefix_length{0},
+_skip_line{false},
+_high_nibble{-1},
+_handle{HCI_EVENT_TAP_NO_HANDLE},
+_pending{false},
+_updated{false},
+_interval{0},
+_latency{0},
+_supervision_timeout{0}
+{ }
+
+//-----------------------------------------------------------------------------------------------------------------
+void HCIEventTap::expectUpdate(uint16_t handle)
+{
+    _handle = handle;
+    _pending = true;
+    _updated = false;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool HCIEventTap::isPending()
+{
+    return _pending;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool HCIEventTap::isUpdated()
+{
+    return _updated;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint16_t HCIEventTap::getConnectionInterval()
+{
+    return _interval;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint16_t HCIEventTap::getConnectionLatency()
+{
+    return _latency;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint16_t HCIEventTap::getSupervisionTimeout()
+{
+    return _supervision_timeout;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+size_t HCIEventTap::write(uint8_t value)
+{
+    if(value == '\n')
+    {
+        if(!_skip_line && _prefix_length == __EVENT_PREFIX_LEN && _high_nibble < 0)
+            __handlePacket();
+
+        _packet_length = 0;
+        _prefix_length = 0;
+        _skip_line = false;
+        _high_nibble = -1;
+        return 1;
+    }
+
+    if(value == '\r' || _skip_line)
+        return 1;
+
+    // Commands, ACL data and anything else printed to the stream are skipped up to the end of the line
+    if(_prefix_length < __EVENT_PREFIX_LEN)
+    {
+        if(value == __EVENT_PREFIX[_prefix_length])
+            _prefix_length++;
+        else
+            _skip_line = true;
+        return 1;
+    }
+
+    int8_t nibble = __hexValue(value);
+    if(nibble < 0 || (_high_nibble < 0 && _packet_length == HCI_EVENT_TAP_MAX_PACKET))
+    {
+        _skip_line = true;
+        return 1;
+    }
+
+    if(_high_nibble < 0)
+    {
+        _high_nibble = nibble;
+        return 1;
+    }
+
+    _packet[_packet_length++] = (_high_nibble << 4) | nibble;
+    _high_nibble = -1;
+    return 1;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+int HCIEventTap::available()
+{
+    return 0;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+int HCIEventTap::read()
+{
+    return -1;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+int HCIEventTap::peek()
+{
+    return -1;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void HCIEventTap::__handlePacket()
+{
+    if(!_pending || _packet_length < __EVENT_HEADER_LEN + 1 || _packet[0] != __EVENT_PACKET ||
+       _packet[2] != _packet_length - __EVENT_HEADER_LEN)
+        return;
+
+    const uint8_t* parameters = &_packet[__EVENT_HEADER_LEN];
+    uint8_t length = _packet[2];
+
+    if(_packet[1] == __EVENT_DISCONNECTION_COMPLETE)
+    {
+        // Status, handle, reason. A lost connection ends the update without an update event.
+        if(length >= 4 && parameters[0] == 0 && (__readUint16(&parameters[1]) & __HANDLE_MASK) == _handle)
+            _pending = false;
+        return;
+    }
+
+    // The LE events carry a subevent code in front of the status
+    if(_packet[1] != __EVENT_LE_META || parameters[0] != __LE_CONNECTION_UPDATE_COMPLETE)
+        return;
+    parameters++;
+    length--;
+
+    if(length < __CONNECTION_UPDATE_COMPLETE_OFFSET + 6 || (__readUint16(&parameters[1]) & __HANDLE_MASK) != _handle)
+        return;
+
+    // A failed update ends the same way, the connection keeps its previous parameters then
+    _pending = false;
+    if(parameters[0] != 0)
+        return;
+
+    _updated = true;
+    _interval = __readUint16(&parameters[__CONNECTION_UPDATE_COMPLETE_OFFSET]);
+    _latency = __readUint16(&parameters[__CONNECTION_UPDATE_COMPLETE_OFFSET + 2]);
+    _supervision_timeout = __readUint16(&parameters[__CONNECTION_UPDATE_COMPLETE_OFFSET + 4]);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint16_t HCIEventTap::__readUint16(const uint8_t data[])
+{
+    return data[0] | (data[1] << 8);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+int8_t HCIEventTap::__hexValue(uint8_t character)
+{
+    if(character >= '0' && character <= '9')
+        return character - '0';
+    if(character >= 'A' && character <= 'F')
+        return character - 'A' + 10;
+    if(character >= 'a' && character <= 'f')
+        return character - 'a' + 10;
+    return -1;
+}
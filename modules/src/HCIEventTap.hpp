@@ -0,0 +1,120 @@
+/**********************************************************************
+ * HCIEventTap.hpp
+ * 
+ * Catches the outcome of a connection parameter update on the HCI.
+ * ArduinoBLE keeps the parameters the host picked to itself, but it can
+ * dump every HCI packet as a line of hex text to a debug stream. Handed
+ * to HCI.debug() as that stream while an update is outstanding, the tap
+ * parses the events in these lines and waits for the LE connection
+ * update complete event of the connection. It keeps the interval,
+ * latency and supervision timeout the update ends with. The update also
+ * ends if the connection is lost. All other lines are skipped.
+ * ArduinoBLE only takes one debug stream, the HCI dump is not available
+ * while the tap is attached.
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#ifndef HCI_EVENT_TAP_HPP
+#define HCI_EVENT_TAP_HPP
+
+#include <Arduino.h>
+
+// Longest event kept in bytes. The events of interest are at most 13 bytes long, longer packets are skipped.
+#define HCI_EVENT_TAP_MAX_PACKET 40
+
+// Handle while no update is expected. Valid handles only use 12 bits.
+#define HCI_EVENT_TAP_NO_HANDLE 0xFFFF
+
+class HCIEventTap : public Stream
+{
+    public:
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Constructor.
+    //
+    HCIEventTap();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Starts waiting for the end of a connection parameter update. Call it before the update is requested, so the
+    /// event cannot be missed.
+    ///
+    /// @param handle       The handle of the connection the update is requested for.
+    //
+    void expectUpdate(uint16_t handle);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns true from expectUpdate() until the update complete or the disconnection complete event of the
+    /// connection.
+    //
+    bool isPending();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns true if the last update completed successfully. False while it is pending, if the controller reported
+    /// a failure or if the connection was lost.
+    //
+    bool isUpdated();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the parameters the connection runs with after the last update, as reported by its connection update
+    /// complete event. Only valid while isUpdated() is true.
+    //
+    uint16_t getConnectionInterval();       // In 1.25ms
+    uint16_t getConnectionLatency();
+    uint16_t getSupervisionTimeout();       // In 10ms
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Takes the next character of the HCI dump.
+    //
+    size_t write(uint8_t value) override;
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// The tap has nothing to read.
+    //
+    int available() override;
+    int read() override;
+    int peek() override;
+
+    private:
+    uint8_t _packet[HCI_EVENT_TAP_MAX_PACKET];
+    uint8_t _packet_length;
+    uint8_t _prefix_length;
+    bool _skip_line;
+    int8_t _high_nibble;
+
+    uint16_t _handle;
+    bool _pending;
+    bool _updated;
+    uint16_t _interval;
+    uint16_t _latency;
+    uint16_t _supervision_timeout;
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Ends the pending update on a complete event packet of its connection, starting with the packet type.
+    //
+    void __handlePacket();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Reads a little endian value from a packet.
+    //
+    static uint16_t __readUint16(const uint8_t data[]);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Converts a hex digit into its value.
+    ///
+    /// @return The value or -1 if the character is no hex digit.
+    //
+    static int8_t __hexValue(uint8_t character);
+};
+
+#endif // HCI_EVENT_TAP_HPP
@@ -0,0 +1,164 @@
+/**********************************************************************
+ * HIDKeycodes.hpp
+ * 
+ * Keyboard usage IDs and modifier bits of the HID usage tables, and a
+ * compile time lookup table from ASCII characters to usage IDs. The
+ * table follows the US keyboard layout. Characters which need shift on
+ * that layout carry MOD_LEFT_SHIFT as implied modifier.
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#ifndef HIDKEYCODES_HPP
+#define HIDKEYCODES_HPP
+
+#include <Arduino.h>
+
+#define MOD_NONE 0x00
+#define MOD_LEFT_CTR 0x01
+#define MOD_LEFT_SHIFT 0x02
+#define MOD_LEFT_ALT 0x04
+#define MOD_LEFT_GUI 0x08
+#define MOD_RIGHT_CTR 0x10
+#define MOD_RIGHT_SHIFT 0x20
+#define MOD_RIGHT_ALT 0x40
+#define MOD_RIGHT_GUI 0x80
+
+// Usage IDs of the keyboard page. Letters and digits are best given as chars, see asciiToKey().
+#define KEY_NONE 0x00
+#define KEY_A 0x04
+#define KEY_Z 0x1D
+#define KEY_1 0x1E
+#define KEY_0 0x27
+#define KEY_ENTER 0x28
+#define KEY_ESCAPE 0x29
+#define KEY_BACKSPACE 0x2A
+#define KEY_TAB 0x2B
+#define KEY_SPACE 0x2C
+#define KEY_MINUS 0x2D
+#define KEY_EQUAL 0x2E
+#define KEY_LEFT_BRACKET 0x2F
+#define KEY_RIGHT_BRACKET 0x30
+#define KEY_BACKSLASH 0x31
+#define KEY_SEMICOLON 0x33
+#define KEY_APOSTROPHE 0x34
+#define KEY_GRAVE 0x35
+#define KEY_COMMA 0x36
+#define KEY_DOT 0x37
+#define KEY_SLASH 0x38
+#define KEY_CAPS_LOCK 0x39
+#define KEY_F1 0x3A
+#define KEY_F2 0x3B
+#define KEY_F3 0x3C
+#define KEY_F4 0x3D
+#define KEY_F5 0x3E
+#define KEY_F6 0x3F
+#define KEY_F7 0x40
+#define KEY_F8 0x41
+#define KEY_F9 0x42
+#define KEY_F10 0x43
+#define KEY_F11 0x44
+#define KEY_F12 0x45
+#define KEY_PRINT_SCREEN 0x46
+#define KEY_SCROLL_LOCK 0x47
+#define KEY_PAUSE 0x48
+#define KEY_INSERT 0x49
+#define KEY_HOME 0x4A
+#define KEY_PAGE_UP 0x4B
+#define KEY_DELETE 0x4C
+#define KEY_END 0x4D
+#define KEY_PAGE_DOWN 0x4E
+#define KEY_RIGHT 0x4F
+#define KEY_LEFT 0x50
+#define KEY_DOWN 0x51
+#define KEY_UP 0x52
+#define KEY_NUM_LOCK 0x53
+#define KEY_APPLICATION 0x65
+
+// Highest usage ID the report descriptor allows in the key array
+#define HID_KEYCODE_MAX 0x65
+
+#define HID_ASCII_N 128
+#define HID_ASCII_SHIFT 0x80    // Flag in the ASCII table marking characters which need shift
+
+//-----------------------------------------------------------------------------------------------------------------
+///
+/// A key of the keyboard page together with the modifiers it needs.
+//
+struct HIDKey
+{
+    uint8_t keycode;
+    uint8_t modifier;
+};
+
+//-----------------------------------------------------------------------------------------------------------------
+///
+/// The lookup table from ASCII to usage IDs. Entry c holds the usage ID of character c, or'ed with HID_ASCII_SHIFT if
+/// the character needs shift. Characters without a key are KEY_NONE.
+//
+struct HIDAsciiMap
+{
+    uint8_t usage[HID_ASCII_N];
+};
+
+//-----------------------------------------------------------------------------------------------------------------
+///
+/// Computes the ASCII lookup table for the US layout.
+//
+constexpr HIDAsciiMap makeHIDAsciiMap()
+{
+    HIDAsciiMap map{};
+    for(int i = 0; i < 26; i++)
+    {
+        map.usage['a' + i] = KEY_A + i;
+        map.usage['A' + i] = (KEY_A + i) | HID_ASCII_SHIFT;
+    }
+    for(int i = 0; i < 9; i++)
+        map.usage['1' + i] = KEY_1 + i;
+    map.usage['0'] = KEY_0;
+
+    // Shifted digit row
+    const char shifted_digits[] = "!@#$%^&*()";
+    for(int i = 0; i < 10; i++)
+        map.usage[(uint8_t)shifted_digits[i]] = (KEY_1 + i) | HID_ASCII_SHIFT;
+
+    map.usage['\b'] = KEY_BACKSPACE;
+    map.usage['\t'] = KEY_TAB;
+    map.usage['\n'] = KEY_ENTER;
+    map.usage['\r'] = KEY_ENTER;
+    map.usage[0x1B] = KEY_ESCAPE;
+    map.usage[' '] = KEY_SPACE;
+    map.usage[0x7F] = KEY_DELETE;
+
+    // Punctuation, unshifted and shifted character of each key
+    const char plain[] = "-=[]\\;'`,./";
+    const char shifted[] = "_+{}|:\"~<>?";
+    const uint8_t keys[] = {KEY_MINUS, KEY_EQUAL, KEY_LEFT_BRACKET, KEY_RIGHT_BRACKET, KEY_BACKSLASH, KEY_SEMICOLON,
+                            KEY_APOSTROPHE, KEY_GRAVE, KEY_COMMA, KEY_DOT, KEY_SLASH};
+    for(int i = 0; i < 11; i++)
+    {
+        map.usage[(uint8_t)plain[i]] = keys[i];
+        map.usage[(uint8_t)shifted[i]] = keys[i] | HID_ASCII_SHIFT;
+    }
+    return map;
+}
+
+constexpr HIDAsciiMap HID_ASCII_MAP = makeHIDAsciiMap();
+
+//-----------------------------------------------------------------------------------------------------------------
+///
+/// Looks up the key of an ASCII character.
+///
+/// @param c            The character.
+///
+/// @return The key and its implied modifiers. The keycode is KEY_NONE if the character has no key.
+//
+constexpr HIDKey asciiToKey(char c)
+{
+    return (uint8_t)c >= HID_ASCII_N ? HIDKey{KEY_NONE, MOD_NONE}
+         : HIDKey{(uint8_t)(HID_ASCII_MAP.usage[(uint8_t)c] & ~HID_ASCII_SHIFT),
+                  (uint8_t)(HID_ASCII_MAP.usage[(uint8_t)c] & HID_ASCII_SHIFT ? MOD_LEFT_SHIFT : MOD_NONE)};
+}
+
+#endif // HIDKEYCODES_HPP
@@ -0,0 +1,171 @@
+/**********************************************************************
+ * I2CTransfer.cpp
+ * 
+ * Implementation of the I2CTransfer class.
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#include "I2CTransfer.hpp"
+
+// Bus phases of a transfer
+#define __PHASE_ADDRESSING 0
+#define __PHASE_REQUESTING 1
+#define __PHASE_RECEIVING 2
+
+//-----------------------------------------------------------------------------------------------------------------
+I2CTransfer::I2CTransfer(uint8_t address) :
+_address{address},
+_state{I2C_TRANSFER_IDLE},
+_phase{__PHASE_ADDRESSING},
+_last_error{I2C_ERROR_NONE},
+_reg{0},
+_buffer{nullptr},
+_len{0},
+_received{0},
+_start_time{0},
+_timeout_us{I2C_DEFAULT_TIMEOUT_US},
+_callback{nullptr},
+_callback_context{nullptr}
+{
+    resetErrorCounters();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool I2CTransfer::start(uint8_t reg, uint8_t buffer[], uint16_t len)
+{
+    if(_state == I2C_TRANSFER_BUSY)
+        return false;
+
+    _reg = reg;
+    _buffer = buffer;
+    _len = len;
+    _received = 0;
+    _phase = __PHASE_ADDRESSING;
+    _state = I2C_TRANSFER_BUSY;
+    _start_time = micros();
+    return true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint8_t I2CTransfer::poll()
+{
+    if(_state != I2C_TRANSFER_BUSY)
+        return _state;
+
+    switch(_phase)
+    {
+        case __PHASE_ADDRESSING:
+            Wire.beginTransmission(_address);
+            Wire.write(_reg);
+            if(Wire.endTransmission(false) != 0)
+            {
+                __finish(I2C_ERROR_NAK);
+                return _state;
+            }
+            _phase = __PHASE_REQUESTING;
+            break;
+
+        case __PHASE_REQUESTING:
+            if(Wire.requestFrom((int)_address, (int)_len) == 0)
+            {
+                __finish(I2C_ERROR_NAK);
+                return _state;
+            }
+            _phase = __PHASE_RECEIVING;
+            break;
+
+        case __PHASE_RECEIVING:
+            while(Wire.available() && _received < _len)
+            {
+                _buffer[_received] = Wire.read();
+                _received++;
+            }
+            if(_received == _len)
+            {
+                __finish(I2C_ERROR_NONE);
+                return _state;
+            }
+            break;
+    }
+
+    if(_state == I2C_TRANSFER_BUSY && (uint32_t)(micros() - _start_time) > _timeout_us)
+        __finish(_received > 0 ? I2C_ERROR_SHORT_READ : I2C_ERROR_TIMEOUT);
+
+    return _state;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint16_t I2CTransfer::run(uint8_t reg, uint8_t buffer[], uint16_t len)
+{
+    if(!start(reg, buffer, len))
+        return 0;
+
+    while(poll() == I2C_TRANSFER_BUSY);
+    return _received;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void I2CTransfer::setTimeout(uint32_t timeout_us)
+{
+    _timeout_us = timeout_us;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void I2CTransfer::setCallback(I2CTransferCallback callback, void* context)
+{
+    _callback = callback;
+    _callback_context = context;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint8_t I2CTransfer::getState()
+{
+    return _state;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint8_t I2CTransfer::getLastError()
+{
+    return _last_error;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint16_t I2CTransfer::getReceived()
+{
+    return _received;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint32_t I2CTransfer::getErrorCount(uint8_t error)
+{
+    if(error >= I2C_ERROR_TYPES)
+        return 0;
+
+    return _error_counts[error];
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void I2CTransfer::resetErrorCounters()
+{
+    for(int i = 0; i < I2C_ERROR_TYPES; i++)
+        _error_counts[i] = 0;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void I2CTransfer::__finish(uint8_t error)
+{
+    _last_error = error;
+    _state = (error == I2C_ERROR_NONE) ? I2C_TRANSFER_DONE : I2C_TRANSFER_ERROR;
+    if(error != I2C_ERROR_NONE)
+    {
+        _error_counts[error]++;
+        // Drop whatever a truncated read left in the receive buffer
+        while(Wire.available())
+            Wire.read();
+    }
+
+    if(_callback)
+        _callback(*this, _callback_context);
+}
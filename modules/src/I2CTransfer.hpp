@@ -0,0 +1,160 @@
+/**********************************************************************
+ * I2CTransfer.hpp
+ * 
+ * A small state machine to read a register block from an I2C device
+ * without blocking the main loop. A transfer is started once and then
+ * advanced by polling it regularly. Every poll performs at most one
+ * bus phase (addressing, requesting, receiving), so other work can be
+ * done in between. Transfers which do not finish in time are aborted
+ * and counted as errors instead of hanging the system.
+ * Workflow:
+ *   1. Start a transfer with start()
+ *   2. Call poll() until it does not return I2C_TRANSFER_BUSY anymore
+ *   3. Use the received bytes in the given buffer
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#ifndef I2CTRANSFER_HPP
+#define I2CTRANSFER_HPP
+
+#include <Arduino.h>
+#include <Wire.h>
+
+// Transfer states
+#define I2C_TRANSFER_IDLE 0
+#define I2C_TRANSFER_BUSY 1
+#define I2C_TRANSFER_DONE 2
+#define I2C_TRANSFER_ERROR 3
+
+// Error types
+#define I2C_ERROR_NONE 0
+#define I2C_ERROR_NAK 1
+#define I2C_ERROR_SHORT_READ 2
+#define I2C_ERROR_TIMEOUT 3
+#define I2C_ERROR_TYPES 4
+
+#define I2C_DEFAULT_TIMEOUT_US 2000
+
+class I2CTransfer;
+
+typedef void (*I2CTransferCallback)(I2CTransfer& transfer, void* context);
+
+class I2CTransfer
+{
+    public:
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Constructor.
+    ///
+    /// @param address      The I2C address of the device to read from.
+    //
+    I2CTransfer(uint8_t address);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Starts reading a block of registers. Is ignored if another transfer is still busy.
+    ///
+    /// @param reg          The register to start reading from.
+    /// @param buffer       The buffer to write the received bytes to. Must stay valid until the transfer finished.
+    /// @param len          The number of bytes to read.
+    ///
+    /// @return True if the transfer was started.
+    //
+    bool start(uint8_t reg, uint8_t buffer[], uint16_t len);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Advances the transfer by at most one bus phase. Calls the callback once the transfer finished or failed.
+    ///
+    /// @return The current state of the transfer (see macros above).
+    //
+    uint8_t poll();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Starts a transfer and polls it until it finished. Still bounded by the timeout.
+    ///
+    /// @param reg          The register to start reading from.
+    /// @param buffer       The buffer to write the received bytes to.
+    /// @param len          The number of bytes to read.
+    ///
+    /// @return The number of bytes received.
+    //
+    uint16_t run(uint8_t reg, uint8_t buffer[], uint16_t len);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Sets the time after which a started transfer is aborted.
+    ///
+    /// @param timeout_us   The timeout in microseconds.
+    //
+    void setTimeout(uint32_t timeout_us);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Sets a function which is called from poll() whenever a transfer finished or failed.
+    ///
+    /// @param callback     The function to call. nullptr disables the callback.
+    /// @param context      A pointer which is passed on to the callback unchanged.
+    //
+    void setCallback(I2CTransferCallback callback, void* context);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the current state of the transfer (see macros above).
+    //
+    uint8_t getState();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the error of the last failed transfer (see macros above).
+    //
+    uint8_t getLastError();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the number of bytes received by the last transfer.
+    //
+    uint16_t getReceived();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns how often a certain error occured since the last reset of the counters.
+    ///
+    /// @param error        The error type (see macros above).
+    //
+    uint32_t getErrorCount(uint8_t error);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Resets all error counters to 0.
+    //
+    void resetErrorCounters();
+
+    private:
+    uint8_t _address;
+    uint8_t _state;
+    uint8_t _phase;
+    uint8_t _last_error;
+    uint8_t _reg;
+    uint8_t* _buffer;
+    uint16_t _len;
+    uint16_t _received;
+    uint32_t _start_time;
+    uint32_t _timeout_us;
+    uint32_t _error_counts[I2C_ERROR_TYPES];
+    I2CTransferCallback _callback;
+    void* _callback_context;
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Ends the current transfer with the given error and notifies the callback.
+    ///
+    /// @param error        The error type (see macros above), I2C_ERROR_NONE for success.
+    //
+    void __finish(uint8_t error);
+};
+
+#endif // I2CTRANSFER_HPP
@@ -0,0 +1,96 @@
+/**********************************************************************
+ * LatencyStats.cpp
+ * 
+ * Implementation of the LatencyStats class.
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#include "LatencyStats.hpp"
+
+//-----------------------------------------------------------------------------------------------------------------
+LatencyStats::LatencyStats()
+{
+    reset();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void LatencyStats::record(uint32_t latency_us)
+{
+    uint32_t bucket = latency_us / LATENCY_BUCKET_US;
+    if(bucket >= LATENCY_BUCKET_N)
+        bucket = LATENCY_BUCKET_N - 1;
+
+    if(_buckets[bucket] == UINT16_MAX)
+    {
+        for(uint16_t i = 0; i < LATENCY_BUCKET_N; i++)
+            _buckets[i] /= 2;
+    }
+
+    _buckets[bucket]++;
+    _count++;
+    if(latency_us > _max)
+        _max = latency_us;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint32_t LatencyStats::getPercentile(float fraction)
+{
+    uint32_t total = 0;
+    for(uint16_t i = 0; i < LATENCY_BUCKET_N; i++)
+        total += _buckets[i];
+    if(total == 0)
+        return 0;
+
+    uint32_t target = (uint32_t)(fraction * total);
+    uint32_t seen = 0;
+    for(uint16_t i = 0; i < LATENCY_BUCKET_N - 1; i++)
+    {
+        seen += _buckets[i];
+        if(seen > target)
+        {
+            uint32_t bound = (uint32_t)(i + 1) * LATENCY_BUCKET_US;
+            return bound < _max ? bound : _max;
+        }
+    }
+    return _max;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint32_t LatencyStats::getCount()
+{
+    return _count;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint32_t LatencyStats::getMax()
+{
+    return _max;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void LatencyStats::reset()
+{
+    for(uint16_t i = 0; i < LATENCY_BUCKET_N; i++)
+        _buckets[i] = 0;
+    _count = 0;
+    _max = 0;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void LatencyStats::print(Print& output, const char* name)
+{
+    output.print(name);
+    output.print(": n ");
+    output.print(_count);
+    output.print(" | p50 ");
+    output.print(getPercentile(0.5f));
+    output.print(" | p95 ");
+    output.print(getPercentile(0.95f));
+    output.print(" | p99 ");
+    output.print(getPercentile(0.99f));
+    output.print(" | max ");
+    output.print(_max);
+    output.println(" us");
+}
@@ -0,0 +1,88 @@
+/**********************************************************************
+ * LatencyStats.hpp
+ * 
+ * A histogram of latencies in microseconds with fixed size buckets, to
+ * get percentiles like p50/p95/p99 over long runs in constant memory.
+ * Latencies beyond the last bucket are counted in the last bucket. Once
+ * a bucket is about to overflow, all buckets are halved, so the shape
+ * of the distribution and thereby the percentiles stay valid.
+ * The histograms of the sample to report path in the BMI160 and BLE_HID
+ * classes are only compiled in if ENABLE_LATENCY_TRACING is defined
+ * below, as each one takes about 520 bytes of RAM.
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#ifndef LATENCYSTATS_HPP
+#define LATENCYSTATS_HPP
+
+#include <Arduino.h>
+
+// Uncomment to trace the latency from IMU sample to mouse report in the BMI160 and BLE_HID classes.
+//#define ENABLE_LATENCY_TRACING
+
+#define LATENCY_BUCKET_US 250
+#define LATENCY_BUCKET_N 256        // Covers 0 to 64 ms
+
+class LatencyStats
+{
+    public:
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Constructor.
+    //
+    LatencyStats();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Adds one latency to the histogram.
+    ///
+    /// @param latency_us   The latency in microseconds.
+    //
+    void record(uint32_t latency_us);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns a percentile of the recorded latencies, rounded up to the end of its bucket (at most the maximum).
+    ///
+    /// @param fraction     The percentile as fraction, e.g. 0.95 for p95.
+    ///
+    /// @return The latency in microseconds.
+    //
+    uint32_t getPercentile(float fraction);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the number of recorded latencies.
+    //
+    uint32_t getCount();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the largest recorded latency in microseconds.
+    //
+    uint32_t getMax();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Clears the histogram.
+    //
+    void reset();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Prints count, p50, p95, p99 and maximum in one line.
+    ///
+    /// @param output       Where to print to, usually Serial.
+    /// @param name         The name printed in front.
+    //
+    void print(Print& output, const char* name);
+
+    private:
+    uint16_t _buckets[LATENCY_BUCKET_N];
+    uint32_t _count;
+    uint32_t _max;
+};
+
+#endif // LATENCYSTATS_HPP
@@ -0,0 +1,169 @@
+/**********************************************************************
+ * MacroSequencer.cpp
+ * 
+ * Implementation of the MacroSequencer class.
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#include "MacroSequencer.hpp"
+
+//-----------------------------------------------------------------------------------------------------------------
+MacroSequencer::MacroSequencer() :
+_held_key_n{0},
+_modifier{MOD_NONE},
+_waiting{false},
+_wait_start{0},
+_wait_us{0},
+_release_pending{false},
+_hold_step{MACRO_WAIT, KEY_NONE, MOD_NONE, 0}
+{ }
+
+//-----------------------------------------------------------------------------------------------------------------
+bool MacroSequencer::queue(const MacroStep steps[], uint16_t step_n)
+{
+    if(step_n > getFreeSteps())
+        return false;
+
+    for(uint16_t i = 0; i < step_n; i++)
+        _steps.push(steps[i]);
+    return true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint16_t MacroSequencer::getFreeSteps()
+{
+    return MACRO_QUEUE_N - _steps.size();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool MacroSequencer::tick(uint32_t now_us)
+{
+    if(_waiting)
+    {
+        if(now_us - _wait_start < _wait_us)
+            return false;
+        _waiting = false;
+    }
+
+    if(_release_pending)
+    {
+        _release_pending = false;
+        __release(_hold_step.keycode, _hold_step.modifier);
+        return true;
+    }
+
+    MacroStep step;
+    if(!_steps.pop(step))
+    {
+        if(_held_key_n == 0 && _modifier == MOD_NONE)
+            return false;
+
+        // A macro must not leave anything held once it is done
+        _held_key_n = 0;
+        _modifier = MOD_NONE;
+        return true;
+    }
+
+    switch(step.action)
+    {
+        case MACRO_PRESS:
+            __press(step.keycode, step.modifier);
+            return true;
+
+        case MACRO_HOLD:
+            __press(step.keycode, step.modifier);
+            __startWait(now_us, step.duration_ms);
+            _hold_step = step;
+            _release_pending = true;
+            return true;
+
+        case MACRO_RELEASE:
+            __release(step.keycode, step.modifier);
+            return true;
+
+        default:
+            __startWait(now_us, step.duration_ms);
+            return false;
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void MacroSequencer::reset()
+{
+    MacroStep step;
+    while(_steps.pop(step));
+    _held_key_n = 0;
+    _modifier = MOD_NONE;
+    _waiting = false;
+    _release_pending = false;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool MacroSequencer::isActive()
+{
+    return !_steps.empty() || _waiting || _release_pending || _held_key_n > 0 || _modifier != MOD_NONE;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint8_t MacroSequencer::getHeldKeyCount()
+{
+    return _held_key_n;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint8_t MacroSequencer::getHeldKey(uint8_t index)
+{
+    if(index >= _held_key_n)
+        return KEY_NONE;
+
+    return _held_keys[index];
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint8_t MacroSequencer::getModifier()
+{
+    return _modifier;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void MacroSequencer::__press(uint8_t keycode, uint8_t modifier)
+{
+    _modifier |= modifier;
+
+    if(keycode == KEY_NONE || _held_key_n >= MACRO_MAX_KEYS)
+        return;
+
+    for(uint8_t i = 0; i < _held_key_n; i++)
+    {
+        if(_held_keys[i] == keycode)
+            return;
+    }
+    _held_keys[_held_key_n] = keycode;
+    _held_key_n++;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void MacroSequencer::__release(uint8_t keycode, uint8_t modifier)
+{
+    _modifier &= ~modifier;
+
+    for(uint8_t i = 0; i < _held_key_n; i++)
+    {
+        if(_held_keys[i] == keycode)
+        {
+            _held_key_n--;
+            _held_keys[i] = _held_keys[_held_key_n];
+            return;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void MacroSequencer::__startWait(uint32_t now_us, uint16_t duration_ms)
+{
+    _waiting = true;
+    _wait_start = now_us;
+    _wait_us = (uint32_t)duration_ms * 1000;
+}
@@ -0,0 +1,199 @@
+/**********************************************************************
+ * MacroSequencer.hpp
+ * 
+ * Plays back keyboard macros step by step without blocking. A macro is
+ * a list of timed steps (press, hold, release, wait) which can be
+ * defined at compile time with the helper functions below. Queued
+ * steps are copied into a fixed size queue, so no memory is allocated.
+ * Every tick executes at most one step, so every step results in its
+ * own keyboard report.
+ * Workflow:
+ *   1. Queue macros with queue()
+ *   2. Call tick() once per keyboard report
+ *   3. Build the report from the held keys and modifiers
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#ifndef MACROSEQUENCER_HPP
+#define MACROSEQUENCER_HPP
+
+#include <Arduino.h>
+#include "HIDKeycodes.hpp"
+#include "SPSCRing.hpp"
+
+// Number of steps which can wait in the queue, has to be a power of two
+#define MACRO_QUEUE_N 64
+
+// Number of keys a macro can hold at once, same as a keyboard report
+#define MACRO_MAX_KEYS 6
+
+#define MACRO_PRESS 0       // Presses the key and keeps it held
+#define MACRO_HOLD 1        // Presses the key and releases it after the duration
+#define MACRO_RELEASE 2     // Releases the key
+#define MACRO_WAIT 3        // Does nothing for the duration
+
+//-----------------------------------------------------------------------------------------------------------------
+///
+/// One step of a macro. Modifiers are pressed and released together with the key, a step with KEY_NONE only presses
+/// or releases the modifiers.
+//
+struct MacroStep
+{
+    uint8_t action;
+    uint8_t keycode;
+    uint8_t modifier;
+    uint16_t duration_ms;
+};
+
+//-----------------------------------------------------------------------------------------------------------------
+///
+/// Helpers to define macros, e.g.
+///     constexpr MacroStep MACRO_COPY[] = {macroPress(KEY_NONE, MOD_LEFT_CTR), macroHold('c', 20),
+///                                         macroRelease(KEY_NONE, MOD_LEFT_CTR)};
+/// Keys are given either as usage ID (KEY_ macros) or as character, which is looked up with asciiToKey() and adds its
+/// implied modifiers. The usage ID overloads take an int, so a character never ends up there as usage ID: 'a' as usage
+/// ID would be 0x61 instead of KEY_A.
+//
+constexpr MacroStep macroPress(int keycode, uint8_t modifier = MOD_NONE)
+{
+    return MacroStep{MACRO_PRESS, (uint8_t)keycode, modifier, 0};
+}
+
+constexpr MacroStep macroPress(char c, uint8_t modifier = MOD_NONE)
+{
+    return MacroStep{MACRO_PRESS, asciiToKey(c).keycode, (uint8_t)(asciiToKey(c).modifier | modifier), 0};
+}
+
+constexpr MacroStep macroHold(int keycode, uint8_t modifier, uint16_t duration_ms)
+{
+    return MacroStep{MACRO_HOLD, (uint8_t)keycode, modifier, duration_ms};
+}
+
+constexpr MacroStep macroHold(char c, uint8_t modifier, uint16_t duration_ms)
+{
+    return MacroStep{MACRO_HOLD, asciiToKey(c).keycode, (uint8_t)(asciiToKey(c).modifier | modifier), duration_ms};
+}
+
+constexpr MacroStep macroHold(char c, uint16_t duration_ms = 0)
+{
+    return MacroStep{MACRO_HOLD, asciiToKey(c).keycode, asciiToKey(c).modifier, duration_ms};
+}
+
+constexpr MacroStep macroRelease(int keycode, uint8_t modifier = MOD_NONE)
+{
+    return MacroStep{MACRO_RELEASE, (uint8_t)keycode, modifier, 0};
+}
+
+constexpr MacroStep macroRelease(char c, uint8_t modifier = MOD_NONE)
+{
+    return MacroStep{MACRO_RELEASE, asciiToKey(c).keycode, (uint8_t)(asciiToKey(c).modifier | modifier), 0};
+}
+
+constexpr MacroStep macroWait(uint16_t duration_ms)
+{
+    return MacroStep{MACRO_WAIT, KEY_NONE, MOD_NONE, duration_ms};
+}
+
+class MacroSequencer
+{
+    public:
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Constructor.
+    //
+    MacroSequencer();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Queues the steps of a macro behind the already queued ones.
+    ///
+    /// @param steps        The steps of the macro.
+    /// @param step_n       The number of steps.
+    ///
+    /// @return False if the queue has not enough space left, nothing is queued in that case.
+    //
+    bool queue(const MacroStep steps[], uint16_t step_n);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns how many more steps fit into the queue.
+    //
+    uint16_t getFreeSteps();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Executes the next step if the current one is done. Steps are only as exact as the ticks, durations are rounded
+    /// up to the next tick. Keys still held when the queue runs empty are released in an additional tick.
+    ///
+    /// @param now_us       The current time in microseconds.
+    ///
+    /// @return True if the held keys or modifiers changed.
+    //
+    bool tick(uint32_t now_us);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Drops all queued steps and releases all keys.
+    //
+    void reset();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns true as long as steps are queued, a step is in progress or keys are held.
+    //
+    bool isActive();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the number of keys held right now.
+    //
+    uint8_t getHeldKeyCount();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns a key held right now.
+    ///
+    /// @param index        The index of the key, below getHeldKeyCount().
+    //
+    uint8_t getHeldKey(uint8_t index);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the modifiers held right now.
+    //
+    uint8_t getModifier();
+
+    private:
+    SPSCRing<MacroStep, MACRO_QUEUE_N> _steps;
+    uint8_t _held_keys[MACRO_MAX_KEYS];
+    uint8_t _held_key_n;
+    uint8_t _modifier;
+
+    bool _waiting;
+    uint32_t _wait_start;
+    uint32_t _wait_us;
+    bool _release_pending;          // True while a hold step waits to release its key
+    MacroStep _hold_step;
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Adds a key and its modifiers to the held ones.
+    //
+    void __press(uint8_t keycode, uint8_t modifier);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Removes a key and its modifiers from the held ones.
+    //
+    void __release(uint8_t keycode, uint8_t modifier);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Starts waiting for the given duration.
+    //
+    void __startWait(uint32_t now_us, uint16_t duration_ms);
+};
+
+#endif // MACROSEQUENCER_HPP
@@ -0,0 +1,200 @@
+/**********************************************************************
+ * MatrixIO.cpp
+ * 
+ * Implementation of the MatrixIO class.
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#include "MatrixIO.hpp"
+
+#ifdef MATRIX_IO_PORT_ACCESS
+#include "pinDefinitions.h"
+#endif
+
+MatrixIO* MatrixIO::_isr_instance = nullptr;
+
+//-----------------------------------------------------------------------------------------------------------------
+MatrixIO::MatrixIO() :
+_row_n{0},
+_col_n{0},
+_woken{false},
+_wake_time{0}
+{
+#ifdef MATRIX_IO_PORT_ACCESS
+    _col_port_used[0] = false;
+    _col_port_used[1] = false;
+#endif
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+int8_t MatrixIO::addRowPin(uint8_t pin)
+{
+    if(_row_n >= MATRIX_IO_MAX_PINS)
+        return -1;
+
+    _row_pins[_row_n] = pin;
+    pinMode(pin, INPUT);
+
+#ifdef MATRIX_IO_PORT_ACCESS
+    uint8_t port_index;
+    uint8_t shift;
+    _row_ports[_row_n] = __pinToPort(pin, port_index, shift);
+    _row_masks[_row_n] = (uint32_t)1 << shift;
+
+    // The output latch stays low, selecting a row only switches its direction
+    _row_ports[_row_n]->OUTCLR = _row_masks[_row_n];
+#endif
+
+    _row_n++;
+    return _row_n - 1;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+int8_t MatrixIO::addColPin(uint8_t pin)
+{
+    if(_col_n >= MATRIX_IO_MAX_PINS)
+        return -1;
+
+    _col_pins[_col_n] = pin;
+    pinMode(pin, INPUT_PULLUP);
+
+#ifdef MATRIX_IO_PORT_ACCESS
+    __pinToPort(pin, _col_ports[_col_n], _col_shifts[_col_n]);
+    _col_port_used[_col_ports[_col_n]] = true;
+#endif
+
+    _col_n++;
+    return _col_n - 1;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void MatrixIO::selectRow(uint8_t row)
+{
+#ifdef MATRIX_IO_PORT_ACCESS
+    _row_ports[row]->DIRSET = _row_masks[row];
+#else
+    pinMode(_row_pins[row], OUTPUT);
+    digitalWrite(_row_pins[row], LOW);
+#endif
+    delayMicroseconds(MATRIX_IO_SETTLE_US);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void MatrixIO::releaseRow(uint8_t row)
+{
+#ifdef MATRIX_IO_PORT_ACCESS
+    _row_ports[row]->DIRCLR = _row_masks[row];
+#else
+    pinMode(_row_pins[row], INPUT);
+#endif
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint8_t MatrixIO::readCols()
+{
+    uint8_t cols = 0;
+
+#ifdef MATRIX_IO_PORT_ACCESS
+    uint32_t in[2];
+    in[0] = _col_port_used[0] ? NRF_P0->IN : 0;
+    in[1] = _col_port_used[1] ? NRF_P1->IN : 0;
+
+    for(uint8_t col = 0; col < _col_n; col++)
+    {
+        if(!((in[_col_ports[col]] >> _col_shifts[col]) & 1))
+            cols |= 1 << col;
+    }
+#else
+    for(uint8_t col = 0; col < _col_n; col++)
+    {
+        if(digitalRead(_col_pins[col]) == LOW)
+            cols |= 1 << col;
+    }
+#endif
+
+    return cols;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void MatrixIO::armWake()
+{
+    _woken = false;
+    _isr_instance = this;
+
+    for(uint8_t row = 0; row < _row_n; row++)
+    {
+#ifdef MATRIX_IO_PORT_ACCESS
+        _row_ports[row]->DIRSET = _row_masks[row];
+#else
+        pinMode(_row_pins[row], OUTPUT);
+        digitalWrite(_row_pins[row], LOW);
+#endif
+    }
+    delayMicroseconds(MATRIX_IO_SETTLE_US);
+
+    for(uint8_t col = 0; col < _col_n; col++)
+        attachInterrupt(digitalPinToInterrupt(_col_pins[col]), __wakeISR, FALLING);
+
+    // A button pressed before the interrupts were attached does not produce an edge anymore
+    if(!_woken && readCols() != 0)
+    {
+        _wake_time = micros();
+        _woken = true;
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void MatrixIO::disarmWake()
+{
+    for(uint8_t col = 0; col < _col_n; col++)
+        detachInterrupt(digitalPinToInterrupt(_col_pins[col]));
+
+    for(uint8_t row = 0; row < _row_n; row++)
+        releaseRow(row);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool MatrixIO::checkWake(uint32_t& wake_time)
+{
+    if(!_woken)
+        return false;
+
+    wake_time = _wake_time;
+    return true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint8_t MatrixIO::getRowCount()
+{
+    return _row_n;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint8_t MatrixIO::getColCount()
+{
+    return _col_n;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void MatrixIO::__wakeISR()
+{
+    if(_isr_instance->_woken)
+        return;
+
+    _isr_instance->_wake_time = micros();
+    _isr_instance->_woken = true;
+}
+
+#ifdef MATRIX_IO_PORT_ACCESS
+//-----------------------------------------------------------------------------------------------------------------
+NRF_GPIO_Type* MatrixIO::__pinToPort(uint8_t pin, uint8_t& port_index, uint8_t& shift)
+{
+    // Pin names count the pins of P0 first (0 to 31), followed by the ones of P1
+    uint32_t pin_name = (uint32_t)digitalPinToPinName(pin);
+    port_index = pin_name >> 5;
+    shift = pin_name & 0x1F;
+    return port_index ? NRF_P1 : NRF_P0;
+}
+#endif
@@ -0,0 +1,155 @@
+/**********************************************************************
+ * MatrixIO.hpp
+ * 
+ * The pin access of the ButtonMatrix. Rows are driven low one at a
+ * time (open drain, floating when not selected) and all columns are
+ * sampled at once into a bitmask.
+ * On the nRF52840 the pins are accessed directly through the port
+ * registers, the masks are computed once when the pins are added. All
+ * other targets (and the host) use the portable Arduino functions.
+ * Define MATRIX_IO_PORTABLE to force the portable version.
+ * While the matrix is idle, all rows can be driven low together and the
+ * columns armed for a falling edge interrupt, so no scanning is needed
+ * until a button is pressed. Only one instance can be armed at a time.
+ * Every pin interrupt takes one of the eight GPIOTE channels of the
+ * nRF52840, which limits the number of columns to the channels the rest
+ * of the firmware leaves free.
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#ifndef MATRIXIO_HPP
+#define MATRIXIO_HPP
+
+#include <Arduino.h>
+
+#if defined(NRF52840_XXAA) && !defined(MATRIX_IO_PORTABLE)
+#define MATRIX_IO_PORT_ACCESS
+#endif
+
+// Maximum number of row and column pins
+#define MATRIX_IO_MAX_PINS 8
+
+// Time a column needs to follow a newly selected row
+#define MATRIX_IO_SETTLE_US 1
+
+// Pin interrupts which can be attached at once, one per GPIOTE channel
+#define MATRIX_IO_INTERRUPT_CHANNELS 8
+
+// Channels taken by other pin interrupts while the matrix is idle (the data ready interrupt of the BMI160)
+#define MATRIX_IO_RESERVED_CHANNELS 1
+
+class MatrixIO
+{
+    public:
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Constructor.
+    //
+    MatrixIO();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Adds the next row pin and leaves it floating.
+    ///
+    /// @return The index of the row or -1 if all rows are set already.
+    //
+    int8_t addRowPin(uint8_t pin);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Adds the next column pin and enables its pullup.
+    ///
+    /// @return The index of the column or -1 if all columns are set already.
+    //
+    int8_t addColPin(uint8_t pin);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Drives a row low and waits for the columns to settle.
+    //
+    void selectRow(uint8_t row);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Lets a row float again.
+    //
+    void releaseRow(uint8_t row);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Samples all columns at once.
+    ///
+    /// @return Bit i is set if column i reads low.
+    //
+    uint8_t readCols();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Drives all rows low and attaches an interrupt to every column, so any pressed button wakes the matrix. A button
+    /// which is already pressed while arming wakes it right away. Takes one GPIOTE channel per column until
+    /// disarmWake().
+    //
+    void armWake();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Detaches the column interrupts and lets all rows float again.
+    //
+    void disarmWake();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Checks if a column edge occurred since armWake().
+    ///
+    /// @param wake_time    The time of the edge in microseconds, only written if there was one.
+    ///
+    /// @return True if the matrix was woken.
+    //
+    bool checkWake(uint32_t& wake_time);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the number of row pins.
+    //
+    uint8_t getRowCount();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the number of column pins.
+    //
+    uint8_t getColCount();
+
+    private:
+    uint8_t _row_n;
+    uint8_t _col_n;
+    uint8_t _row_pins[MATRIX_IO_MAX_PINS];
+    uint8_t _col_pins[MATRIX_IO_MAX_PINS];
+
+    static MatrixIO* _isr_instance;
+    volatile bool _woken;
+    volatile uint32_t _wake_time;
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Interrupt service routine of the column pins. Remembers the time of the first edge.
+    //
+    static void __wakeISR();
+
+#ifdef MATRIX_IO_PORT_ACCESS
+    NRF_GPIO_Type* _row_ports[MATRIX_IO_MAX_PINS];
+    uint32_t _row_masks[MATRIX_IO_MAX_PINS];
+    uint8_t _col_ports[MATRIX_IO_MAX_PINS];     // 0 for P0, 1 for P1
+    uint8_t _col_shifts[MATRIX_IO_MAX_PINS];
+    bool _col_port_used[2];
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the port and the bit of an Arduino pin.
+    //
+    static NRF_GPIO_Type* __pinToPort(uint8_t pin, uint8_t& port_index, uint8_t& shift);
+#endif
+};
+
+#endif // MATRIXIO_HPP
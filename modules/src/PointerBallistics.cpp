@@ -0,0 +1,126 @@
+/**********************************************************************
+ * PointerBallistics.cpp
+ * 
+ * Implementation of the PointerBallistics class.
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#include "PointerBallistics.hpp"
+
+static constexpr PointerCurve __POINTER_CURVE = makePointerCurve();
+
+//-----------------------------------------------------------------------------------------------------------------
+PointerBallistics::PointerBallistics(int8_t max_step) :
+_max_step{max_step},
+_residual{0.0f, 0.0f},
+_sample_scale{1.0f},
+_dropped_pixels{0.0f},
+_sample_time{0},
+_sample_time_set{false}
+{ }
+
+//-----------------------------------------------------------------------------------------------------------------
+void PointerBallistics::addMotion(float velocity_x, float velocity_y, uint32_t sample_time)
+{
+    if(!_sample_time_set)
+    {
+        _sample_time = sample_time;
+        _sample_time_set = true;
+    }
+
+    float speed = sqrtf(velocity_x * velocity_x + velocity_y * velocity_y);
+    float gain = getGain(speed) * _sample_scale;
+
+    _residual[POINTER_X] += velocity_x * gain;
+    _residual[POINTER_Y] += velocity_y * gain;
+
+    for(int axis = 0; axis < 2; axis++)
+    {
+        if(_residual[axis] > POINTER_MAX_BACKLOG)
+        {
+            _dropped_pixels += _residual[axis] - POINTER_MAX_BACKLOG;
+            _residual[axis] = POINTER_MAX_BACKLOG;
+        }
+        if(_residual[axis] < -POINTER_MAX_BACKLOG)
+        {
+            _dropped_pixels += -POINTER_MAX_BACKLOG - _residual[axis];
+            _residual[axis] = -POINTER_MAX_BACKLOG;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool PointerBallistics::takeReport(int8_t& x, int8_t& y, uint32_t& sample_time)
+{
+    x = __takeAxis(POINTER_X);
+    y = __takeAxis(POINTER_Y);
+    sample_time = _sample_time;
+
+    // Samples which only added to the fraction are reported together with the ones that complete a pixel
+    if(x == 0 && y == 0)
+        return false;
+
+    _sample_time_set = false;
+    return true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void PointerBallistics::setSampleRate(float rate)
+{
+    _sample_scale = POINTER_REFERENCE_RATE / rate;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void PointerBallistics::reset()
+{
+    for(int axis = 0; axis < 2; axis++)
+    {
+        _dropped_pixels += fabsf(_residual[axis]);
+        _residual[axis] = 0.0f;
+    }
+    _sample_time_set = false;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+float PointerBallistics::getResidual(uint8_t axis)
+{
+    if(axis > POINTER_Y)
+        return 0.0f;
+
+    return _residual[axis];
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+float PointerBallistics::getDroppedPixels()
+{
+    return _dropped_pixels;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+float PointerBallistics::getGain(float speed)
+{
+    float position = speed / POINTER_CURVE_MAX_SPEED * (POINTER_CURVE_N - 1);
+    if(position >= POINTER_CURVE_N - 1)
+        return __POINTER_CURVE.gain[POINTER_CURVE_N - 1];
+
+    // Linear interpolation between the two closest entries
+    int index = (int)position;
+    float fraction = position - index;
+    return __POINTER_CURVE.gain[index] + (__POINTER_CURVE.gain[index + 1] - __POINTER_CURVE.gain[index]) * fraction;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+int8_t PointerBallistics::__takeAxis(uint8_t axis)
+{
+    // Truncate towards zero, the fraction stays in the residual
+    int16_t pixels = (int16_t)_residual[axis];
+    if(pixels > _max_step)
+        pixels = _max_step;
+    if(pixels < -_max_step)
+        pixels = -_max_step;
+
+    _residual[axis] -= pixels;
+    return (int8_t)pixels;
+}
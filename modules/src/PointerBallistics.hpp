@@ -0,0 +1,163 @@
+/**********************************************************************
+ * PointerBallistics.hpp
+ * 
+ * Maps the angular velocity of the wrist to cursor movement. The gain
+ * depends on the speed of the movement (pointer acceleration), so slow
+ * movements can aim precisely while fast movements cross the screen.
+ * The acceleration curve is computed at compile time into a lookup
+ * table. Fractions of pixels are never thrown away but kept per axis
+ * and added to the next report. Movement exceeding the maximum step of
+ * a report is carried over to the following reports as well.
+ * The gains are tuned for POINTER_REFERENCE_RATE samples per second.
+ * At other sample rates every sample moves proportionally less or more,
+ * so the cursor speed does not depend on the sample rate.
+ * Workflow:
+ *   1. Add the motion of every new sample with addMotion()
+ *   2. Take the whole pixels for a report with takeReport()
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#ifndef POINTERBALLISTICS_HPP
+#define POINTERBALLISTICS_HPP
+
+#include <Arduino.h>
+
+// Acceleration curve parameters
+#define POINTER_GAIN_LOW 120.0f         // Pixels per unit of velocity for slow movements
+#define POINTER_GAIN_HIGH 320.0f        // Pixels per unit of velocity for fast movements
+#define POINTER_CURVE_MAX_SPEED 0.25f   // Velocity at which the gain reaches POINTER_GAIN_HIGH
+#define POINTER_CURVE_N 33              // Entries of the lookup table
+
+// The sample rate in Hz the gains are tuned for
+#define POINTER_REFERENCE_RATE 100.0f
+
+// Motion which is not yet reported is capped at this many pixels per axis
+#define POINTER_MAX_BACKLOG 1024.0f
+
+#define POINTER_X 0
+#define POINTER_Y 1
+
+//-----------------------------------------------------------------------------------------------------------------
+///
+/// The lookup table of the acceleration curve. Entry i holds the gain at speed i / (POINTER_CURVE_N - 1) *
+/// POINTER_CURVE_MAX_SPEED.
+//
+struct PointerCurve
+{
+    float gain[POINTER_CURVE_N];
+};
+
+//-----------------------------------------------------------------------------------------------------------------
+///
+/// Computes the acceleration curve. Uses a smoothstep between the low and the high gain, so the gain starts and ends
+/// flat and there are no sudden jumps in cursor speed.
+//
+constexpr PointerCurve makePointerCurve()
+{
+    PointerCurve curve{};
+    for(int i = 0; i < POINTER_CURVE_N; i++)
+    {
+        float t = (float)i / (POINTER_CURVE_N - 1);
+        float blend = t * t * (3.0f - 2.0f * t);
+        curve.gain[i] = POINTER_GAIN_LOW + (POINTER_GAIN_HIGH - POINTER_GAIN_LOW) * blend;
+    }
+    return curve;
+}
+
+class PointerBallistics
+{
+    public:
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Constructor.
+    ///
+    /// @param max_step     The maximum movement in pixels per axis which is put into one report.
+    //
+    PointerBallistics(int8_t max_step);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Adds the movement of one sample. Call once per new sample, not per loop iteration.
+    ///
+    /// @param velocity_x   The velocity on the x axis (processed sensor data).
+    /// @param velocity_y   The velocity on the y axis (processed sensor data).
+    /// @param sample_time  The time the sample was acquired at in microseconds. Handed on with the next report to
+    ///                     measure the latency from motion to report.
+    //
+    void addMotion(float velocity_x, float velocity_y, uint32_t sample_time);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Takes the whole pixels of the movement added so far, up to the maximum step. The rest stays for later reports.
+    ///
+    /// @param x            Where to store the movement on the x axis in pixels.
+    /// @param y            Where to store the movement on the y axis in pixels.
+    /// @param sample_time  Where to store the acquisition time of the oldest sample added since the last report with
+    ///                     movement.
+    ///
+    /// @return True if there is any movement to report.
+    //
+    bool takeReport(int8_t& x, int8_t& y, uint32_t& sample_time);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Sets the rate at which addMotion() is called. Defaults to POINTER_REFERENCE_RATE.
+    ///
+    /// @param rate         The sample rate in Hz.
+    //
+    void setSampleRate(float rate);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Drops all movement which was not reported yet, e.g. when no remote device is connected.
+    //
+    void reset();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the movement which was added but not reported yet.
+    ///
+    /// @param axis         POINTER_X or POINTER_Y.
+    ///
+    /// @return The movement in pixels.
+    //
+    float getResidual(uint8_t axis);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns how many pixels were discarded because the backlog exceeded POINTER_MAX_BACKLOG or by reset().
+    //
+    float getDroppedPixels();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the gain of the acceleration curve at a certain speed.
+    ///
+    /// @param speed        The absolute velocity.
+    ///
+    /// @return The gain in pixels per unit of velocity.
+    //
+    static float getGain(float speed);
+
+    private:
+    int8_t _max_step;
+    float _residual[2];
+    float _sample_scale;
+    float _dropped_pixels;
+    uint32_t _sample_time;
+    bool _sample_time_set;
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Takes the whole pixels of one axis, up to the maximum step.
+    ///
+    /// @param axis         POINTER_X or POINTER_Y.
+    ///
+    /// @return The movement in pixels.
+    //
+    int8_t __takeAxis(uint8_t axis);
+};
+
+#endif // POINTERBALLISTICS_HPP
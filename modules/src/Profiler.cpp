@@ -0,0 +1,141 @@
+/**********************************************************************
+ * Profiler.cpp
+ * 
+ * Implementation of the Profiler class.
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#include "Profiler.hpp"
+
+#ifdef ENABLE_PROFILING
+
+// The filter stage zones are named after their chain, followed by the name of the stage
+static const char* const PROFILE_ZONE_NAMES[PROFILE_ZONE_N] = {
+    "bmi160 transfer", "bmi160 decode", "bmi160 normalize", "bmi160 gradient",
+    "matrix scan", "hid keyboard", "hid mouse", "hid write",
+    "processing chain", "processing chain", "processing chain",
+    "one euro chain", "one euro chain", "one euro chain", "one euro chain", "one euro chain"
+};
+
+const char* Profiler::_stage_names[PROFILE_ZONE_N];
+uint32_t Profiler::_counts[PROFILE_ZONE_N];
+uint64_t Profiler::_totals[PROFILE_ZONE_N];
+uint32_t Profiler::_maxima[PROFILE_ZONE_N];
+uint32_t Profiler::_buckets[PROFILE_ZONE_N][PROFILE_BUCKET_N];
+
+//-----------------------------------------------------------------------------------------------------------------
+void Profiler::begin()
+{
+#if defined(DWT)
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+    reset();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void Profiler::record(uint8_t zone, uint32_t ticks)
+{
+    if(zone >= PROFILE_ZONE_N)
+        return;
+
+    uint8_t bucket = ticks ? 32 - __builtin_clz(ticks) : 0;
+    if(bucket >= PROFILE_BUCKET_N)
+        bucket = PROFILE_BUCKET_N - 1;
+
+    _buckets[zone][bucket]++;
+    _counts[zone]++;
+    _totals[zone] += ticks;
+    if(ticks > _maxima[zone])
+        _maxima[zone] = ticks;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void Profiler::nameZone(uint8_t zone, const char* name)
+{
+    if(zone >= PROFILE_FILTER_STAGE && zone < PROFILE_ZONE_N)
+        _stage_names[zone] = name;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint32_t Profiler::getCount(uint8_t zone)
+{
+    return zone < PROFILE_ZONE_N ? _counts[zone] : 0;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void Profiler::reset()
+{
+    for(uint8_t zone = 0; zone < PROFILE_ZONE_N; zone++)
+    {
+        _counts[zone] = 0;
+        _totals[zone] = 0;
+        _maxima[zone] = 0;
+        for(uint8_t bucket = 0; bucket < PROFILE_BUCKET_N; bucket++)
+            _buckets[zone][bucket] = 0;
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void Profiler::print(Print& output)
+{
+#if defined(DWT)
+    output.println("Profile (cycles)");
+#else
+    output.println("Profile (ns)");
+#endif
+
+    for(uint8_t zone = 0; zone < PROFILE_ZONE_N; zone++)
+    {
+        if(_counts[zone] == 0)
+            continue;
+
+        output.print(PROFILE_ZONE_NAMES[zone]);
+        if(_stage_names[zone])
+        {
+            output.print(" ");
+            output.print(_stage_names[zone]);
+        }
+        output.print(": n ");
+        output.print(_counts[zone]);
+        output.print(" | mean ");
+        output.print((uint32_t)(_totals[zone] / _counts[zone]));
+        output.print(" | max ");
+        output.print(_maxima[zone]);
+        output.print(" | p50 <");
+        output.print(__percentile(zone, 0.5f));
+        output.print(" | p99 <");
+        output.println(__percentile(zone, 0.99f));
+
+        output.print("   ");
+        for(uint8_t bucket = 0; bucket < PROFILE_BUCKET_N; bucket++)
+        {
+            if(_buckets[zone][bucket] == 0)
+                continue;
+            output.print(" <2^");
+            output.print(bucket);
+            output.print(":");
+            output.print(_buckets[zone][bucket]);
+        }
+        output.println("");
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint32_t Profiler::__percentile(uint8_t zone, float fraction)
+{
+    uint32_t target = (uint32_t)(fraction * _counts[zone]);
+    uint32_t seen = 0;
+    for(uint8_t bucket = 0; bucket < PROFILE_BUCKET_N - 1; bucket++)
+    {
+        seen += _buckets[zone][bucket];
+        if(seen > target)
+            return (uint32_t)1 << bucket;
+    }
+    return _maxima[zone];
+}
+
+#endif // ENABLE_PROFILING
@@ -0,0 +1,165 @@
+/**********************************************************************
+ * Profiler.hpp
+ * 
+ * Lightweight timing of code sections. A PROFILE_SCOPE(zone) at the top
+ * of a block measures the time until the end of the block and adds it
+ * to the histogram of the zone. The histograms have one bucket per
+ * power of two, so they take a fixed amount of memory no matter how
+ * many measurements are taken.
+ * On Cortex-M targets the time is measured in CPU cycles with the DWT
+ * cycle counter, everywhere else in nanoseconds with steady_clock.
+ * Profiling is compiled out completely unless ENABLE_PROFILING is
+ * defined below, PROFILE_SCOPE() expands to nothing then.
+ * Only use scopes in the main loop, not in interrupt service routines.
+ * Workflow:
+ *   1. Uncomment ENABLE_PROFILING
+ *   2. Call Profiler::begin() once in setup()
+ *   3. Print the results with Profiler::print() whenever needed
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+// Uncomment to enable the profiling scopes in all modules.
+//#define ENABLE_PROFILING
+
+// Profiled zones
+#define PROFILE_BMI160_TRANSFER 0       // One poll of the I2C transfer
+#define PROFILE_BMI160_DECODE 1         // Decoding the registers or FIFO frames of one read
+#define PROFILE_BMI160_NORMALIZE 2
+#define PROFILE_BMI160_GRADIENT 3
+#define PROFILE_MATRIX_SCAN 4
+#define PROFILE_HID_KEYBOARD 5          // sendKeyboardMessage()
+#define PROFILE_HID_MOUSE 6             // sendMouseMessage()
+#define PROFILE_HID_WRITE 7             // Writing one report to its characteristic
+
+// Filter stages, every chain has its own range with one zone per stage in the order of the chain
+#define PROFILE_FILTER_STAGE 8
+#define PROFILE_PROCESSING_STAGE PROFILE_FILTER_STAGE       // BMI160ProcessingChain
+#define PROFILE_PROCESSING_STAGE_N 3
+#define PROFILE_ONE_EURO_STAGE (PROFILE_PROCESSING_STAGE + PROFILE_PROCESSING_STAGE_N)    // BMI160OneEuroChain
+#define PROFILE_ONE_EURO_STAGE_N 5
+#define PROFILE_ZONE_N (PROFILE_ONE_EURO_STAGE + PROFILE_ONE_EURO_STAGE_N)
+
+#define PROFILE_BUCKET_N 24             // Bucket i counts times below 2^i ticks, the last one everything above
+
+#ifdef ENABLE_PROFILING
+
+#include <Arduino.h>
+
+#if !defined(DWT)
+#include <chrono>
+#endif
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(zone) ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(zone)
+
+class Profiler
+{
+    public:
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Starts the cycle counter on Cortex-M targets.
+    //
+    static void begin();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the current time in ticks (CPU cycles on target, nanoseconds on the host).
+    //
+    static inline uint32_t now()
+    {
+#if defined(DWT)
+        return DWT->CYCCNT;
+#else
+        return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Adds one measurement to the histogram of a zone.
+    ///
+    /// @param zone         The zone (see macros above).
+    /// @param ticks        The measured time in ticks.
+    //
+    static void record(uint8_t zone, uint32_t ticks);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Names a filter stage zone for print(). The stage chains name their zones when they are constructed.
+    ///
+    /// @param zone         The zone.
+    /// @param name         The name of the stage, has to outlive the profiler.
+    //
+    static void nameZone(uint8_t zone, const char* name);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the number of measurements of a zone since the last reset.
+    //
+    static uint32_t getCount(uint8_t zone);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Clears all histograms.
+    //
+    static void reset();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Prints count, mean, maximum, median and 99th percentile of every zone which was measured, followed by its
+    /// non empty buckets. The percentiles are the upper bounds of the buckets they fall into.
+    ///
+    /// @param output       Where to print to, usually Serial.
+    //
+    static void print(Print& output);
+
+    private:
+    static const char* _stage_names[PROFILE_ZONE_N];
+    static uint32_t _counts[PROFILE_ZONE_N];
+    static uint64_t _totals[PROFILE_ZONE_N];
+    static uint32_t _maxima[PROFILE_ZONE_N];
+    static uint32_t _buckets[PROFILE_ZONE_N][PROFILE_BUCKET_N];
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the upper bound of the bucket the given fraction of the measurements of a zone falls into.
+    //
+    static uint32_t __percentile(uint8_t zone, float fraction);
+};
+
+//-----------------------------------------------------------------------------------------------------------------
+///
+/// Measures the time from its construction to the end of the enclosing block. Use it through PROFILE_SCOPE().
+//
+class ProfileScope
+{
+    public:
+    ProfileScope(uint8_t zone) :
+    _zone{zone},
+    _start{Profiler::now()}
+    { }
+
+    ~ProfileScope()
+    {
+        Profiler::record(_zone, Profiler::now() - _start);
+    }
+
+    private:
+    uint8_t _zone;
+    uint32_t _start;
+};
+
+#else
+
+#define PROFILE_SCOPE(zone)
+
+#endif // ENABLE_PROFILING
+
+#endif // PROFILER_HPP
@@ -0,0 +1,98 @@
+/**********************************************************************
+ * SPSCRing.hpp
+ * 
+ * A fixed size lock-free ring buffer for exactly one producer and one
+ * consumer, e.g. an interrupt service routine pushing data and the main
+ * loop popping it. The producer only ever writes the head index, the
+ * consumer only ever writes the tail index, so no locking or disabling
+ * of interrupts is needed.
+ * The capacity has to be a power of two.
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#ifndef SPSCRING_HPP
+#define SPSCRING_HPP
+
+#include <stdint.h>
+#include <atomic>
+
+template<typename T, uint16_t N>
+class SPSCRing
+{
+    static_assert(N > 0 && (N & (N - 1)) == 0, "SPSCRing capacity must be a power of two");
+
+    public:
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Constructor.
+    //
+    SPSCRing() :
+    _head{0},
+    _tail{0}
+    { }
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Adds an element to the ring. May only be called from the producer side.
+    ///
+    /// @param value        The element to add.
+    ///
+    /// @return False if the ring is full and the element was dropped.
+    //
+    bool push(const T& value)
+    {
+        uint16_t head = _head.load(std::memory_order_relaxed);
+        if((uint16_t)(head - _tail.load(std::memory_order_acquire)) >= N)
+            return false;
+
+        _items[head & (N - 1)] = value;
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Takes the oldest element out of the ring. May only be called from the consumer side.
+    ///
+    /// @param value        Where to store the element.
+    ///
+    /// @return False if the ring was empty.
+    //
+    bool pop(T& value)
+    {
+        uint16_t tail = _tail.load(std::memory_order_relaxed);
+        if(tail == _head.load(std::memory_order_acquire))
+            return false;
+
+        value = _items[tail & (N - 1)];
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the number of elements currently stored. Only a snapshot if the other side is active.
+    //
+    uint16_t size()
+    {
+        return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+    }
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns true if no elements are stored. Only a snapshot if the other side is active.
+    //
+    bool empty()
+    {
+        return size() == 0;
+    }
+
+    private:
+    T _items[N];
+    std::atomic<uint16_t> _head;
+    std::atomic<uint16_t> _tail;
+};
+
+#endif // SPSCRING_HPP
@@ -0,0 +1,139 @@
+/**********************************************************************
+ * TaskScheduler.cpp
+ * 
+ * Implementation of the TaskScheduler class.
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#include "TaskScheduler.hpp"
+
+//-----------------------------------------------------------------------------------------------------------------
+static uint32_t __defaultClock()
+{
+    return micros();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TaskScheduler::TaskScheduler(SchedulerClock clock) :
+_clock{clock ? clock : __defaultClock},
+_task_n{0}
+{
+    resetStats();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+int8_t TaskScheduler::addTask(TaskFunction function, uint32_t period_us)
+{
+    if(_task_n >= SCHEDULER_MAX_TASKS)
+        return -1;
+
+    _functions[_task_n] = function;
+    _periods[_task_n] = period_us;
+    _releases[_task_n] = _clock();
+    _task_n++;
+
+    return _task_n - 1;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void TaskScheduler::setTaskPeriod(uint8_t id, uint32_t period_us)
+{
+    if(id >= _task_n)
+        return;
+
+    _periods[id] = period_us;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool TaskScheduler::run()
+{
+    uint32_t now = _clock();
+
+    // Earliest deadline first among all released tasks. Times are compared relative to now to survive wrap arounds.
+    int8_t next = -1;
+    uint32_t next_slack = 0;
+    for(uint8_t id = 0; id < _task_n; id++)
+    {
+        uint32_t lateness = now - _releases[id];
+        if((int32_t)lateness < 0)
+            continue;
+
+        uint32_t slack = _periods[id] - lateness;
+        if(next < 0 || (int32_t)(slack - next_slack) < 0)
+        {
+            next = id;
+            next_slack = slack;
+        }
+    }
+
+    if(next < 0)
+        return false;
+
+    TaskStats& stats = _stats[next];
+    uint32_t jitter = now - _releases[next];
+    if(jitter > stats.max_jitter_us)
+        stats.max_jitter_us = jitter;
+    stats.sum_jitter_us += jitter;
+
+    _functions[next]();
+
+    uint32_t end = _clock();
+    uint32_t runtime = end - now;
+    if(runtime > stats.max_runtime_us)
+        stats.max_runtime_us = runtime;
+    if(end - _releases[next] > _periods[next])
+        stats.overruns++;
+    stats.runs++;
+
+    // Skip releases which are already over instead of running the task several times in a row to catch up
+    _releases[next] += _periods[next];
+    while((int32_t)(end - _releases[next]) >= (int32_t)_periods[next])
+    {
+        _releases[next] += _periods[next];
+        stats.skipped++;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+const TaskStats& TaskScheduler::getStats(uint8_t id)
+{
+    if(id >= _task_n)
+        id = 0;
+
+    return _stats[id];
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void TaskScheduler::resetStats()
+{
+    for(int i = 0; i < SCHEDULER_MAX_TASKS; i++)
+        _stats[i] = TaskStats{0, 0, 0, 0, 0, 0};
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void TaskScheduler::printStats()
+{
+    for(uint8_t id = 0; id < _task_n; id++)
+    {
+        TaskStats& stats = _stats[id];
+        Serial.print("Task ");
+        Serial.print(id);
+        Serial.print(": runs ");
+        Serial.print(stats.runs);
+        Serial.print(" | overruns ");
+        Serial.print(stats.overruns);
+        Serial.print(" | skipped ");
+        Serial.print(stats.skipped);
+        Serial.print(" | jitter avg/max ");
+        Serial.print(stats.runs ? stats.sum_jitter_us / stats.runs : 0);
+        Serial.print("/");
+        Serial.print(stats.max_jitter_us);
+        Serial.print(" us | runtime max ");
+        Serial.print(stats.max_runtime_us);
+        Serial.println(" us");
+    }
+}
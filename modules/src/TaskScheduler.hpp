@@ -0,0 +1,109 @@
+/**********************************************************************
+ * TaskScheduler.hpp
+ * 
+ * A small cooperative scheduler running tasks at fixed periods. Every
+ * task has its own period and deadline. Each call of run() executes the
+ * due task with the earliest deadline, so the main loop only has to call
+ * run() over and over. Tasks must return quickly, nothing is preempted.
+ * Per task statistics (release jitter, runtime, overruns) are recorded
+ * to check whether a schedule actually holds.
+ * The clock is a replaceable function, so schedules can be checked
+ * with a simulated clock.
+ * Workflow:
+ *   1. Add tasks with addTask()
+ *   2. Call run() in the main loop
+ *   3. Check the statistics with getStats()
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#ifndef TASKSCHEDULER_HPP
+#define TASKSCHEDULER_HPP
+
+#include <Arduino.h>
+
+#define SCHEDULER_MAX_TASKS 8
+
+typedef void (*TaskFunction)();
+typedef uint32_t (*SchedulerClock)();
+
+struct TaskStats
+{
+    uint32_t runs;              // How often the task was executed
+    uint32_t overruns;          // How often the task finished after its deadline (release + period)
+    uint32_t skipped;           // Releases which were skipped because the task was late by more than a period
+    uint32_t max_jitter_us;     // Maximum delay between release and start of the task
+    uint32_t sum_jitter_us;     // Sum of all delays, divide by runs for the average
+    uint32_t max_runtime_us;    // Maximum execution time of the task
+};
+
+class TaskScheduler
+{
+    public:
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Constructor.
+    ///
+    /// @param clock        The function returning the current time in microseconds. nullptr uses micros().
+    //
+    TaskScheduler(SchedulerClock clock = nullptr);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Adds a new task. Its first release is right away.
+    ///
+    /// @param function     The function to execute.
+    /// @param period_us    The period in microseconds.
+    ///
+    /// @return The id of the task or -1 if no more tasks can be added.
+    //
+    int8_t addTask(TaskFunction function, uint32_t period_us);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Changes the period of a task. Takes effect from its next release on.
+    ///
+    /// @param id           The id of the task.
+    /// @param period_us    The new period in microseconds.
+    //
+    void setTaskPeriod(uint8_t id, uint32_t period_us);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Executes the due task with the earliest deadline, if any.
+    ///
+    /// @return True if a task was executed.
+    //
+    bool run();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the statistics of a task.
+    ///
+    /// @param id           The id of the task.
+    //
+    const TaskStats& getStats(uint8_t id);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Resets the statistics of all tasks.
+    //
+    void resetStats();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Prints the statistics of all tasks to the Serial output.
+    //
+    void printStats();
+
+    private:
+    SchedulerClock _clock;
+    uint8_t _task_n;
+    TaskFunction _functions[SCHEDULER_MAX_TASKS];
+    uint32_t _periods[SCHEDULER_MAX_TASKS];
+    uint32_t _releases[SCHEDULER_MAX_TASKS];
+    TaskStats _stats[SCHEDULER_MAX_TASKS];
+};
+
+#endif // TASKSCHEDULER_HPP
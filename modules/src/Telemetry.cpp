@@ -0,0 +1,112 @@
+/**********************************************************************
+ * Telemetry.cpp
+ * 
+ * Implementation of the Telemetry class.
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#include "Telemetry.hpp"
+#include <string.h>
+
+//-----------------------------------------------------------------------------------------------------------------
+Telemetry::Telemetry(Print& output) :
+_output(output),
+_sequence{0},
+_dropped_frames{0}
+{ }
+
+//-----------------------------------------------------------------------------------------------------------------
+bool Telemetry::sendSample(uint32_t timestamp, const int16_t raw_data[6], const float processed[6])
+{
+    uint8_t payload[6 * sizeof(int16_t) + 6 * sizeof(float)];
+    memcpy(payload, raw_data, 6 * sizeof(int16_t));
+    memcpy(payload + 6 * sizeof(int16_t), processed, 6 * sizeof(float));
+
+    return sendFrame(TELEMETRY_SAMPLE, timestamp, payload, sizeof(payload));
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool Telemetry::sendFrame(uint8_t type, uint32_t timestamp, const uint8_t payload[], uint8_t length)
+{
+    if(length > TELEMETRY_MAX_PAYLOAD)
+        return false;
+
+    uint8_t frame[TELEMETRY_HEADER_LEN + TELEMETRY_MAX_PAYLOAD + TELEMETRY_CRC_LEN];
+    frame[0] = type;
+    frame[1] = _sequence++;
+    memcpy(&frame[2], &timestamp, sizeof(timestamp));
+    memcpy(&frame[TELEMETRY_HEADER_LEN], payload, length);
+
+    uint16_t frame_length = TELEMETRY_HEADER_LEN + length;
+    uint16_t crc = crc16(frame, frame_length);
+    frame[frame_length++] = crc & 0xFF;
+    frame[frame_length++] = crc >> 8;
+
+    uint8_t encoded[TELEMETRY_MAX_FRAME_LEN];
+    uint16_t encoded_length = __encodeCOBS(frame, frame_length, encoded);
+
+    // A partial frame would only corrupt the next one as well, so either all of it goes into the ring or nothing
+    if(encoded_length > TELEMETRY_TX_BUFFER_N - _tx.size())
+    {
+        _dropped_frames++;
+        return false;
+    }
+
+    for(uint16_t i = 0; i < encoded_length; i++)
+        _tx.push(encoded[i]);
+    return true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void Telemetry::flush()
+{
+    uint8_t chunk[64];
+
+    int room = _output.availableForWrite();
+    while(room > 0 && !_tx.empty())
+    {
+        uint16_t length = 0;
+        while(length < sizeof(chunk) && length < (uint16_t)room && _tx.pop(chunk[length]))
+            length++;
+
+        _output.write(chunk, length);
+        room -= length;
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint32_t Telemetry::getDroppedFrames()
+{
+    return _dropped_frames;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint16_t Telemetry::__encodeCOBS(const uint8_t data[], uint16_t length, uint8_t encoded[])
+{
+    // Every block starts with the distance to the next zero, the zeros themselves are left out
+    uint16_t code_index = 0;
+    uint16_t out = 1;
+    uint8_t code = 1;
+
+    for(uint16_t i = 0; i < length; i++)
+    {
+        if(data[i] != 0)
+        {
+            encoded[out++] = data[i];
+            code++;
+        }
+
+        if(data[i] == 0 || code == 0xFF)
+        {
+            encoded[code_index] = code;
+            code_index = out++;
+            code = 1;
+        }
+    }
+
+    encoded[code_index] = code;
+    encoded[out++] = 0x00;
+    return out;
+}
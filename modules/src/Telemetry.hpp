@@ -0,0 +1,112 @@
+/**********************************************************************
+ * Telemetry.hpp
+ * 
+ * A compact binary telemetry stream over the Serial connection. Every
+ * frame carries a type, a sequence number, a timestamp and a payload,
+ * followed by a CRC-16/CCITT of all these bytes. The frame is COBS
+ * encoded and terminated by a zero byte, so a receiver can always find
+ * the start of the next frame again.
+ * Frames are written into a transmit ring first and handed to the
+ * Serial only as far as it can take them without blocking. Frames which
+ * do not fit into the ring anymore are dropped as a whole and counted.
+ * All values are sent little endian. tools/telemetry_decode.py decodes
+ * the stream on the host.
+ * Workflow:
+ *   1. Send frames with sendSample() or sendFrame()
+ *   2. Call flush() regularly to drain the ring
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#ifndef TELEMETRY_HPP
+#define TELEMETRY_HPP
+
+#include <Arduino.h>
+#include "SPSCRing.hpp"
+#include "CRC16.hpp"
+
+// Size of the transmit ring in bytes, has to be a power of two
+#define TELEMETRY_TX_BUFFER_N 1024
+
+// Maximum payload of a single frame in bytes
+#define TELEMETRY_MAX_PAYLOAD 64
+
+// Type (1), sequence number (1) and timestamp (4) in front of the payload, CRC (2) behind it
+#define TELEMETRY_HEADER_LEN 6
+#define TELEMETRY_CRC_LEN 2
+
+// Largest encoded frame: one COBS overhead byte per 254 bytes plus the first one, and the delimiter
+#define TELEMETRY_MAX_FRAME_LEN (TELEMETRY_HEADER_LEN + TELEMETRY_MAX_PAYLOAD + TELEMETRY_CRC_LEN + 2)
+
+// Frame types
+#define TELEMETRY_SAMPLE 0x01       // Payload: raw data int16_t[6], processed data float[6]
+
+class Telemetry
+{
+    public:
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Constructor.
+    ///
+    /// @param output       Where to write the frames to, usually Serial.
+    //
+    Telemetry(Print& output);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Queues a frame with one sensor sample.
+    ///
+    /// @param timestamp    The time the sample was acquired at in microseconds.
+    /// @param raw_data     The raw sensor data.
+    /// @param processed    The output of the processing pipeline.
+    ///
+    /// @return False if the frame did not fit into the ring and was dropped.
+    //
+    bool sendSample(uint32_t timestamp, const int16_t raw_data[6], const float processed[6]);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Queues a frame with an arbitrary payload.
+    ///
+    /// @param type         The type of the frame.
+    /// @param timestamp    The timestamp of the frame in microseconds.
+    /// @param payload      The payload.
+    /// @param length       The length of the payload, at most TELEMETRY_MAX_PAYLOAD.
+    ///
+    /// @return False if the frame did not fit into the ring and was dropped.
+    //
+    bool sendFrame(uint8_t type, uint32_t timestamp, const uint8_t payload[], uint8_t length);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Hands as much of the ring to the output as it can take right now without blocking.
+    //
+    void flush();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns how many frames were dropped because the ring was full.
+    //
+    uint32_t getDroppedFrames();
+
+    private:
+    Print& _output;
+    SPSCRing<uint8_t, TELEMETRY_TX_BUFFER_N> _tx;
+    uint8_t _sequence;
+    uint32_t _dropped_frames;
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// COBS encodes a buffer and appends the zero delimiter.
+    ///
+    /// @param data         The data to encode.
+    /// @param length       The length of the data.
+    /// @param encoded      The encoded frame, needs length + length / 254 + 2 bytes.
+    ///
+    /// @return The length of the encoded frame.
+    //
+    static uint16_t __encodeCOBS(const uint8_t data[], uint16_t length, uint8_t encoded[]);
+};
+
+#endif // TELEMETRY_HPP
@@ -0,0 +1,125 @@
+/**********************************************************************
+ * WindowAverage.hpp
+ * 
+ * A sliding window average over several axes which is updated in
+ * constant time per data point. Instead of summing up the whole window
+ * on every new data point, a running sum per axis is kept. The value
+ * leaving the window is subtracted and the new value is added, each in
+ * a compensated step (Neumaier's variant of Kahan summation, as the
+ * values are often larger than the sum they cancel out in). Rounding
+ * errors do not pile up over long runs and the result stays as exact as
+ * summing up the full window.
+ * Values are stored per axis (one array per axis) so windows only
+ * cost memory for the axes they are used for.
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#ifndef WINDOWAVERAGE_HPP
+#define WINDOWAVERAGE_HPP
+
+#include <stdint.h>
+#include <math.h>
+
+template<uint16_t N, uint8_t AXES>
+class WindowAverage
+{
+    static_assert(N > 0, "WindowAverage needs a window length of at least 1");
+
+    public:
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Constructor. The window starts filled with zeros.
+    //
+    WindowAverage() :
+    _curr_n{0}
+    {
+        reset();
+    }
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Fills the whole window with zeros again.
+    //
+    void reset()
+    {
+        for(uint8_t axis = 0; axis < AXES; axis++)
+        {
+            for(uint16_t i = 0; i < N; i++)
+                _values[axis][i] = 0.0f;
+            _sum[axis] = 0.0f;
+            _compensation[axis] = 0.0f;
+        }
+        _curr_n = 0;
+    }
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Adds a new data point to the window and drops the oldest one.
+    ///
+    /// @param input_data       The new data point (AXES values).
+    //
+    void push(const float input_data[AXES])
+    {
+        for(uint8_t axis = 0; axis < AXES; axis++)
+        {
+            // Both values are summed up on their own, their difference would already be rounded
+            __add(axis, -_values[axis][_curr_n]);
+            __add(axis, input_data[axis]);
+            _values[axis][_curr_n] = input_data[axis];
+        }
+
+        _curr_n++;
+        if(_curr_n >= N)
+            _curr_n = 0;
+    }
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the average of the window for one axis.
+    ///
+    /// @param axis             The axis to get the average of.
+    //
+    float getAverage(uint8_t axis) const
+    {
+        return (_sum[axis] + _compensation[axis]) / N;
+    }
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the average of the window for all axes.
+    ///
+    /// @param output_data      The array to store the averages in (AXES values).
+    //
+    void getAverages(float output_data[AXES]) const
+    {
+        for(uint8_t axis = 0; axis < AXES; axis++)
+            output_data[axis] = getAverage(axis);
+    }
+
+    private:
+    uint16_t _curr_n;
+    float _values[AXES][N];
+    float _sum[AXES];
+    float _compensation[AXES];
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Adds a value to the sum of an axis and the rounding error of the addition to its compensation.
+    ///
+    /// @param axis             The axis to add the value to.
+    /// @param value            The value to add.
+    //
+    void __add(uint8_t axis, float value)
+    {
+        float new_sum = _sum[axis] + value;
+        if(fabsf(_sum[axis]) >= fabsf(value))
+            _compensation[axis] += (_sum[axis] - new_sum) + value;
+        else
+            _compensation[axis] += (value - new_sum) + _sum[axis];
+        _sum[axis] = new_sum;
+    }
+};
+
+#endif // WINDOWAVERAGE_HPP
@@ -0,0 +1,121 @@
+/**********************************************************************
+ * bench_FixedPipeline.cpp
+ * 
+ * Runs a recorded IMU trace through the integer FixedPipeline and
+ * through the float processing of the BMI160 class (normalization,
+ * processing chain and gradient, fed through processRawSample()) and
+ * prints the time per sample of both and the deviation of the fixed
+ * point output from the float output.
+ * The times are host times. They show how the two paths compare, not
+ * what they take on the board. The deviation is the same everywhere
+ * and fails the run if it grows beyond BENCH_MAX_ERROR.
+ * Usage:
+ *   bench_FixedPipeline <trace.csv> [repetitions]
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#include "BMI160.hpp"
+#include "FixedPipeline.hpp"
+#include "SimTrace.hpp"
+
+#include <chrono>
+#include <vector>
+#include <stdio.h>
+#include <math.h>
+
+#define BENCH_DEFAULT_REPETITIONS 200
+
+// Largest deviation of a processed axis from the float chain accepted, in the normalized units of the float chain
+#define BENCH_MAX_ERROR 0.002
+
+//-----------------------------------------------------------------------------------------------------------------
+template<typename Function>
+static double __nanosPerSample(Function run, uint32_t sample_n, uint32_t repetitions)
+{
+    auto start = std::chrono::steady_clock::now();
+    for(uint32_t i = 0; i < repetitions; i++)
+        run();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / ((double)sample_n * repetitions);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+    if(argc < 2)
+    {
+        printf("Usage: %s <trace.csv> [repetitions]\n", argv[0]);
+        return 2;
+    }
+
+    std::vector<std::vector<int16_t>> samples;
+    if(!SimTrace::load(argv[1], samples) || samples.empty())
+    {
+        printf("Cannot read trace %s\n", argv[1]);
+        return 2;
+    }
+    uint32_t repetitions = argc > 2 ? atoi(argv[2]) : BENCH_DEFAULT_REPETITIONS;
+
+    // Deviation on one pass over the trace, both paths starting from their initial state
+    BMI160 float_path;
+    FixedPipeline fixed_path;
+    fixed_path.setRanges(float_path.getAccelerometerRange(), float_path.getGyroscopeRange());
+    double max_error[6] = {0};
+    double sum_squares[6] = {0};
+    for(const std::vector<int16_t>& sample : samples)
+    {
+        float float_data[6];
+        int16_t fixed_data[6];
+        float_path.processRawSample(sample.data(), 0);
+        float_path.getProcessedData(float_data);
+        fixed_path.process(sample.data());
+        fixed_path.getProcessedData(fixed_data);
+
+        for(int i = 0; i < 6; i++)
+        {
+            double error = fabs(fixed_data[i] / (double)FIXED_PIPELINE_ONE - float_data[i]);
+            max_error[i] = error > max_error[i] ? error : max_error[i];
+            sum_squares[i] += error * error;
+        }
+    }
+
+    // Timing over many passes, the output is kept alive so nothing is optimized away
+    volatile float float_sink = 0.0f;
+    volatile int16_t fixed_sink = 0;
+    double float_ns = __nanosPerSample([&]()
+    {
+        float data[6];
+        for(const std::vector<int16_t>& sample : samples)
+            float_path.processRawSample(sample.data(), 0);
+        float_path.getProcessedData(data);
+        float_sink = data[GYR_Z];
+    }, samples.size(), repetitions);
+    double fixed_ns = __nanosPerSample([&]()
+    {
+        int16_t data[6];
+        for(const std::vector<int16_t>& sample : samples)
+            fixed_path.process(sample.data());
+        fixed_path.getProcessedData(data);
+        fixed_sink = data[GYR_Z];
+    }, samples.size(), repetitions);
+    (void)float_sink;
+    (void)fixed_sink;
+
+    const char* axes[6] = {"gyr_x", "gyr_y", "gyr_z", "acc_x", "acc_y", "acc_z"};
+    printf("%zu samples, %u repetitions, %s\n", samples.size(), repetitions,
+           FIXED_PIPELINE_SIMD ? "packed 16 bit kernels" : "scalar kernels");
+    printf("Time per sample: float %.1fns, fixed %.1fns (%.2fx)\n", float_ns, fixed_ns, float_ns / fixed_ns);
+    printf("Deviation from the float chain (max / rms):\n");
+    bool passed = true;
+    for(int i = 0; i < 6; i++)
+    {
+        printf("  %s %.5f / %.5f\n", axes[i], max_error[i], sqrt(sum_squares[i] / samples.size()));
+        passed &= max_error[i] <= BENCH_MAX_ERROR;
+    }
+
+    if(!passed)
+        printf("Deviation exceeds %.3f\n", BENCH_MAX_ERROR);
+    return passed ? 0 : 1;
+}
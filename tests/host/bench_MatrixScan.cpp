@@ -0,0 +1,168 @@
+/**********************************************************************
+ * bench_MatrixScan.cpp
+ * 
+ * Scans simulated button matrices of several sizes and prints the time
+ * and the pin calls per scan, for MatrixIO and for the scan ButtonMatrix
+ * did before MatrixIO (every row switched for every row, one
+ * digitalRead() per column).
+ * The times are host times of the portable MatrixIO path over the
+ * simulated pins. The port register path of the board does not run on
+ * the host, it replaces all pin calls of a row with two register writes
+ * and one register read per port. The pin calls are the same everywhere.
+ * The run fails if a scan reads anything else than the closed switches.
+ * Usage:
+ *   bench_MatrixScan [repetitions]
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#include "Sim.hpp"
+#include "ButtonMatrix.hpp"
+
+#include <chrono>
+#include <stdio.h>
+
+#define BENCH_DEFAULT_REPETITIONS 20000
+
+#define BENCH_FIRST_ROW_PIN 2
+#define BENCH_FIRST_COL_PIN 20
+
+//-----------------------------------------------------------------------------------------------------------------
+// One button per row, each in another column, so nothing is a ghost
+static uint8_t __pressedCol(uint8_t row, uint8_t col_n)
+{
+    return (row * 3) % col_n;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+static void __closeSwitches(uint8_t row_n, uint8_t col_n)
+{
+    for(uint8_t row = 0; row < row_n; row++)
+        SimGPIO::setSwitch(BENCH_FIRST_ROW_PIN + row, BENCH_FIRST_COL_PIN + __pressedCol(row, col_n), true);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+static bool __checkRaw(const uint8_t raw[], uint8_t row_n, uint8_t col_n)
+{
+    for(uint8_t row = 0; row < row_n; row++)
+    {
+        if(raw[row] != 1 << __pressedCol(row, col_n))
+            return false;
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+// The scan of ButtonMatrix before MatrixIO
+static void __legacyScan(uint8_t row_n, uint8_t col_n, uint8_t raw[])
+{
+    for(uint8_t row = 0; row < row_n; row++)
+    {
+        for(uint8_t r = 0; r < row_n; r++)
+        {
+            pinMode(BENCH_FIRST_ROW_PIN + r, (r == row) ? OUTPUT : INPUT);
+            if(r == row)
+                digitalWrite(BENCH_FIRST_ROW_PIN + r, LOW);
+        }
+
+        raw[row] = 0;
+        for(uint8_t col = 0; col < col_n; col++)
+        {
+            if(digitalRead(BENCH_FIRST_COL_PIN + col) == LOW)
+                raw[row] |= 1 << col;
+        }
+
+        pinMode(BENCH_FIRST_ROW_PIN + row, OUTPUT);
+        digitalWrite(BENCH_FIRST_ROW_PIN + row, HIGH);
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+// The scan of ButtonMatrix::fetchButtonPresses() without the debounce around it
+static void __matrixIOScan(MatrixIO& io, uint8_t raw[])
+{
+    for(uint8_t row = 0; row < io.getRowCount(); row++)
+    {
+        io.selectRow(row);
+        raw[row] = io.readCols();
+        io.releaseRow(row);
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+template<typename Function>
+static double __nanosPerScan(Function scan, uint32_t repetitions)
+{
+    auto start = std::chrono::steady_clock::now();
+    for(uint32_t i = 0; i < repetitions; i++)
+        scan();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / repetitions;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+template<uint8_t R, uint8_t C>
+static bool __benchMatrix(uint32_t repetitions)
+{
+    uint8_t raw[R];
+    bool passed = true;
+
+    Sim::reset();
+    for(uint8_t row = 0; row < R; row++)
+        pinMode(BENCH_FIRST_ROW_PIN + row, INPUT);
+    for(uint8_t col = 0; col < C; col++)
+        pinMode(BENCH_FIRST_COL_PIN + col, INPUT_PULLUP);
+    __closeSwitches(R, C);
+    uint32_t calls = SimGPIO::getPinCallCount();
+    __legacyScan(R, C, raw);
+    uint32_t legacy_calls = SimGPIO::getPinCallCount() - calls;
+    passed &= __checkRaw(raw, R, C);
+    double legacy_ns = __nanosPerScan([&]() { __legacyScan(R, C, raw); }, repetitions);
+
+    Sim::reset();
+    MatrixIO io;
+    for(uint8_t row = 0; row < R; row++)
+        io.addRowPin(BENCH_FIRST_ROW_PIN + row);
+    for(uint8_t col = 0; col < C; col++)
+        io.addColPin(BENCH_FIRST_COL_PIN + col);
+    __closeSwitches(R, C);
+    calls = SimGPIO::getPinCallCount();
+    __matrixIOScan(io, raw);
+    uint32_t io_calls = SimGPIO::getPinCallCount() - calls;
+    passed &= __checkRaw(raw, R, C);
+    double io_ns = __nanosPerScan([&]() { __matrixIOScan(io, raw); }, repetitions);
+
+    // The whole fetchButtonPresses() with debounce and ghost detection on top of MatrixIO
+    Sim::reset();
+    ButtonMatrix<R, C> matrix;
+    for(uint8_t row = 0; row < R; row++)
+        matrix.addRowPin(BENCH_FIRST_ROW_PIN + row);
+    for(uint8_t col = 0; col < C; col++)
+        matrix.addColPin(BENCH_FIRST_COL_PIN + col);
+    matrix.setIdleTimeout(0);
+    __closeSwitches(R, C);
+    double matrix_ns = __nanosPerScan([&]() { matrix.fetchButtonPresses(); }, repetitions);
+    passed &= matrix.getPressedCount() == R;
+
+    printf("  %ux%u  legacy %3u calls %8.0fns  MatrixIO %3u calls %8.0fns  fetchButtonPresses %8.0fns\n",
+           R, C, legacy_calls, legacy_ns, io_calls, io_ns, matrix_ns);
+    return passed;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+    uint32_t repetitions = argc > 1 ? atoi(argv[1]) : BENCH_DEFAULT_REPETITIONS;
+
+    printf("%u repetitions, pin calls and time per scan:\n", repetitions);
+    bool passed = true;
+    passed &= __benchMatrix<2, 2>(repetitions);
+    passed &= __benchMatrix<4, 4>(repetitions);
+    passed &= __benchMatrix<4, 7>(repetitions);
+    passed &= __benchMatrix<8, 7>(repetitions);
+
+    if(!passed)
+        printf("A scan read other buttons than the closed switches\n");
+    return passed ? 0 : 1;
+}
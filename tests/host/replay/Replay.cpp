@@ -0,0 +1,540 @@
+/**********************************************************************
+ * Replay.cpp
+ * 
+ * Replays a recorded IMU trace through the unchanged loop logic of
+ * modules.ino on the simulated hardware and writes every HID report the
+ * device sends. Compared against a golden file, this shows whether a
+ * change to the filters, the pointer mapping or the scheduling changes
+ * what the host receives.
+ * The trace is a CSV file as written by tools/telemetry_decode.py, only
+ * the raw columns are used. The simulated BMI160 hands out one row per
+ * sample at its output data rate. Lines starting with '#' are comments.
+ * An optional event file scripts the rest of the world, one event per
+ * line: "<time_us> connect", "<time_us> disconnect",
+ * "<time_us> press <row> <col>" and "<time_us> release <row> <col>".
+ * Usage:
+ *   replay <trace.csv> [--events <file>] [--latency] [--filter <name>]
+ *          [--golden <file> [--update]]
+ * Without a golden file the report is written to stdout. With one, the
+ * report is compared against it and written next to the binary as
+ * <golden name>.actual on a mismatch. --update rewrites the golden file.
+ * --latency adds the latency histograms of the sample to report path,
+ * which needs ENABLE_LATENCY_TRACING.
+ * --filter one_euro runs the BMI160 in BMI160_FILTER_ONE_EURO mode and
+ * adds a comparison against the default chain, which processes the
+ * same samples on the side. Per gyroscope axis it reports the delay of
+ * both outputs against the normalized input (where their correlation
+ * peaks), their gain against the delayed input and their jitter (RMS of
+ * the change between samples while the sensor is at rest).
+ * Built with USE_TELEMETRY, the Serial carries the telemetry frames.
+ * The report then counts the frames instead of printing the output, so
+ * anything else written to the Serial shows up as broken frames.
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#include "Sim.hpp"
+#include "SimBMI160.hpp"
+#include "SimTrace.hpp"
+#include "modules.ino"
+
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <stdio.h>
+
+// Time one pass of loop() takes
+#define REPLAY_LOOP_US 10
+
+// Time the replay goes on after the last sample of the trace, so the last movement gets reported
+#define REPLAY_TAIL_US 100000
+
+// Gives up if the sensor does not hand out a sample for this long, e.g. because it was never configured
+#define REPLAY_STALL_US 1000000
+
+#define REPLAY_UUID_REPORT "2A4D"
+
+// Longest delay of a filter output searched for, in samples
+#define REPLAY_FILTER_MAX_LAG 30
+
+// Samples with all gyroscope axes within this many LSB count as at rest for the jitter
+#define REPLAY_REST_LSB 16
+
+struct ReplayEvent
+{
+    uint64_t time;
+    std::string type;
+    uint8_t row;
+    uint8_t col;
+};
+
+// A gyroscope sample as seen by the filter under test and by the default chain
+struct ReplayFilterSample
+{
+    float input[3];
+    float output[3];
+    float reference[3];
+    bool at_rest;
+};
+
+static BMI160 _reference_chain;
+static std::vector<ReplayFilterSample> _filter_samples;
+
+static const uint8_t _replay_row_pins[] = {BUTTON_ROW_1, BUTTON_ROW_2};
+static const uint8_t _replay_col_pins[] = {BUTTON_COL_1, BUTTON_COL_2};
+
+//-----------------------------------------------------------------------------------------------------------------
+// Replaces processSample() as sample callback of the BMI160 while a filter is compared
+static void __compareFilter(int16_t raw_data[6])
+{
+    processSample(raw_data);
+
+    float output[6];
+    float reference[6];
+    bmi160.getProcessedData(output);
+    _reference_chain.processRawSample(raw_data, bmi160.getSampleTimestamp());
+    _reference_chain.getProcessedData(reference);
+
+    ReplayFilterSample sample;
+    float gyr_scale = (float)(BMI160_GYR_SCALE_2000DPS * bmi160.getGyroscopeRange() / 2000.0);
+    sample.at_rest = true;
+    for(int axis = GYR_X; axis <= GYR_Z; axis++)
+    {
+        sample.input[axis] = raw_data[axis] * gyr_scale;
+        sample.output[axis] = output[axis];
+        sample.reference[axis] = reference[axis];
+        sample.at_rest &= abs(raw_data[axis]) <= REPLAY_REST_LSB;
+    }
+    _filter_samples.push_back(sample);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+// Delay of a filter output against its input in samples, where their correlation peaks. A parabola through the peak
+// and its neighbors places it between samples.
+static double __filterDelay(uint8_t axis, bool reference)
+{
+    double correlation[REPLAY_FILTER_MAX_LAG + 1] = {0};
+    for(int lag = 0; lag <= REPLAY_FILTER_MAX_LAG; lag++)
+    {
+        for(size_t i = lag; i < _filter_samples.size(); i++)
+        {
+            const ReplayFilterSample& sample = _filter_samples[i];
+            correlation[lag] += _filter_samples[i - lag].input[axis] *
+                                (double)(reference ? sample.reference[axis] : sample.output[axis]);
+        }
+    }
+
+    int peak = 0;
+    for(int lag = 1; lag <= REPLAY_FILTER_MAX_LAG; lag++)
+        peak = correlation[lag] > correlation[peak] ? lag : peak;
+    if(peak == 0 || peak == REPLAY_FILTER_MAX_LAG)
+        return peak;
+
+    double curvature = correlation[peak - 1] - 2.0 * correlation[peak] + correlation[peak + 1];
+    return curvature < 0.0 ? peak + 0.5 * (correlation[peak - 1] - correlation[peak + 1]) / curvature : peak;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+// Least squares gain of a filter output against its input, delayed by the given number of samples
+static double __filterGain(uint8_t axis, bool reference, int delay)
+{
+    double product = 0.0;
+    double energy = 0.0;
+    for(size_t i = delay; i < _filter_samples.size(); i++)
+    {
+        const ReplayFilterSample& sample = _filter_samples[i];
+        double input = _filter_samples[i - delay].input[axis];
+        product += input * (reference ? sample.reference[axis] : sample.output[axis]);
+        energy += input * input;
+    }
+    return energy > 0.0 ? product / energy : 0.0;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+// RMS of the change of a filter output between samples while the sensor is at rest
+static double __filterJitter(uint8_t axis, bool reference)
+{
+    double sum_squares = 0.0;
+    uint32_t count = 0;
+    for(size_t i = 1; i < _filter_samples.size(); i++)
+    {
+        const ReplayFilterSample& sample = _filter_samples[i];
+        const ReplayFilterSample& prev_sample = _filter_samples[i - 1];
+        if(!sample.at_rest || !prev_sample.at_rest)
+            continue;
+
+        double change = reference ? sample.reference[axis] - prev_sample.reference[axis] :
+                                    sample.output[axis] - prev_sample.output[axis];
+        sum_squares += change * change;
+        count++;
+    }
+    return count > 0 ? sqrt(sum_squares / count) : 0.0;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+static std::string __compareFilterReport(const char* filter)
+{
+    std::ostringstream report;
+    char line[160];
+    const char* axes[3] = {"gyr_x", "gyr_y", "gyr_z"};
+    double sample_ms = 1000.0 / bmi160.getSampleRate();
+
+    report << "# Filter " << filter << " against the default chain: axis filter delay_ms gain jitter\n";
+    for(uint8_t axis = GYR_X; axis <= GYR_Z; axis++)
+    {
+        for(int reference = 0; reference < 2; reference++)
+        {
+            double delay = __filterDelay(axis, reference);
+            snprintf(line, sizeof(line), "%s %s %.1f %.3f %.3e\n", axes[axis], reference ? "chain" : filter,
+                     delay * sample_ms, __filterGain(axis, reference, (int)(delay + 0.5)),
+                     __filterJitter(axis, reference));
+            report << line;
+        }
+    }
+    return report.str();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+static bool __loadEvents(const char* path, std::vector<ReplayEvent>& events)
+{
+    std::ifstream file(path);
+    if(!file)
+        return false;
+
+    std::string line;
+    while(std::getline(file, line))
+    {
+        if(line.empty() || line[0] == '#')
+            continue;
+
+        ReplayEvent event{0, "", 0, 0};
+        int row = 0;
+        int col = 0;
+        std::stringstream fields(line);
+        fields >> event.time >> event.type >> row >> col;
+        event.row = row;
+        event.col = col;
+        events.push_back(event);
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+static void __applyEvent(const ReplayEvent& event)
+{
+    if(event.type == "connect")
+        SimBLE::connect();
+    else if(event.type == "disconnect")
+        SimBLE::disconnect();
+    else if(event.type == "press" || event.type == "release")
+        SimGPIO::setSwitch(_replay_row_pins[event.row], _replay_col_pins[event.col], event.type == "press");
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+static std::string __hex(const std::vector<uint8_t>& data)
+{
+    std::string text;
+    char byte[4];
+    for(uint8_t value : data)
+    {
+        snprintf(byte, sizeof(byte), " %02x", value);
+        text += byte;
+    }
+    return text;
+}
+
+#ifdef USE_TELEMETRY
+//-----------------------------------------------------------------------------------------------------------------
+// Splits the Serial output into COBS frames and counts the frames which decode with a valid CRC, the broken ones and
+// the gaps in the sequence numbers. What comes before the first frame is the text printed during the setup.
+static std::string __summarizeTelemetry(const std::string& output)
+{
+    size_t leading = 0;
+    uint32_t frames = 0;
+    uint32_t broken = 0;
+    uint32_t lost = 0;
+    int last_sequence = -1;
+
+    size_t start = 0;
+    size_t end;
+    while((end = output.find('\0', start)) != std::string::npos)
+    {
+        std::vector<uint8_t> frame;
+        bool valid = end > start;
+        for(size_t i = start; i < end && valid; )
+        {
+            uint8_t code = output[i++];
+            valid = code != 0 && i + code - 1 <= end;
+            for(uint8_t j = 1; j < code && valid; j++)
+                frame.push_back(output[i++]);
+            if(code < 0xFF && i < end)
+                frame.push_back(0);
+        }
+        start = end + 1;
+
+        valid &= frame.size() >= TELEMETRY_HEADER_LEN + TELEMETRY_CRC_LEN;
+        if(valid)
+        {
+            uint16_t length = frame.size() - TELEMETRY_CRC_LEN;
+            valid = crc16(frame.data(), length) == (frame[length] | frame[length + 1] << 8);
+        }
+        if(!valid)
+        {
+            if(frames == 0)
+                leading = start;
+            else
+                broken++;
+            continue;
+        }
+
+        if(last_sequence >= 0)
+            lost += (uint8_t)(frame[1] - last_sequence - 1);
+        last_sequence = frame[1];
+        frames++;
+    }
+
+    char line[160];
+    snprintf(line, sizeof(line), "leading bytes %zu, frames %u, broken %u, lost %u, dropped %u, trailing bytes %zu\n",
+             leading, frames, broken, lost, telemetry.getDroppedFrames(), output.size() - start);
+    return line;
+}
+#endif
+
+// Collects what is printed, e.g. by LatencyStats::print()
+class ReplayText : public Print
+{
+    public:
+    size_t write(uint8_t c) override
+    {
+        if(c != '\r')
+            text += (char)c;
+        return 1;
+    }
+
+    std::string text;
+};
+
+//-----------------------------------------------------------------------------------------------------------------
+static std::string __buildReport(const char* trace, uint32_t sample_n, uint32_t samples_taken, SimBMI160& sensor,
+                                 bool latency, const char* filter)
+{
+    std::ostringstream report;
+    char line[160];
+
+    const char* name = strrchr(trace, '/');
+    report << "# Replay of " << (name ? name + 1 : trace) << ", " << sample_n << " trace samples\n";
+
+    report << "# Reports: time_us report bytes\n";
+    for(const SimNotification& notification : SimBLE::getNotifications())
+    {
+        if(notification.uuid != REPLAY_UUID_REPORT || notification.data.empty())
+            continue;
+
+        const char* type = notification.data[0] == KEYBOARD_ID ? "keyboard" : "mouse";
+        snprintf(line, sizeof(line), "%llu %s%s%s\n", (unsigned long long)notification.time, type,
+                 __hex(notification.data).c_str(), notification.connected ? "" : " (not connected)");
+        report << line;
+    }
+
+    report << "# Connection updates: time_us handle min max latency timeout status\n";
+    for(const SimConnectionUpdate& update : SimBLE::getConnectionUpdates())
+    {
+        snprintf(line, sizeof(line), "%llu %u %u %u %u %u %d\n", (unsigned long long)update.time, update.handle,
+                 update.min_interval, update.max_interval, update.latency, update.supervision_timeout, update.status);
+        report << line;
+    }
+
+#ifdef USE_TELEMETRY
+    report << "# Telemetry\n" << __summarizeTelemetry(SimSerial::getOutput());
+#else
+    report << "# Serial output\n";
+    std::string serial = SimSerial::getOutput();
+    serial.erase(std::remove(serial.begin(), serial.end(), '\r'), serial.end());
+    report << serial;
+    if(!serial.empty() && serial.back() != '\n')
+        report << "\n";
+#endif
+
+    report << "# Summary\n";
+    report << "samples " << samples_taken << ", dropped " << bmi160.getDroppedSamples() << ", fifo overflows "
+           << sensor.getFifoOverflows() << ", read errors " << bmi160.getReadErrorCount(I2C_ERROR_NAK) << "/"
+           << bmi160.getReadErrorCount(I2C_ERROR_SHORT_READ) << "/" << bmi160.getReadErrorCount(I2C_ERROR_TIMEOUT)
+           << "\n";
+    report << "reports sent " << input_device.getSentReports() << ", suppressed "
+           << input_device.getSuppressedReports() << ", coalesced " << input_device.getCoalescedReports() << "\n";
+
+#ifdef ENABLE_LATENCY_TRACING
+    if(latency)
+    {
+        ReplayText text;
+        bmi160.getProcessingLatency().print(text, "Sample to processed");
+        input_device.getHandoffLatency().print(text, "Sample to handoff");
+        input_device.getReportQueueDelay().print(text, "Handoff to report");
+        input_device.getReportLatency().print(text, "Sample to report");
+        report << "# Latency\n" << text.text;
+    }
+#endif
+
+    if(filter)
+        report << __compareFilterReport(filter);
+    return report.str();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+static int __compareGolden(const std::string& report, const char* golden_path, bool update)
+{
+    if(update)
+    {
+        std::ofstream golden(golden_path);
+        golden << report;
+        printf("Updated %s\n", golden_path);
+        return 0;
+    }
+
+    std::ifstream golden_file(golden_path);
+    std::stringstream golden;
+    golden << golden_file.rdbuf();
+    if(golden.str() == report)
+    {
+        printf("Report matches %s\n", golden_path);
+        return 0;
+    }
+
+    // Point at the first difference and keep the whole report for a proper diff
+    std::istringstream expected(golden.str());
+    std::istringstream actual(report);
+    std::string expected_line;
+    std::string actual_line;
+    for(int line = 1; ; line++)
+    {
+        bool has_expected = (bool)std::getline(expected, expected_line);
+        bool has_actual = (bool)std::getline(actual, actual_line);
+        if(!has_expected && !has_actual)
+            break;
+        if(has_expected && has_actual && expected_line == actual_line)
+            continue;
+
+        printf("Report differs from %s in line %d:\n  expected: %s\n  actual:   %s\n", golden_path, line,
+               has_expected ? expected_line.c_str() : "<end>", has_actual ? actual_line.c_str() : "<end>");
+        break;
+    }
+
+    const char* name = strrchr(golden_path, '/');
+    std::string actual_path = std::string(name ? name + 1 : golden_path) + ".actual";
+    std::ofstream actual_file(actual_path);
+    actual_file << report;
+    printf("Full report written to %s\n", actual_path.c_str());
+    return 1;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+    if(argc < 2)
+    {
+        printf("Usage: %s <trace.csv> [--events <file>] [--latency] [--filter <name>] [--golden <file> [--update]]\n",
+               argv[0]);
+        return 2;
+    }
+
+    const char* trace_path = argv[1];
+    const char* events_path = nullptr;
+    const char* golden_path = nullptr;
+    bool update = false;
+    bool latency = false;
+    const char* filter = nullptr;
+    for(int i = 2; i < argc; i++)
+    {
+        if(strcmp(argv[i], "--events") == 0 && i + 1 < argc)
+            events_path = argv[++i];
+        else if(strcmp(argv[i], "--golden") == 0 && i + 1 < argc)
+            golden_path = argv[++i];
+        else if(strcmp(argv[i], "--update") == 0)
+            update = true;
+        else if(strcmp(argv[i], "--latency") == 0)
+            latency = true;
+        else if(strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+            filter = argv[++i];
+    }
+
+    if(filter && strcmp(filter, "one_euro") != 0)
+    {
+        printf("Unknown filter %s, only one_euro can be compared against the default chain\n", filter);
+        return 2;
+    }
+
+#ifndef ENABLE_LATENCY_TRACING
+    if(latency)
+    {
+        printf("--latency needs a build with ENABLE_LATENCY_TRACING\n");
+        return 2;
+    }
+#endif
+
+    std::vector<std::vector<int16_t>> samples;
+    std::vector<ReplayEvent> events;
+    if(!SimTrace::load(trace_path, samples) || samples.empty())
+    {
+        printf("Cannot read trace %s\n", trace_path);
+        return 2;
+    }
+    if(events_path && !__loadEvents(events_path, events))
+    {
+        printf("Cannot read events %s\n", events_path);
+        return 2;
+    }
+
+    Sim::reset();
+    SimBMI160 sensor(BMI160_INT1_PIN);
+    size_t next_sample = 0;
+    uint64_t trace_end = UINT64_MAX;
+    sensor.setSampleSource([&](int16_t sample[6])
+    {
+        // The last row is held once the trace ran out
+        for(int axis = 0; axis < 6; axis++)
+            sample[axis] = samples[next_sample < samples.size() ? next_sample : samples.size() - 1][axis];
+        next_sample++;
+        if(next_sample == samples.size())
+            trace_end = SimClock::now();
+    });
+
+    setup();
+    if(filter)
+    {
+        bmi160.setFilterMode(BMI160_FILTER_ONE_EURO);
+        bmi160.setSampleCallback(__compareFilter);
+    }
+
+    size_t next_event = 0;
+    uint32_t last_sample_count = 0;
+    uint64_t last_sample_time = SimClock::now();
+    while(trace_end == UINT64_MAX || SimClock::now() < trace_end + REPLAY_TAIL_US)
+    {
+        if(sensor.getSampleCount() != last_sample_count)
+        {
+            last_sample_count = sensor.getSampleCount();
+            last_sample_time = SimClock::now();
+        }
+        else if(trace_end == UINT64_MAX && SimClock::now() - last_sample_time > REPLAY_STALL_US)
+        {
+            printf("The sensor stopped sampling at %llu us\n", (unsigned long long)SimClock::now());
+            return 1;
+        }
+
+        while(next_event < events.size() && events[next_event].time <= SimClock::now())
+            __applyEvent(events[next_event++]);
+
+        loop();
+        SimClock::advance(REPLAY_LOOP_US);
+    }
+
+    std::string report = __buildReport(trace_path, samples.size(), sensor.getSampleCount(), sensor, latency,
+                                       filter);
+    if(!golden_path)
+    {
+        fputs(report.c_str(), stdout);
+        return 0;
+    }
+    return __compareGolden(report, golden_path, update);
+}
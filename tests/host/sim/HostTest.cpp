@@ -0,0 +1,83 @@
+/**********************************************************************
+ * HostTest.cpp
+ * 
+ * Implementation of the HostTest runner, including main() of the test
+ * binaries.
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#include "HostTest.hpp"
+#include "Sim.hpp"
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+struct __Test
+{
+    const char* name;
+    HostTestFunction function;
+};
+
+// Function local, so registrations from other translation units find it constructed
+static std::vector<__Test>& __tests()
+{
+    static std::vector<__Test> tests;
+    return tests;
+}
+
+static int _failed_checks = 0;
+
+//-----------------------------------------------------------------------------------------------------------------
+HostTest::HostTest(const char* name, HostTestFunction function)
+{
+    __tests().push_back({name, function});
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void HostTest::check(bool passed, const char* expression, const char* file, int line, const std::string& details)
+{
+    if(passed)
+        return;
+
+    _failed_checks++;
+    printf("  %s:%d: check failed: %s", file, line, expression);
+    if(!details.empty())
+        printf(" (%s)", details.c_str());
+    printf("\n");
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+int HostTest::run(int argc, char* argv[])
+{
+    int failed_tests = 0;
+    int run_tests = 0;
+    for(const __Test& test : __tests())
+    {
+        bool selected = argc < 2;
+        for(int i = 1; i < argc; i++)
+            selected |= strcmp(argv[i], test.name) == 0;
+        if(!selected)
+            continue;
+
+        Sim::reset();
+        int failed_before = _failed_checks;
+        test.function();
+        run_tests++;
+
+        bool passed = _failed_checks == failed_before;
+        if(!passed)
+            failed_tests++;
+        printf("[%s] %s\n", passed ? "  OK  " : " FAIL ", test.name);
+    }
+
+    printf("%d of %d tests passed\n", run_tests - failed_tests, run_tests);
+    return failed_tests == 0 && run_tests > 0 ? 0 : 1;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+    return HostTest::run(argc, argv);
+}
@@ -0,0 +1,107 @@
+/**********************************************************************
+ * HostTest.hpp
+ * 
+ * A minimal test runner for the host build. Tests are registered with
+ * TEST() and check their results with the CHECK macros. Every test
+ * starts on a freshly reset simulation (see Sim.hpp). A failed check
+ * is reported with its location and the test goes on, so one run shows
+ * all failures.
+ * Run a test binary without arguments to run all of its tests, or with
+ * the names of the tests to run.
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#ifndef HOSTTEST_HPP
+#define HOSTTEST_HPP
+
+#include <sstream>
+#include <string>
+#include <math.h>
+
+typedef void (*HostTestFunction)();
+
+class HostTest
+{
+    public:
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Registers a test. Used through TEST().
+    //
+    HostTest(const char* name, HostTestFunction function);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Records the result of a check. Used through the CHECK macros.
+    ///
+    /// @param passed       The result of the check.
+    /// @param expression   The checked expression.
+    /// @param file         The file of the check.
+    /// @param line         The line of the check.
+    /// @param details      The values involved, printed on failure.
+    //
+    static void check(bool passed, const char* expression, const char* file, int line,
+                      const std::string& details = "");
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Runs the registered tests.
+    ///
+    /// @param argc         The number of test names given, incl. the program name.
+    /// @param argv         The program name followed by the names of the tests to run, all tests if none are given.
+    ///
+    /// @return 0 if all tests passed.
+    //
+    static int run(int argc, char* argv[]);
+
+    template<typename E, typename A>
+    static std::string describe(const E& expected, const A& actual)
+    {
+        std::ostringstream text;
+        text << "expected " << printable(expected) << ", got " << printable(actual);
+        return text.str();
+    }
+
+    // Promotes character types, so uint8_t values print as numbers
+    template<typename T>
+    static auto printable(const T& value) -> decltype(+value)
+    {
+        return +value;
+    }
+
+    static const std::string& printable(const std::string& value)
+    {
+        return value;
+    }
+};
+
+#define HOST_TEST_CONCAT_(a, b) a##b
+#define HOST_TEST_CONCAT(a, b) HOST_TEST_CONCAT_(a, b)
+
+#define TEST(name) \
+    static void name(); \
+    static HostTest HOST_TEST_CONCAT(name, _registration)(#name, name); \
+    static void name()
+
+#define CHECK(condition) HostTest::check((condition), #condition, __FILE__, __LINE__)
+
+#define CHECK_EQUAL(expected, actual) \
+    do \
+    { \
+        auto _expected = (expected); \
+        auto _actual = (actual); \
+        HostTest::check(_expected == _actual, #actual " == " #expected, __FILE__, __LINE__, \
+                        HostTest::describe(_expected, _actual)); \
+    } while(0)
+
+#define CHECK_NEAR(expected, actual, tolerance) \
+    do \
+    { \
+        double _expected = (expected); \
+        double _actual = (actual); \
+        HostTest::check(fabs(_expected - _actual) <= (tolerance), #actual " ~ " #expected, __FILE__, __LINE__, \
+                        HostTest::describe(_expected, _actual)); \
+    } while(0)
+
+#endif // HOSTTEST_HPP
@@ -0,0 +1,1281 @@
+/**********************************************************************
+ * Sim.cpp
+ * 
+ * Implementation of the simulation and of the stand-in Arduino, Wire,
+ * ArduinoBLE and HCI APIs on top of it.
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#include "Sim.hpp"
+#include <Wire.h>
+#include <ArduinoBLE.h>
+#include <utility/ATT.h>
+#include <utility/HCI.h>
+#include <deque>
+#include <stdio.h>
+
+// Advertising type of high duty cycle directed advertising
+#define __ADV_DIRECT_IND_HIGH_DUTY 0x01
+
+// Return values of TwoWire::endTransmission()
+#define __WIRE_NAK_ADDRESS 2
+#define __WIRE_NAK_DATA 3
+
+// HCI events dumped to the debug stream
+#define __HCI_EVENT_PACKET 0x04
+#define __HCI_DISCONNECTION_COMPLETE 0x05
+#define __HCI_LE_META 0x3E
+#define __HCI_LE_CONNECTION_COMPLETE 0x01
+#define __HCI_LE_CONNECTION_UPDATE_COMPLETE 0x03
+#define __HCI_UNKNOWN_CONNECTION 0x02
+#define __HCI_REMOTE_USER_TERMINATED 0x13
+
+// Every connection gets the next handle, so a request to a stale or made up handle is noticed
+#define __FIRST_CONNECTION_HANDLE 0x0040
+
+// Parameters a connection starts with, picked by the host (30ms interval, no latency, 720ms timeout)
+#define __HOST_INTERVAL 24
+#define __HOST_LATENCY 0
+#define __HOST_SUPERVISION_TIMEOUT 72
+
+//-----------------------------------------------------------------------------------------------------------------
+// Clock
+//-----------------------------------------------------------------------------------------------------------------
+
+static uint64_t _now = 0;
+static std::vector<SimTimer*> _timers;
+
+//-----------------------------------------------------------------------------------------------------------------
+uint64_t SimClock::now()
+{
+    return _now;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void SimClock::advance(uint64_t us)
+{
+    advanceTo(_now + us);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void SimClock::advanceTo(uint64_t time)
+{
+    while(true)
+    {
+        // The earliest due timer first, so interrupts arrive in order
+        SimTimer* next = nullptr;
+        uint64_t next_time = UINT64_MAX;
+        for(SimTimer* timer : _timers)
+        {
+            uint64_t timer_time = timer->getNextTime();
+            if(timer_time < next_time)
+            {
+                next = timer;
+                next_time = timer_time;
+            }
+        }
+        if(!next || next_time > time)
+            break;
+
+        if(next_time > _now)
+            _now = next_time;
+        next->fire();
+    }
+
+    if(time > _now)
+        _now = time;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void SimClock::addTimer(SimTimer& timer)
+{
+    _timers.push_back(&timer);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void SimClock::removeTimer(SimTimer& timer)
+{
+    _timers.erase(std::remove(_timers.begin(), _timers.end(), &timer), _timers.end());
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void SimClock::reset()
+{
+    _now = 0;
+    _timers.clear();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+unsigned long micros()
+{
+    return (uint32_t)_now;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+unsigned long millis()
+{
+    return (uint32_t)(_now / 1000);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void delay(unsigned long ms)
+{
+    SimClock::advance((uint64_t)ms * 1000);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void delayMicroseconds(unsigned int us)
+{
+    SimClock::advance(us);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+// GPIO
+//-----------------------------------------------------------------------------------------------------------------
+
+struct __Pin
+{
+    uint8_t mode;
+    uint8_t output;
+    uint8_t external;
+    uint8_t last_level;
+    void (*isr)();
+    int isr_mode;
+};
+
+static __Pin _pins[SIM_PIN_N];
+static std::vector<std::pair<uint8_t, uint8_t>> _switches;
+static uint8_t _max_attached_interrupts = 0;
+static uint32_t _interrupt_count = 0;
+static uint32_t _pin_call_count = 0;
+
+//-----------------------------------------------------------------------------------------------------------------
+static uint8_t __resolveLevel(uint8_t pin)
+{
+    if(_pins[pin].mode == OUTPUT)
+        return _pins[pin].output;
+
+    // Collect everything connected through closed switches
+    bool visited[SIM_PIN_N] = {false};
+    std::vector<uint8_t> pending{pin};
+    visited[pin] = true;
+    bool driven = false;
+    uint8_t driven_level = HIGH;
+    bool pulled_up = false;
+    while(!pending.empty())
+    {
+        uint8_t current = pending.back();
+        pending.pop_back();
+
+        if(_pins[current].mode == OUTPUT)
+        {
+            // Two outputs fighting each other: the low side wins
+            driven_level = driven ? (driven_level & _pins[current].output) : _pins[current].output;
+            driven = true;
+            continue;
+        }
+        if(_pins[current].mode == INPUT_PULLUP)
+            pulled_up = true;
+
+        for(const std::pair<uint8_t, uint8_t>& closed : _switches)
+        {
+            uint8_t other = closed.first == current ? closed.second : (closed.second == current ? closed.first : current);
+            if(!visited[other])
+            {
+                visited[other] = true;
+                pending.push_back(other);
+            }
+        }
+    }
+
+    if(driven)
+        return driven_level;
+    if(pulled_up)
+        return HIGH;
+    return _pins[pin].external;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+static void __updateInterrupts()
+{
+    for(uint8_t pin = 0; pin < SIM_PIN_N; pin++)
+    {
+        if(!_pins[pin].isr)
+            continue;
+
+        uint8_t level = __resolveLevel(pin);
+        uint8_t last = _pins[pin].last_level;
+        _pins[pin].last_level = level;
+        if(level == last)
+            continue;
+
+        int mode = _pins[pin].isr_mode;
+        if(mode == CHANGE || (mode == RISING && level == HIGH) || (mode == FALLING && level == LOW))
+        {
+            _interrupt_count++;
+            _pins[pin].isr();
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void SimGPIO::setLevel(uint8_t pin, uint8_t level)
+{
+    _pins[pin].external = level;
+    __updateInterrupts();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void SimGPIO::setSwitch(uint8_t pin_a, uint8_t pin_b, bool closed)
+{
+    std::pair<uint8_t, uint8_t> connection{pin_a, pin_b};
+    _switches.erase(std::remove(_switches.begin(), _switches.end(), connection), _switches.end());
+    if(closed)
+        _switches.push_back(connection);
+    __updateInterrupts();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint8_t SimGPIO::getLevel(uint8_t pin)
+{
+    return __resolveLevel(pin);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint8_t SimGPIO::getMode(uint8_t pin)
+{
+    return _pins[pin].mode;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint8_t SimGPIO::getAttachedInterruptCount()
+{
+    uint8_t count = 0;
+    for(uint8_t pin = 0; pin < SIM_PIN_N; pin++)
+    {
+        if(_pins[pin].isr)
+            count++;
+    }
+    return count;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint8_t SimGPIO::getMaxAttachedInterruptCount()
+{
+    return _max_attached_interrupts;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint32_t SimGPIO::getInterruptCount()
+{
+    return _interrupt_count;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint32_t SimGPIO::getPinCallCount()
+{
+    return _pin_call_count;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void SimGPIO::reset()
+{
+    for(uint8_t pin = 0; pin < SIM_PIN_N; pin++)
+        _pins[pin] = {INPUT, LOW, LOW, LOW, nullptr, 0};
+    _switches.clear();
+    _max_attached_interrupts = 0;
+    _interrupt_count = 0;
+    _pin_call_count = 0;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    _pin_call_count++;
+    _pins[pin].mode = mode;
+    __updateInterrupts();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+    _pin_call_count++;
+    _pins[pin].output = value ? HIGH : LOW;
+    __updateInterrupts();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+int digitalRead(uint8_t pin)
+{
+    _pin_call_count++;
+    return __resolveLevel(pin);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+int digitalPinToInterrupt(uint8_t pin)
+{
+    return pin;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void attachInterrupt(int interrupt, void (*isr)(), int mode)
+{
+    _pins[interrupt].isr = isr;
+    _pins[interrupt].isr_mode = mode;
+    _pins[interrupt].last_level = __resolveLevel(interrupt);
+
+    uint8_t attached = SimGPIO::getAttachedInterruptCount();
+    if(attached > _max_attached_interrupts)
+        _max_attached_interrupts = attached;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void detachInterrupt(int interrupt)
+{
+    _pins[interrupt].isr = nullptr;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void noInterrupts()
+{
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void interrupts()
+{
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+// I2C
+//-----------------------------------------------------------------------------------------------------------------
+
+static SimI2CDevice* _devices[128];
+static SimI2CFaults _faults;
+static uint32_t _faulty_transactions = 0;
+static uint32_t _byte_us = SIM_I2C_DEFAULT_BYTE_US;
+static uint32_t _transactions = 0;
+
+TwoWire Wire;
+
+//-----------------------------------------------------------------------------------------------------------------
+static const SimI2CFaults* __takeFaults()
+{
+    _transactions++;
+    if(_faulty_transactions == 0)
+        return nullptr;
+
+    _faulty_transactions--;
+    return &_faults;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void SimI2C::addDevice(uint8_t address, SimI2CDevice& device)
+{
+    _devices[address & 0x7F] = &device;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void SimI2C::setFaults(const SimI2CFaults& faults, uint32_t transactions)
+{
+    _faults = faults;
+    _faulty_transactions = transactions;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void SimI2C::clearFaults()
+{
+    _faulty_transactions = 0;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void SimI2C::setByteTime(uint32_t byte_us)
+{
+    _byte_us = byte_us;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint32_t SimI2C::getTransactionCount()
+{
+    return _transactions;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void SimI2C::reset()
+{
+    for(int i = 0; i < 128; i++)
+        _devices[i] = nullptr;
+    _faulty_transactions = 0;
+    _byte_us = SIM_I2C_DEFAULT_BYTE_US;
+    _transactions = 0;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void TwoWire::begin()
+{
+    _tx_n = 0;
+    _rx_n = 0;
+    _rx_pos = 0;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void TwoWire::end()
+{
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void TwoWire::setClock(uint32_t frequency)
+{
+    SimI2C::setByteTime(9000000 / frequency);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void TwoWire::beginTransmission(uint8_t address)
+{
+    _address = address & 0x7F;
+    _tx_n = 0;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+size_t TwoWire::write(uint8_t value)
+{
+    if(_tx_n >= WIRE_BUFFER_LEN)
+        return 0;
+
+    _tx[_tx_n++] = value;
+    return 1;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+size_t TwoWire::write(const uint8_t buffer[], size_t size)
+{
+    size_t written = 0;
+    while(written < size && write(buffer[written]))
+        written++;
+    return written;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint8_t TwoWire::endTransmission(bool stop)
+{
+    (void)stop;
+    const SimI2CFaults* faults = __takeFaults();
+
+    // Address byte and data bytes
+    SimClock::advance((uint64_t)(1 + _tx_n) * _byte_us + (faults ? faults->stall_us : 0));
+
+    SimI2CDevice* device = _devices[_address];
+    if(!device || (faults && faults->nak_write))
+        return __WIRE_NAK_ADDRESS;
+    if(!device->write(_tx, _tx_n))
+        return __WIRE_NAK_DATA;
+    return 0;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint8_t TwoWire::requestFrom(int address, int length, bool stop)
+{
+    (void)stop;
+    const SimI2CFaults* faults = __takeFaults();
+    _rx_n = 0;
+    _rx_pos = 0;
+    if(length > WIRE_BUFFER_LEN)
+        length = WIRE_BUFFER_LEN;
+
+    SimI2CDevice* device = _devices[address & 0x7F];
+    if(!device || (faults && faults->nak_read))
+    {
+        SimClock::advance(_byte_us + (faults ? faults->stall_us : 0));
+        return 0;
+    }
+
+    uint16_t received = device->read(_rx, length);
+    if(faults && faults->truncate_to >= 0 && received > faults->truncate_to)
+        received = faults->truncate_to;
+
+    SimClock::advance((uint64_t)(1 + received) * _byte_us + (faults ? faults->stall_us : 0));
+    _rx_n = received;
+    return received;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+int TwoWire::available()
+{
+    return _rx_n - _rx_pos;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+int TwoWire::read()
+{
+    if(_rx_pos >= _rx_n)
+        return -1;
+    return _rx[_rx_pos++];
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+int TwoWire::peek()
+{
+    if(_rx_pos >= _rx_n)
+        return -1;
+    return _rx[_rx_pos];
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+// BLE
+//-----------------------------------------------------------------------------------------------------------------
+
+static const uint8_t __DEFAULT_CENTRAL[SIM_BLE_ADDRESS_LEN] = {0x11, 0x22, 0x33, 0x44, 0x55, 0x66};
+
+static bool _connected = false;
+static uint32_t _connection = 0;
+static uint8_t _central[SIM_BLE_ADDRESS_LEN];
+static uint8_t _central_type = SIM_BLE_ADDRESS_PUBLIC;
+static bool _advertising = false;
+static bool _directed_advertising = false;
+static uint8_t _advertising_type = 0;
+static int _command_status = 0;
+static uint8_t _update_status = 0;
+static std::vector<SimConnectionUpdate> _pending_updates;
+static std::vector<SimNotification> _notifications;
+static std::vector<SimConnectionUpdate> _connection_updates;
+static uint16_t _handle = 0;
+static Stream* _hci_debug = nullptr;
+
+static int (*_store_ltk)(uint8_t*, uint8_t*) = nullptr;
+static int (*_get_ltk)(uint8_t*, uint8_t*) = nullptr;
+static int (*_store_irk)(uint8_t*, uint8_t*) = nullptr;
+
+static BLELocalDevice _local_device;
+BLELocalDevice& BLE = _local_device;
+
+static HCIClass _hci;
+HCIClass& HCI = _hci;
+
+static ATTClass _att;
+ATTClass& ATT = _att;
+
+//-----------------------------------------------------------------------------------------------------------------
+// Dumps an event to the HCI debug stream the way ArduinoBLE does: a prefix, the packet in hex and a line break
+static void __dumpEvent(uint8_t code, const std::vector<uint8_t>& parameters)
+{
+    if(!_hci_debug)
+        return;
+
+    std::vector<uint8_t> packet = {__HCI_EVENT_PACKET, code, (uint8_t)parameters.size()};
+    packet.insert(packet.end(), parameters.begin(), parameters.end());
+
+    _hci_debug->print("HCI EVENT RX <- ");
+    for(uint8_t value : packet)
+    {
+        char text[3];
+        snprintf(text, sizeof(text), "%02X", value);
+        _hci_debug->print(text);
+    }
+    _hci_debug->println();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+// Reports the outcome of the updates requested since the last call. The host settles on the longest interval of the
+// requested range, a failed update reports the parameters the connection keeps.
+static void __deliverUpdates()
+{
+    for(const SimConnectionUpdate& update : _pending_updates)
+    {
+        uint16_t interval = _update_status == 0 ? update.max_interval : __HOST_INTERVAL;
+        uint16_t latency = _update_status == 0 ? update.latency : __HOST_LATENCY;
+        uint16_t timeout = _update_status == 0 ? update.supervision_timeout : __HOST_SUPERVISION_TIMEOUT;
+        __dumpEvent(__HCI_LE_META, {__HCI_LE_CONNECTION_UPDATE_COMPLETE, _update_status, (uint8_t)update.handle,
+                                    (uint8_t)(update.handle >> 8), (uint8_t)interval, (uint8_t)(interval >> 8),
+                                    (uint8_t)latency, (uint8_t)(latency >> 8), (uint8_t)timeout,
+                                    (uint8_t)(timeout >> 8)});
+    }
+    _pending_updates.clear();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void SimBLE::connect(const uint8_t address[SIM_BLE_ADDRESS_LEN], uint8_t address_type)
+{
+    memcpy(_central, address ? address : __DEFAULT_CENTRAL, SIM_BLE_ADDRESS_LEN);
+    _central_type = address_type;
+    _connected = true;
+    _handle = __FIRST_CONNECTION_HANDLE + _connection;
+    _connection++;
+    _advertising = false;
+    _directed_advertising = false;
+
+    // Status, handle, role (peripheral), peer address type and address, interval, latency, timeout, clock accuracy
+    std::vector<uint8_t> parameters = {__HCI_LE_CONNECTION_COMPLETE, 0x00, (uint8_t)_handle, (uint8_t)(_handle >> 8),
+                                       0x01, _central_type};
+    parameters.insert(parameters.end(), _central, _central + SIM_BLE_ADDRESS_LEN);
+    parameters.insert(parameters.end(), {__HOST_INTERVAL, 0x00, __HOST_LATENCY, 0x00, __HOST_SUPERVISION_TIMEOUT, 0x00,
+                                         0x00});
+    __dumpEvent(__HCI_LE_META, parameters);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void SimBLE::disconnect()
+{
+    if(!_connected)
+        return;
+
+    // Updates still in progress end with the connection
+    _connected = false;
+    _pending_updates.clear();
+    __dumpEvent(__HCI_DISCONNECTION_COMPLETE, {0x00, (uint8_t)_handle, (uint8_t)(_handle >> 8),
+                                               __HCI_REMOTE_USER_TERMINATED});
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint16_t SimBLE::getConnectionHandle()
+{
+    return _handle;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool SimBLE::isConnected()
+{
+    return _connected;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool SimBLE::isAdvertising()
+{
+    return _advertising;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool SimBLE::isDirectedAdvertising()
+{
+    return _advertising && _directed_advertising;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void SimBLE::setCommandStatus(int status)
+{
+    _command_status = status;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void SimBLE::setUpdateStatus(uint8_t status)
+{
+    _update_status = status;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool SimBLE::isDumpingHCI()
+{
+    return _hci_debug != nullptr;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool SimBLE::pair(const uint8_t ltk[SIM_BLE_KEY_LEN], const uint8_t irk[SIM_BLE_KEY_LEN])
+{
+    if(!_store_ltk || !_store_irk)
+        return false;
+
+    uint8_t key[SIM_BLE_KEY_LEN];
+    memcpy(key, ltk, SIM_BLE_KEY_LEN);
+    _store_ltk(_central, key);
+    memcpy(key, irk, SIM_BLE_KEY_LEN);
+    _store_irk(_central, key);
+    return true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool SimBLE::lookupLTK(uint8_t ltk[SIM_BLE_KEY_LEN])
+{
+    return _get_ltk && _get_ltk(_central, ltk) == 1;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+const std::vector<SimNotification>& SimBLE::getNotifications()
+{
+    return _notifications;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void SimBLE::clearNotifications()
+{
+    _notifications.clear();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+const std::vector<SimConnectionUpdate>& SimBLE::getConnectionUpdates()
+{
+    return _connection_updates;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void SimBLE::reset()
+{
+    _connected = false;
+    _connection = 0;
+    _advertising = false;
+    _directed_advertising = false;
+    _advertising_type = 0;
+    _command_status = 0;
+    _update_status = 0;
+    _pending_updates.clear();
+    _central_type = SIM_BLE_ADDRESS_PUBLIC;
+    _notifications.clear();
+    _connection_updates.clear();
+    _handle = 0;
+    _hci_debug = nullptr;
+    _store_ltk = nullptr;
+    _get_ltk = nullptr;
+    _store_irk = nullptr;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+BLECharacteristic::BLECharacteristic(const char* uuid, uint8_t properties, int value_size, bool fixed_length) :
+_uuid{uuid}
+{
+    (void)properties;
+    (void)value_size;
+    (void)fixed_length;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+int BLECharacteristic::writeValue(const uint8_t value[], int length, bool with_response)
+{
+    (void)with_response;
+    _notifications.push_back({SimClock::now(), _uuid, std::vector<uint8_t>(value, value + length), _connected});
+    return 1;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+int BLECharacteristic::writeValue(uint8_t value, bool with_response)
+{
+    return writeValue(&value, 1, with_response);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool BLECharacteristic::subscribed()
+{
+    return _connected;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+const char* BLECharacteristic::uuid() const
+{
+    return _uuid;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+BLEService::BLEService(const char* uuid) :
+_uuid{uuid}
+{ }
+
+//-----------------------------------------------------------------------------------------------------------------
+void BLEService::addCharacteristic(BLECharacteristic& characteristic)
+{
+    (void)characteristic;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+const char* BLEService::uuid() const
+{
+    return _uuid;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+BLEDevice::BLEDevice() :
+_connection{0}
+{ }
+
+//-----------------------------------------------------------------------------------------------------------------
+BLEDevice::operator bool() const
+{
+    return _connection != 0;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool BLEDevice::connected() const
+{
+    return _connected && _connection == ::_connection;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool BLEDevice::disconnect()
+{
+    if(!connected())
+        return false;
+
+    SimBLE::disconnect();
+    return true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+String BLEDevice::address() const
+{
+    char text[18];
+    snprintf(text, sizeof(text), "%02x:%02x:%02x:%02x:%02x:%02x", _central[5], _central[4], _central[3], _central[2],
+             _central[1], _central[0]);
+    return String(text);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+int BLELocalDevice::begin()
+{
+    return 1;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void BLELocalDevice::end()
+{
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void BLELocalDevice::poll()
+{
+    __deliverUpdates();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void BLELocalDevice::setLocalName(const char* name)
+{
+    (void)name;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void BLELocalDevice::setAdvertisedService(const BLEService& service)
+{
+    (void)service;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void BLELocalDevice::setAppearance(uint16_t appearance)
+{
+    (void)appearance;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void BLELocalDevice::addService(BLEService& service)
+{
+    (void)service;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void BLELocalDevice::setConnectionInterval(uint16_t min_interval, uint16_t max_interval)
+{
+    (void)min_interval;
+    (void)max_interval;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void BLELocalDevice::setPairable(uint8_t pairable)
+{
+    (void)pairable;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+int BLELocalDevice::advertise()
+{
+    _advertising = true;
+    _directed_advertising = false;
+    return 1;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void BLELocalDevice::stopAdvertise()
+{
+    _advertising = false;
+    _directed_advertising = false;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+BLEDevice BLELocalDevice::central()
+{
+    __deliverUpdates();
+
+    BLEDevice device;
+    if(_connected)
+        device._connection = _connection;
+    return device;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool BLELocalDevice::connected() const
+{
+    return _connected;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool BLELocalDevice::disconnect()
+{
+    if(!_connected)
+        return false;
+
+    SimBLE::disconnect();
+    return true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+String BLELocalDevice::address() const
+{
+    return String("c0:ff:ee:00:00:01");
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void BLELocalDevice::setStoreLTK(int (*store)(uint8_t* address, uint8_t* ltk))
+{
+    _store_ltk = store;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void BLELocalDevice::setGetLTK(int (*get)(uint8_t* address, uint8_t* ltk))
+{
+    _get_ltk = get;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void BLELocalDevice::setStoreIRK(int (*store)(uint8_t* address, uint8_t* irk))
+{
+    _store_irk = store;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void BLELocalDevice::setGetIRKs(int (*get)(uint8_t* irk_n, uint8_t** address_types, uint8_t*** addresses,
+                                           uint8_t*** irks))
+{
+    (void)get;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+int HCIClass::leSetAdvertisingParameters(uint16_t min_interval, uint16_t max_interval, uint8_t advertising_type,
+                                         uint8_t own_address_type, uint8_t direct_address_type,
+                                         uint8_t direct_address[6], uint8_t channel_map, uint8_t filter)
+{
+    (void)min_interval;
+    (void)max_interval;
+    (void)own_address_type;
+    (void)direct_address_type;
+    (void)direct_address;
+    (void)channel_map;
+    (void)filter;
+
+    if(_command_status == 0)
+        _advertising_type = advertising_type;
+    return _command_status;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+int HCIClass::leSetAdvertiseEnable(uint8_t enable)
+{
+    if(_command_status != 0)
+        return _command_status;
+
+    _advertising = enable != 0;
+    _directed_advertising = _advertising && _advertising_type == __ADV_DIRECT_IND_HIGH_DUTY;
+    return 0;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+int HCIClass::leConnUpdate(uint16_t handle, uint16_t min_interval, uint16_t max_interval, uint16_t latency,
+                           uint16_t supervision_timeout)
+{
+    int status = _command_status;
+    if(status == 0 && (!_connected || handle != _handle))
+        status = __HCI_UNKNOWN_CONNECTION;
+
+    _connection_updates.push_back({SimClock::now(), handle, min_interval, max_interval, latency, supervision_timeout,
+                                   status});
+    if(status != 0)
+        return status;
+
+    // The controller negotiates with the host, the outcome is reported later
+    _pending_updates.push_back(_connection_updates.back());
+    return 0;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void HCIClass::debug(Stream& stream)
+{
+    _hci_debug = &stream;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void HCIClass::noDebug()
+{
+    _hci_debug = nullptr;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint16_t ATTClass::connectionHandle(uint8_t address_type, const uint8_t address[6]) const
+{
+    if(!_connected || address_type != _central_type || memcmp(address, _central, SIM_BLE_ADDRESS_LEN) != 0)
+        return 0xFFFF;
+    return _handle;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+// Serial
+//-----------------------------------------------------------------------------------------------------------------
+
+static std::string _serial_output;
+static std::deque<uint8_t> _serial_input;
+static int _serial_write_room = 64;
+
+HardwareSerial Serial;
+
+//-----------------------------------------------------------------------------------------------------------------
+const std::string& SimSerial::getOutput()
+{
+    return _serial_output;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void SimSerial::clearOutput()
+{
+    _serial_output.clear();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void SimSerial::input(const char* text)
+{
+    while(*text)
+        _serial_input.push_back((uint8_t)*text++);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void SimSerial::setWriteRoom(int bytes)
+{
+    _serial_write_room = bytes;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void SimSerial::reset()
+{
+    _serial_output.clear();
+    _serial_input.clear();
+    _serial_write_room = 64;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void HardwareSerial::begin(unsigned long baud)
+{
+    (void)baud;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void HardwareSerial::end()
+{
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+HardwareSerial::operator bool()
+{
+    return true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+int HardwareSerial::available()
+{
+    return _serial_input.size();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+int HardwareSerial::read()
+{
+    if(_serial_input.empty())
+        return -1;
+
+    uint8_t value = _serial_input.front();
+    _serial_input.pop_front();
+    return value;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+int HardwareSerial::peek()
+{
+    return _serial_input.empty() ? -1 : _serial_input.front();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+size_t HardwareSerial::write(uint8_t value)
+{
+    _serial_output.push_back((char)value);
+    return 1;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+size_t HardwareSerial::write(const uint8_t buffer[], size_t size)
+{
+    _serial_output.append((const char*)buffer, size);
+    return size;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+int HardwareSerial::availableForWrite()
+{
+    return _serial_write_room;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+// Print
+//-----------------------------------------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------------------------------------
+size_t Print::write(const uint8_t buffer[], size_t size)
+{
+    size_t written = 0;
+    while(written < size && write(buffer[written]))
+        written++;
+    return written;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+size_t Print::__printNumber(unsigned long value, int base, bool negative)
+{
+    char text[8 * sizeof(long) + 2];
+    char* c = &text[sizeof(text) - 1];
+    *c = '\0';
+    if(base < 2)
+        base = 10;
+
+    do
+    {
+        unsigned long digit = value % base;
+        *--c = digit < 10 ? '0' + digit : 'A' + digit - 10;
+        value /= base;
+    }
+    while(value);
+
+    if(negative)
+        *--c = '-';
+    return write(c);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+size_t Print::print(const char text[])
+{
+    return write(text);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+size_t Print::print(const String& text)
+{
+    return write(text.c_str());
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+size_t Print::print(char value)
+{
+    return write((uint8_t)value);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+size_t Print::print(unsigned char value, int base)
+{
+    return __printNumber(value, base, false);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+size_t Print::print(int value, int base)
+{
+    return print((long)value, base);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+size_t Print::print(unsigned int value, int base)
+{
+    return __printNumber(value, base, false);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+size_t Print::print(long value, int base)
+{
+    // Like the Arduino core, only decimal numbers are printed with a sign
+    if(base == 10 && value < 0)
+        return __printNumber(-(unsigned long)value, base, true);
+    return __printNumber((unsigned long)value, base, false);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+size_t Print::print(unsigned long value, int base)
+{
+    return __printNumber(value, base, false);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+size_t Print::print(double value, int digits)
+{
+    char text[64];
+    snprintf(text, sizeof(text), "%.*f", digits, value);
+    return write(text);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+size_t Print::println()
+{
+    return write("\r\n");
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+size_t Print::println(const char text[])
+{
+    return print(text) + println();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+size_t Print::println(const String& text)
+{
+    return print(text) + println();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+size_t Print::println(char value)
+{
+    return print(value) + println();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+size_t Print::println(unsigned char value, int base)
+{
+    return print(value, base) + println();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+size_t Print::println(int value, int base)
+{
+    return print(value, base) + println();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+size_t Print::println(unsigned int value, int base)
+{
+    return print(value, base) + println();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+size_t Print::println(long value, int base)
+{
+    return print(value, base) + println();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+size_t Print::println(unsigned long value, int base)
+{
+    return print(value, base) + println();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+size_t Print::println(double value, int digits)
+{
+    return print(value, digits) + println();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+// Simulation
+//-----------------------------------------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------------------------------------
+void Sim::reset()
+{
+    SimClock::reset();
+    SimGPIO::reset();
+    SimI2C::reset();
+    SimBLE::reset();
+    SimSerial::reset();
+}
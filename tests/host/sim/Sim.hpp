@@ -0,0 +1,351 @@
+/**********************************************************************
+ * Sim.hpp
+ * 
+ * The simulated hardware behind the stand-in Arduino headers. Tests and
+ * the replay driver use it to script what the modules see:
+ *   - SimClock: the time base of micros(), advanced explicitly or by
+ *     blocking calls (delay, bus transfers). Timers of device models
+ *     fire while the clock passes them, like interrupts would.
+ *   - SimGPIO: pin levels. Inputs are driven externally, switches can
+ *     connect two pins (a button in a matrix), so a pulled up input
+ *     reads low while a closed path leads to an output driven low.
+ *     Edges on pins with an attached interrupt call the routine.
+ *   - SimI2C: devices on the bus by address, bus timing and injected
+ *     faults (stalls, truncated reads, NAKs).
+ *   - SimBLE: the connection to a central and a log of every value
+ *     written to a characteristic and every HCI command.
+ *   - SimSerial: captures the Serial output and feeds its input.
+ * Sim::reset() brings everything back to power on.
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#ifndef SIM_HPP
+#define SIM_HPP
+
+#include <Arduino.h>
+#include <string>
+#include <vector>
+
+#define SIM_PIN_N 64
+
+// Time the bus needs per byte incl. acknowledge at the default clock of 100kHz
+#define SIM_I2C_DEFAULT_BYTE_US 90
+
+#define SIM_BLE_ADDRESS_LEN 6
+#define SIM_BLE_KEY_LEN 16
+
+// Address types of a central
+#define SIM_BLE_ADDRESS_PUBLIC 0x00
+#define SIM_BLE_ADDRESS_RANDOM 0x01
+
+class Sim
+{
+    public:
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Resets the clock, all pins, the bus, the BLE connection and the Serial.
+    //
+    static void reset();
+};
+
+//-----------------------------------------------------------------------------------------------------------------
+///
+/// Something in the simulation which acts at certain points in time, e.g. a sensor sampling at its output data rate.
+//
+class SimTimer
+{
+    public:
+    virtual ~SimTimer() { }
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the time of the next action in microseconds, UINT64_MAX if none is planned.
+    //
+    virtual uint64_t getNextTime() = 0;
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Performs the action planned for the current time.
+    //
+    virtual void fire() = 0;
+};
+
+class SimClock
+{
+    public:
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the simulated time since boot in microseconds.
+    //
+    static uint64_t now();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Moves the time forward and fires every timer which is due on the way, in order.
+    ///
+    /// @param us           The time to pass in microseconds.
+    //
+    static void advance(uint64_t us);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Moves the time forward to the given point. Does nothing if it already passed.
+    //
+    static void advanceTo(uint64_t time);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Registers a timer. The timer has to stay valid until it is removed or the simulation is reset.
+    //
+    static void addTimer(SimTimer& timer);
+    static void removeTimer(SimTimer& timer);
+
+    static void reset();
+};
+
+class SimGPIO
+{
+    public:
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Drives an input pin from the outside, e.g. the interrupt line of a sensor.
+    ///
+    /// @param pin          The pin.
+    /// @param level        HIGH or LOW.
+    //
+    static void setLevel(uint8_t pin, uint8_t level);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Opens or closes a switch between two pins. Closed switches conduct in both directions, so a matrix without
+    /// diodes shows ghost connections like the real one.
+    //
+    static void setSwitch(uint8_t pin_a, uint8_t pin_b, bool closed);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the level a pin reads right now.
+    //
+    static uint8_t getLevel(uint8_t pin);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the mode set with pinMode(), INPUT after reset.
+    //
+    static uint8_t getMode(uint8_t pin);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns how many pins have an interrupt attached right now, and the most there ever were at once.
+    //
+    static uint8_t getAttachedInterruptCount();
+    static uint8_t getMaxAttachedInterruptCount();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns how many interrupt routines were called since the reset.
+    //
+    static uint32_t getInterruptCount();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns how many calls of pinMode(), digitalWrite() and digitalRead() there were since the reset.
+    //
+    static uint32_t getPinCallCount();
+
+    static void reset();
+};
+
+//-----------------------------------------------------------------------------------------------------------------
+///
+/// A device on the simulated I2C bus.
+//
+class SimI2CDevice
+{
+    public:
+    virtual ~SimI2CDevice() { }
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Receives the bytes of a write transaction.
+    ///
+    /// @return False to not acknowledge the transaction.
+    //
+    virtual bool write(const uint8_t data[], uint16_t length) = 0;
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Answers a read transaction.
+    ///
+    /// @return The number of bytes sent, 0 to not acknowledge the transaction.
+    //
+    virtual uint16_t read(uint8_t data[], uint16_t length) = 0;
+};
+
+// Faults the bus injects into the next transactions
+struct SimI2CFaults
+{
+    uint32_t stall_us;          // Additional time every transaction takes, e.g. clock stretching
+    int16_t truncate_to;        // Reads deliver at most this many bytes, -1 for complete reads
+    bool nak_write;             // Write transactions are not acknowledged
+    bool nak_read;              // Read transactions are not acknowledged
+};
+
+class SimI2C
+{
+    public:
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Puts a device on the bus. The device has to stay valid until the simulation is reset.
+    //
+    static void addDevice(uint8_t address, SimI2CDevice& device);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Injects faults into the next transactions.
+    ///
+    /// @param faults           The faults.
+    /// @param transactions     The number of transactions affected.
+    //
+    static void setFaults(const SimI2CFaults& faults, uint32_t transactions = UINT32_MAX);
+    static void clearFaults();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Sets the time the bus needs per byte. The default matches 100kHz.
+    //
+    static void setByteTime(uint32_t byte_us);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the number of transactions (reads and writes) since the reset.
+    //
+    static uint32_t getTransactionCount();
+
+    static void reset();
+};
+
+// A value written to a characteristic
+struct SimNotification
+{
+    uint64_t time;
+    std::string uuid;
+    std::vector<uint8_t> data;
+    bool connected;             // False if no central was connected to receive it
+};
+
+// A connection parameter update requested over the HCI
+struct SimConnectionUpdate
+{
+    uint64_t time;
+    uint16_t handle;
+    uint16_t min_interval;
+    uint16_t max_interval;
+    uint16_t latency;
+    uint16_t supervision_timeout;
+    int status;                 // What the command returned
+};
+
+class SimBLE
+{
+    public:
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Connects a central. Advertising stops like on the controller. Every connection gets a new handle and starts
+    /// with parameters picked by the host, both are reported in an LE connection complete event on the HCI debug
+    /// stream. ATT.connectionHandle() finds the handle by the address of the central.
+    ///
+    /// @param address      The identity address of the central, a default one if nullptr.
+    /// @param address_type The type of the address, SIM_BLE_ADDRESS_PUBLIC or SIM_BLE_ADDRESS_RANDOM.
+    //
+    static void connect(const uint8_t address[SIM_BLE_ADDRESS_LEN] = nullptr,
+                        uint8_t address_type = SIM_BLE_ADDRESS_PUBLIC);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Drops the connection to the central.
+    //
+    static void disconnect();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the handle of the current or last connection.
+    //
+    static uint16_t getConnectionHandle();
+
+    static bool isConnected();
+    static bool isAdvertising();
+    static bool isDirectedAdvertising();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Sets the status the HCI LE commands return, 0 for success. A connection update to anything but the handle of
+    /// the current connection fails anyway. An accepted one is answered with an LE connection update complete event
+    /// on the next BLE.poll() or BLE.central(), like the BLE stack handles the events of the controller there.
+    //
+    static void setCommandStatus(int status);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Sets the status of the LE connection update complete events. With 0 the host settles on the longest interval
+    /// of the requested range, otherwise the connection keeps its parameters.
+    //
+    static void setUpdateStatus(uint8_t status);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns true while a stream is attached with HCI.debug().
+    //
+    static bool isDumpingHCI();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Pairs the connected central like the BLE stack does after a successful pairing: the keys are handed to the
+    /// callbacks registered with setStoreLTK() and setStoreIRK().
+    ///
+    /// @return False if no callbacks are registered.
+    //
+    static bool pair(const uint8_t ltk[SIM_BLE_KEY_LEN], const uint8_t irk[SIM_BLE_KEY_LEN]);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Looks up the long term key of the connected central through the callback registered with setGetLTK(), like
+    /// the BLE stack does when a bonded central encrypts the link.
+    //
+    static bool lookupLTK(uint8_t ltk[SIM_BLE_KEY_LEN]);
+
+    static const std::vector<SimNotification>& getNotifications();
+    static void clearNotifications();
+    static const std::vector<SimConnectionUpdate>& getConnectionUpdates();
+
+    static void reset();
+};
+
+class SimSerial
+{
+    public:
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns everything written to the Serial since the last clear.
+    //
+    static const std::string& getOutput();
+    static void clearOutput();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Queues bytes to be read from the Serial.
+    //
+    static void input(const char* text);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Sets what availableForWrite() returns.
+    //
+    static void setWriteRoom(int bytes);
+
+    static void reset();
+};
+
+#endif // SIM_HPP
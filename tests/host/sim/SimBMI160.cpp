@@ -0,0 +1,251 @@
+/**********************************************************************
+ * SimBMI160.cpp
+ * 
+ * Implementation of the SimBMI160 class.
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#include "SimBMI160.hpp"
+
+// Commands
+#define __CMD_ACC_NORMAL 0x11
+#define __CMD_GYR_NORMAL 0x15
+#define __CMD_FIFO_FLUSH 0xB0
+
+// Headerless frames with gyroscope and accelerometer data
+#define __FIFO_GYR_ACC 0xC0
+#define __FIFO_FRAME_LEN 12
+
+// Pattern the FIFO returns once it is read empty
+#define __FIFO_EMPTY 0x80
+
+//-----------------------------------------------------------------------------------------------------------------
+SimBMI160::SimBMI160(uint8_t int1_pin) :
+_int1_pin{int1_pin},
+_address{0},
+_fifo_overflows{0},
+_acc_normal_time{UINT64_MAX},
+_gyr_normal_time{UINT64_MAX},
+_next_sample_time{UINT64_MAX},
+_sample_count{0},
+_sampling{true},
+_constant_sample{0, 0, 0, 0, 0, 16384}      // At rest, 1g on the z axis at the default range
+{
+    memset(_registers, 0, sizeof(_registers));
+    _registers[SIM_BMI160_REG_CHIP_ID] = SIM_BMI160_CHIP_ID;
+    _registers[SIM_BMI160_REG_ACC_CONF] = 0x28;
+    _registers[SIM_BMI160_REG_ACC_CONF + 1] = 0x03;
+    _registers[SIM_BMI160_REG_GYR_CONF] = 0x28;
+    _registers[SIM_BMI160_REG_FIFO_CONFIG_1] = 0x10;
+
+    SimI2C::addDevice(SIM_BMI160_ADDRESS, *this);
+    SimClock::addTimer(*this);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void SimBMI160::setSampleSource(SimSampleSource source)
+{
+    _source = source;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void SimBMI160::setConstantSample(const int16_t sample[6])
+{
+    memcpy(_constant_sample, sample, sizeof(_constant_sample));
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void SimBMI160::pushFifo(const uint8_t data[], uint16_t length)
+{
+    for(uint16_t i = 0; i < length; i++)
+        _fifo.push_back(data[i]);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void SimBMI160::setSampling(bool enabled)
+{
+    if(enabled && !_sampling)
+        _next_sample_time = SimClock::now() + getSampleInterval();
+    _sampling = enabled;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void SimBMI160::setRegister(uint8_t reg, uint8_t value)
+{
+    _registers[reg & 0x7F] = value;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint8_t SimBMI160::getRegister(uint8_t reg)
+{
+    return _registers[reg & 0x7F];
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint32_t SimBMI160::getSampleCount()
+{
+    return _sample_count;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint16_t SimBMI160::getFifoLength()
+{
+    return _fifo.size();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint32_t SimBMI160::getFifoOverflows()
+{
+    return _fifo_overflows;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint32_t SimBMI160::getSampleInterval()
+{
+    // 100Hz at ODR 8, doubling with every step
+    int8_t step = (_registers[SIM_BMI160_REG_GYR_CONF] & 0x0F) - 8;
+    return step >= 0 ? 10000 >> step : 10000 << -step;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool SimBMI160::write(const uint8_t data[], uint16_t length)
+{
+    if(length == 0)
+        return true;
+
+    _address = data[0] & 0x7F;
+    for(uint16_t i = 1; i < length; i++)
+    {
+        if(_address == SIM_BMI160_REG_CMD)
+            __command(data[i]);
+        else
+            _registers[_address] = data[i];
+        _address = (_address + 1) & 0x7F;
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint16_t SimBMI160::read(uint8_t data[], uint16_t length)
+{
+    uint64_t now = SimClock::now();
+    for(uint16_t i = 0; i < length; i++)
+    {
+        // The FIFO data register does not advance the address, every read pops the next byte
+        if(_address == SIM_BMI160_REG_FIFO_DATA)
+        {
+            if(_fifo.empty())
+            {
+                data[i] = __FIFO_EMPTY;
+            }
+            else
+            {
+                data[i] = _fifo.front();
+                _fifo.pop_front();
+            }
+            continue;
+        }
+
+        switch(_address)
+        {
+            case SIM_BMI160_REG_PMU_STATUS:
+                data[i] = (now >= _acc_normal_time ? 0b01 << 4 : 0) | (now >= _gyr_normal_time ? 0b01 << 2 : 0);
+                break;
+            case SIM_BMI160_REG_FIFO_LENGTH:
+                data[i] = _fifo.size() & 0xFF;
+                break;
+            case SIM_BMI160_REG_FIFO_LENGTH + 1:
+                data[i] = (_fifo.size() >> 8) & 0x07;
+                break;
+            default:
+                data[i] = _registers[_address];
+        }
+        _address = (_address + 1) & 0x7F;
+    }
+    return length;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+uint64_t SimBMI160::getNextTime()
+{
+    return __isRunning() ? _next_sample_time : UINT64_MAX;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void SimBMI160::fire()
+{
+    __takeSample();
+    _next_sample_time += getSampleInterval();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool SimBMI160::__isRunning()
+{
+    return _sampling && _gyr_normal_time != UINT64_MAX;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void SimBMI160::__command(uint8_t command)
+{
+    uint64_t now = SimClock::now();
+    switch(command)
+    {
+        case __CMD_ACC_NORMAL:
+            if(_acc_normal_time == UINT64_MAX)
+                _acc_normal_time = now + SIM_BMI160_ACC_STARTUP_US;
+            break;
+        case __CMD_GYR_NORMAL:
+            if(_gyr_normal_time == UINT64_MAX)
+            {
+                _gyr_normal_time = now + SIM_BMI160_GYR_STARTUP_US;
+                _next_sample_time = _gyr_normal_time + getSampleInterval();
+            }
+            break;
+        case __CMD_FIFO_FLUSH:
+            _fifo.clear();
+            break;
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void SimBMI160::__takeSample()
+{
+    int16_t sample[6];
+    if(_source)
+        _source(sample);
+    else
+        memcpy(sample, _constant_sample, sizeof(sample));
+    _sample_count++;
+
+    // Gyroscope and accelerometer data registers, little endian
+    uint8_t frame[__FIFO_FRAME_LEN];
+    for(int axis = 0; axis < 6; axis++)
+    {
+        frame[2 * axis] = sample[axis] & 0xFF;
+        frame[2 * axis + 1] = (sample[axis] >> 8) & 0xFF;
+    }
+    memcpy(&_registers[SIM_BMI160_REG_DATA], frame, sizeof(frame));
+
+    if((_registers[SIM_BMI160_REG_FIFO_CONFIG_1] & __FIFO_GYR_ACC) == __FIFO_GYR_ACC)
+    {
+        // A full FIFO drops its oldest frame
+        if(_fifo.size() + __FIFO_FRAME_LEN > SIM_BMI160_FIFO_LEN)
+        {
+            _fifo.erase(_fifo.begin(), _fifo.begin() + __FIFO_FRAME_LEN);
+            _fifo_overflows++;
+        }
+        pushFifo(frame, sizeof(frame));
+    }
+
+    // Data ready on INT1 as a short pulse
+    bool int1_output = _registers[SIM_BMI160_REG_INT_OUT_CTRL] & 0b00001000;
+    bool data_ready_int1 = (_registers[SIM_BMI160_REG_INT_EN_1] & 0b00010000) &&
+                           (_registers[SIM_BMI160_REG_INT_MAP_1] & 0b10000000);
+    if(int1_output && data_ready_int1)
+    {
+        SimGPIO::setLevel(_int1_pin, HIGH);
+        SimGPIO::setLevel(_int1_pin, LOW);
+    }
+}
@@ -0,0 +1,136 @@
+/**********************************************************************
+ * SimBMI160.hpp
+ * 
+ * A register level model of the BMI160 on the simulated I2C bus. Covers
+ * what the BMI160 class uses:
+ *   - power mode commands with the startup time of each sensor, visible
+ *     in the PMU status register
+ *   - configuration and range registers which read back as written
+ *   - the data registers and the headerless FIFO (gyroscope and
+ *     accelerometer frames, oldest frames dropped when full)
+ *   - the data ready interrupt on INT1
+ * While a sensor is in normal mode the model samples at the output data
+ * rate of the gyroscope. The values come from a sample source, e.g. a
+ * recorded trace, constant otherwise.
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#ifndef SIMBMI160_HPP
+#define SIMBMI160_HPP
+
+#include "Sim.hpp"
+#include <deque>
+#include <functional>
+
+#define SIM_BMI160_ADDRESS 0x69
+#define SIM_BMI160_CHIP_ID 0xD1
+#define SIM_BMI160_FIFO_LEN 1024
+
+// Time from the power mode command until the sensor runs in normal mode
+#define SIM_BMI160_ACC_STARTUP_US 3800
+#define SIM_BMI160_GYR_STARTUP_US 80000
+
+// Register addresses
+#define SIM_BMI160_REG_CHIP_ID 0x00
+#define SIM_BMI160_REG_ERROR 0x02
+#define SIM_BMI160_REG_PMU_STATUS 0x03
+#define SIM_BMI160_REG_DATA 0x0C
+#define SIM_BMI160_REG_FIFO_LENGTH 0x22
+#define SIM_BMI160_REG_FIFO_DATA 0x24
+#define SIM_BMI160_REG_ACC_CONF 0x40
+#define SIM_BMI160_REG_GYR_CONF 0x42
+#define SIM_BMI160_REG_FIFO_CONFIG_1 0x47
+#define SIM_BMI160_REG_INT_EN_1 0x51
+#define SIM_BMI160_REG_INT_OUT_CTRL 0x53
+#define SIM_BMI160_REG_INT_MAP_1 0x56
+#define SIM_BMI160_REG_CMD 0x7E
+
+// Provides the next sample in the axes order of the BMI160 class (gyroscope x, y, z, accelerometer x, y, z)
+typedef std::function<void(int16_t sample[6])> SimSampleSource;
+
+class SimBMI160 : public SimI2CDevice, public SimTimer
+{
+    public:
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Constructor. Puts the model on the bus and registers its timer, so it has to be constructed after Sim::reset().
+    ///
+    /// @param int1_pin     The pin the INT1 output is connected to.
+    //
+    SimBMI160(uint8_t int1_pin);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Sets where the samples come from. Without a source, the constant sample is repeated.
+    //
+    void setSampleSource(SimSampleSource source);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Sets the sample used without a source.
+    //
+    void setConstantSample(const int16_t sample[6]);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Puts frames into the FIFO directly, e.g. to test the decoding of canned FIFO contents.
+    ///
+    /// @param data         The raw FIFO bytes.
+    /// @param length       The number of bytes.
+    //
+    void pushFifo(const uint8_t data[], uint16_t length);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Stops or resumes sampling, e.g. to fill the FIFO by hand.
+    //
+    void setSampling(bool enabled);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Sets or reads a register directly, without a bus transfer.
+    //
+    void setRegister(uint8_t reg, uint8_t value);
+    uint8_t getRegister(uint8_t reg);
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the number of samples taken, the bytes in the FIFO and the frames dropped by a full FIFO.
+    //
+    uint32_t getSampleCount();
+    uint16_t getFifoLength();
+    uint32_t getFifoOverflows();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Returns the sample interval set by the gyroscope output data rate in microseconds.
+    //
+    uint32_t getSampleInterval();
+
+    bool write(const uint8_t data[], uint16_t length) override;
+    uint16_t read(uint8_t data[], uint16_t length) override;
+    uint64_t getNextTime() override;
+    void fire() override;
+
+    private:
+    uint8_t _int1_pin;
+    uint8_t _registers[128];
+    uint8_t _address;
+    std::deque<uint8_t> _fifo;
+    uint32_t _fifo_overflows;
+    uint64_t _acc_normal_time;
+    uint64_t _gyr_normal_time;
+    uint64_t _next_sample_time;
+    uint32_t _sample_count;
+    bool _sampling;
+    int16_t _constant_sample[6];
+    SimSampleSource _source;
+
+    bool __isRunning();
+    void __command(uint8_t command);
+    void __takeSample();
+};
+
+#endif // SIMBMI160_HPP
@@ -0,0 +1,45 @@
+/**********************************************************************
+ * SimTrace.cpp
+ * 
+ * Implementation of the SimTrace class.
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#include "SimTrace.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <stdlib.h>
+
+// Timestamp and sequence number come first, followed by the raw axes
+#define __FIRST_RAW_COLUMN 2
+
+//-----------------------------------------------------------------------------------------------------------------
+bool SimTrace::load(const char* path, std::vector<std::vector<int16_t>>& samples)
+{
+    std::ifstream file(path);
+    if(!file)
+        return false;
+
+    std::string line;
+    while(std::getline(file, line))
+    {
+        if(line.empty() || line[0] == '#' || line.compare(0, 9, "timestamp") == 0)
+            continue;
+
+        std::vector<int16_t> sample;
+        std::stringstream fields(line);
+        std::string field;
+        for(int column = 0; std::getline(fields, field, ',') && column < __FIRST_RAW_COLUMN + SIM_TRACE_AXES; column++)
+        {
+            if(column >= __FIRST_RAW_COLUMN)
+                sample.push_back((int16_t)atoi(field.c_str()));
+        }
+        if(sample.size() == SIM_TRACE_AXES)
+            samples.push_back(sample);
+    }
+    return true;
+}
@@ -0,0 +1,39 @@
+/**********************************************************************
+ * SimTrace.hpp
+ * 
+ * Reads the recorded IMU traces in traces/ for the replays, benchmarks
+ * and tests. A trace is a CSV file as written by
+ * tools/telemetry_decode.py, only the raw columns are used. Lines
+ * starting with '#' are comments.
+ * Tests find the traces in SIM_TRACE_DIR, which the build sets to the
+ * traces/ directory of the sources.
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#ifndef SIMTRACE_HPP
+#define SIMTRACE_HPP
+
+#include <stdint.h>
+#include <vector>
+
+// Axes of a sample in the order of the BMI160 class (gyroscope x, y, z, accelerometer x, y, z)
+#define SIM_TRACE_AXES 6
+
+class SimTrace
+{
+    public:
+    //-----------------------------------------------------------------------------------------------------------------
+    ///
+    /// Reads the raw samples of a trace.
+    ///
+    /// @param path         The path of the CSV file.
+    /// @param samples      The vector to append the samples to, SIM_TRACE_AXES values each.
+    ///
+    /// @return False if the file cannot be read.
+    //
+    static bool load(const char* path, std::vector<std::vector<int16_t>>& samples);
+};
+
+#endif // SIMTRACE_HPP
@@ -0,0 +1,132 @@
+/**********************************************************************
+ * Arduino.h
+ * 
+ * Stand-in for the Arduino core on the host. Declares the part of the
+ * Arduino API the modules use. Time, pins and the Serial are backed by
+ * the simulation in sim/Sim.hpp, so the modules compile unchanged and
+ * run against scripted hardware.
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <string>
+
+#define HIGH 1
+#define LOW 0
+
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+
+#define PI 3.1415926535897932384626433832795
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+using std::min;
+using std::max;
+
+typedef uint8_t byte;
+
+unsigned long micros();
+unsigned long millis();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int digitalPinToInterrupt(uint8_t pin);
+void attachInterrupt(int interrupt, void (*isr)(), int mode);
+void detachInterrupt(int interrupt);
+void noInterrupts();
+void interrupts();
+
+class String
+{
+    public:
+    String(const char* text = "") : _text{text} { }
+    String(const std::string& text) : _text{text} { }
+    const char* c_str() const { return _text.c_str(); }
+    unsigned int length() const { return _text.length(); }
+    bool operator==(const String& other) const { return _text == other._text; }
+
+    private:
+    std::string _text;
+};
+
+class Print
+{
+    public:
+    virtual ~Print() { }
+    virtual size_t write(uint8_t value) = 0;
+    virtual size_t write(const uint8_t buffer[], size_t size);
+    virtual int availableForWrite() { return 0; }
+
+    size_t write(const char* text) { return write((const uint8_t*)text, strlen(text)); }
+
+    size_t print(const char text[]);
+    size_t print(const String& text);
+    size_t print(char value);
+    size_t print(unsigned char value, int base = 10);
+    size_t print(int value, int base = 10);
+    size_t print(unsigned int value, int base = 10);
+    size_t print(long value, int base = 10);
+    size_t print(unsigned long value, int base = 10);
+    size_t print(double value, int digits = 2);
+
+    size_t println();
+    size_t println(const char text[]);
+    size_t println(const String& text);
+    size_t println(char value);
+    size_t println(unsigned char value, int base = 10);
+    size_t println(int value, int base = 10);
+    size_t println(unsigned int value, int base = 10);
+    size_t println(long value, int base = 10);
+    size_t println(unsigned long value, int base = 10);
+    size_t println(double value, int digits = 2);
+
+    private:
+    size_t __printNumber(unsigned long value, int base, bool negative);
+};
+
+class Stream : public Print
+{
+    public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+};
+
+class HardwareSerial : public Stream
+{
+    public:
+    void begin(unsigned long baud);
+    void end();
+    explicit operator bool();
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t write(uint8_t value) override;
+    size_t write(const uint8_t buffer[], size_t size) override;
+    int availableForWrite() override;
+    using Print::write;
+};
+
+extern HardwareSerial Serial;
+
+#endif // ARDUINO_H
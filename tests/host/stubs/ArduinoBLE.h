@@ -0,0 +1,101 @@
+/**********************************************************************
+ * ArduinoBLE.h
+ * 
+ * Stand-in for the ArduinoBLE library on the host. Connections are
+ * driven by SimBLE, every value written to a characteristic is recorded
+ * there as a notification.
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#ifndef ARDUINOBLE_H
+#define ARDUINOBLE_H
+
+#include <Arduino.h>
+
+#define BLEBroadcast 0x01
+#define BLERead 0x02
+#define BLEWriteWithoutResponse 0x04
+#define BLEWrite 0x08
+#define BLENotify 0x10
+#define BLEIndicate 0x20
+
+enum Pairable
+{
+    NO = 0,
+    YES = 1,
+    ONCE = 2
+};
+
+class BLECharacteristic
+{
+    public:
+    BLECharacteristic(const char* uuid, uint8_t properties, int value_size, bool fixed_length = false);
+
+    int writeValue(const uint8_t value[], int length, bool with_response = true);
+    int writeValue(uint8_t value, bool with_response = true);
+    bool subscribed();
+    const char* uuid() const;
+
+    private:
+    const char* _uuid;
+};
+
+class BLEService
+{
+    public:
+    BLEService(const char* uuid);
+
+    void addCharacteristic(BLECharacteristic& characteristic);
+    const char* uuid() const;
+
+    private:
+    const char* _uuid;
+};
+
+class BLEDevice
+{
+    public:
+    BLEDevice();
+
+    explicit operator bool() const;
+    bool connected() const;
+    bool disconnect();
+    String address() const;
+
+    private:
+    friend class BLELocalDevice;
+    uint32_t _connection;       // Number of the simulated connection, 0 for no device
+};
+
+class BLELocalDevice
+{
+    public:
+    int begin();
+    void end();
+    void poll();
+
+    void setLocalName(const char* name);
+    void setAdvertisedService(const BLEService& service);
+    void setAppearance(uint16_t appearance);
+    void addService(BLEService& service);
+    void setConnectionInterval(uint16_t min_interval, uint16_t max_interval);
+    void setPairable(uint8_t pairable);
+
+    int advertise();
+    void stopAdvertise();
+    BLEDevice central();
+    bool connected() const;
+    bool disconnect();
+    String address() const;
+
+    void setStoreLTK(int (*store)(uint8_t* address, uint8_t* ltk));
+    void setGetLTK(int (*get)(uint8_t* address, uint8_t* ltk));
+    void setStoreIRK(int (*store)(uint8_t* address, uint8_t* irk));
+    void setGetIRKs(int (*get)(uint8_t* irk_n, uint8_t** address_types, uint8_t*** addresses, uint8_t*** irks));
+};
+
+extern BLELocalDevice& BLE;
+
+#endif // ARDUINOBLE_H
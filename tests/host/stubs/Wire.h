@@ -0,0 +1,47 @@
+/**********************************************************************
+ * Wire.h
+ * 
+ * Stand-in for the Arduino I2C library on the host. Transfers go to the
+ * simulated devices registered with SimI2C and take the time they would
+ * take on the bus.
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#ifndef WIRE_H
+#define WIRE_H
+
+#include <Arduino.h>
+
+#define WIRE_BUFFER_LEN 256
+
+class TwoWire
+{
+    public:
+    void begin();
+    void end();
+    void setClock(uint32_t frequency);
+
+    void beginTransmission(uint8_t address);
+    size_t write(uint8_t value);
+    size_t write(const uint8_t buffer[], size_t size);
+    uint8_t endTransmission(bool stop = true);
+
+    uint8_t requestFrom(int address, int length, bool stop = true);
+    int available();
+    int read();
+    int peek();
+
+    private:
+    uint8_t _address;
+    uint8_t _tx[WIRE_BUFFER_LEN];
+    uint16_t _tx_n;
+    uint8_t _rx[WIRE_BUFFER_LEN];
+    uint16_t _rx_n;
+    uint16_t _rx_pos;
+};
+
+extern TwoWire Wire;
+
+#endif // WIRE_H
@@ -0,0 +1,25 @@
+/**********************************************************************
+ * ATT.h
+ * 
+ * Stand-in for the ATT layer of ArduinoBLE on the host. Only the lookup
+ * of the handle of a connection by the address of its central, which
+ * SimBLE answers for the connected central.
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#ifndef ATT_H
+#define ATT_H
+
+#include <Arduino.h>
+
+class ATTClass
+{
+    public:
+    uint16_t connectionHandle(uint8_t address_type, const uint8_t address[6]) const;
+};
+
+extern ATTClass& ATT;
+
+#endif // ATT_H
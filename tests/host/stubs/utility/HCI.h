@@ -0,0 +1,34 @@
+/**********************************************************************
+ * HCI.h
+ * 
+ * Stand-in for the HCI layer of ArduinoBLE on the host. Commands are
+ * recorded by SimBLE and answered with the status it is set up with.
+ * The connection events of SimBLE are dumped to the debug stream in
+ * the format of ArduinoBLE.
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#ifndef HCI_H
+#define HCI_H
+
+#include <Arduino.h>
+
+class HCIClass
+{
+    public:
+    int leSetAdvertisingParameters(uint16_t min_interval, uint16_t max_interval, uint8_t advertising_type,
+                                   uint8_t own_address_type, uint8_t direct_address_type, uint8_t direct_address[6],
+                                   uint8_t channel_map, uint8_t filter);
+    int leSetAdvertiseEnable(uint8_t enable);
+    int leConnUpdate(uint16_t handle, uint16_t min_interval, uint16_t max_interval, uint16_t latency,
+                     uint16_t supervision_timeout);
+
+    void debug(Stream& stream);
+    void noDebug();
+};
+
+extern HCIClass& HCI;
+
+#endif // HCI_H
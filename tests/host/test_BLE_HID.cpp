@@ -0,0 +1,357 @@
+/**********************************************************************
+ * test_BLE_HID.cpp
+ * 
+ * Tests of the report handling of the BLE_HID class on the simulated
+ * BLE stack: the pacing of mouse reports and the coalescing of the
+ * movement in between, held keys across a reconnect and the connection
+ * parameter updates.
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#include "HostTest.hpp"
+#include "Sim.hpp"
+#include "BLE_HID.hpp"
+#include <utility/HCI.h>
+#include <vector>
+
+#define TEST_UUID_REPORT "2A4D"
+
+//-----------------------------------------------------------------------------------------------------------------
+static void __connect(BLE_HID& hid)
+{
+    hid.initService("Test Device");
+    SimBLE::connect();
+    hid.checkRemoteConnection();
+    SimBLE::clearNotifications();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+// Looks for the central and follows its connection like the report task of the sketch
+static void __poll(BLE_HID& hid)
+{
+    if(hid.checkRemoteAvailability(false))
+        hid.checkRemoteConnection();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+static std::vector<SimNotification> __mouseReports()
+{
+    std::vector<SimNotification> reports;
+    for(const SimNotification& notification : SimBLE::getNotifications())
+    {
+        if(notification.uuid == TEST_UUID_REPORT && !notification.data.empty() && notification.data[0] == MOUSE_ID)
+            reports.push_back(notification);
+    }
+    return reports;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+static std::vector<SimNotification> __keyboardReports()
+{
+    std::vector<SimNotification> reports;
+    for(const SimNotification& notification : SimBLE::getNotifications())
+    {
+        if(notification.uuid == TEST_UUID_REPORT && !notification.data.empty() && notification.data[0] == KEYBOARD_ID)
+            reports.push_back(notification);
+    }
+    return reports;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+// Holds a key and sends the keyboard report if connected, like the report task of the sketch
+static void __holdKey(BLE_HID& hid, char key)
+{
+    __poll(hid);
+    if(!SimBLE::isConnected())
+        return;
+    hid.setKeyboardButtonPress(key, 0);
+    hid.sendKeyboardMessage();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+static int32_t __sumX(const std::vector<SimNotification>& reports)
+{
+    int32_t sum = 0;
+    for(const SimNotification& report : reports)
+        sum += (int8_t)report.data[MOUSE_FIELD_X];
+    return sum;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(callerAtTheIntervalGetsEverySlotDespiteJitter)
+{
+    BLE_HID hid;
+    __connect(hid);
+
+    // A task running at the report interval, released a little early or late every other time
+    for(int i = 0; i < 100; i++)
+    {
+        SimClock::advance(i % 2 ? BLE_HID_MIN_REPORT_INTERVAL_US - 40 : BLE_HID_MIN_REPORT_INTERVAL_US + 40);
+        hid.setMouseMove(1, 0);
+        hid.sendMouseMessage();
+    }
+
+    std::vector<SimNotification> reports = __mouseReports();
+    CHECK_EQUAL(100u, reports.size());
+    CHECK_EQUAL(0u, hid.getCoalescedReports());
+    CHECK_EQUAL(100, __sumX(reports));
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(fastCallerIsPacedWithoutLosingMovement)
+{
+    BLE_HID hid;
+    __connect(hid);
+
+    for(int i = 0; i < 300; i++)
+    {
+        SimClock::advance(1000);
+        hid.setMouseMove(1, 0);
+        hid.sendMouseMessage();
+    }
+    SimClock::advance(BLE_HID_MIN_REPORT_INTERVAL_US);
+    hid.sendMouseMessage();
+
+    std::vector<SimNotification> reports = __mouseReports();
+    CHECK(reports.size() > 1);
+    for(size_t i = 1; i < reports.size(); i++)
+        CHECK(reports[i].time - reports[i - 1].time >=
+              BLE_HID_MIN_REPORT_INTERVAL_US - BLE_HID_MIN_REPORT_INTERVAL_US / BLE_HID_REPORT_EARLY_DIVISOR);
+    CHECK(hid.getCoalescedReports() > 0);
+    CHECK_EQUAL(300, __sumX(reports));
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(fastScrollingIsPacedWithoutLosingSteps)
+{
+    BLE_HID hid;
+    __connect(hid);
+
+    for(int i = 0; i < 300; i++)
+    {
+        SimClock::advance(1000);
+        hid.setMouseScroll(MOUSE_SCROLL_DOWN);
+        hid.sendMouseMessage();
+    }
+    SimClock::advance(BLE_HID_MIN_REPORT_INTERVAL_US);
+    hid.sendMouseMessage();
+
+    std::vector<SimNotification> reports = __mouseReports();
+    CHECK(reports.size() > 1);
+    CHECK(hid.getCoalescedReports() > 0);
+    int32_t sum = 0;
+    for(const SimNotification& report : reports)
+        sum += (int8_t)report.data[MOUSE_FIELD_WHEEL];
+    CHECK_EQUAL(300 * MOUSE_SCROLL_DOWN, sum);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(zeroIntervalSendsEveryReport)
+{
+    BLE_HID hid;
+    __connect(hid);
+    hid.setMinReportInterval(0);
+
+    for(int i = 0; i < 10; i++)
+    {
+        SimClock::advance(100);
+        hid.setMouseMove(0, 2);
+        hid.sendMouseMessage();
+    }
+
+    CHECK_EQUAL(10u, __mouseReports().size());
+    CHECK_EQUAL(0u, hid.getCoalescedReports());
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(identicalReportsWithoutMovementAreSuppressed)
+{
+    BLE_HID hid;
+    __connect(hid);
+
+    for(int i = 0; i < 5; i++)
+    {
+        SimClock::advance(BLE_HID_MIN_REPORT_INTERVAL_US);
+        hid.sendMouseMessage();
+    }
+
+    CHECK_EQUAL(0u, __mouseReports().size());
+    CHECK_EQUAL(5u, hid.getSuppressedReports());
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(heldKeyIsPressedAgainAfterAReconnect)
+{
+    BLE_HID hid;
+    uint8_t keycode = asciiToKey('a').keycode;
+    __connect(hid);
+    __holdKey(hid, 'a');
+    CHECK_EQUAL(keycode, __keyboardReports().back().data[3]);
+
+    // The key stays held while the connection drops and comes back
+    SimBLE::disconnect();
+    for(int i = 0; i < 3; i++)
+        __holdKey(hid, 'a');
+    SimBLE::clearNotifications();
+    SimBLE::connect();
+    for(int i = 0; i < 3; i++)
+        __holdKey(hid, 'a');
+
+    // The new connection starts released, then gets the held key once
+    std::vector<SimNotification> reports = __keyboardReports();
+    CHECK_EQUAL(2u, reports.size());
+    CHECK_EQUAL(0, reports[0].data[3]);
+    CHECK_EQUAL(keycode, reports[1].data[3]);
+    CHECK(reports[0].connected && reports[1].connected);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(keyReleasedWhileDisconnectedIsNotPressedAgain)
+{
+    BLE_HID hid;
+    __connect(hid);
+    __holdKey(hid, 'a');
+
+    SimBLE::disconnect();
+    __poll(hid);
+    SimBLE::clearNotifications();
+    SimBLE::connect();
+    __poll(hid);
+    for(int i = 0; i < 3; i++)
+    {
+        hid.sendKeyboardMessage();
+        __poll(hid);
+    }
+
+    std::vector<SimNotification> reports = __keyboardReports();
+    CHECK_EQUAL(1u, reports.size());
+    CHECK_EQUAL(0, reports[0].data[3]);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(updatesTheConnectionByTheHandleOfItsCentral)
+{
+    BLE_HID hid;
+    __connect(hid);
+    __poll(hid);
+    uint16_t first_handle = SimBLE::getConnectionHandle();
+    SimClock::advance(BLE_HID_PROFILE_HOLDOFF_US);
+    __poll(hid);
+
+    // The next connection gets another handle, a central with a random address is found as well
+    const uint8_t address[SIM_BLE_ADDRESS_LEN] = {0x01, 0x02, 0x03, 0x04, 0x05, 0xC6};
+    SimBLE::disconnect();
+    __poll(hid);
+    SimBLE::connect(address, SIM_BLE_ADDRESS_RANDOM);
+    __poll(hid);
+    SimClock::advance(BLE_HID_PROFILE_HOLDOFF_US);
+    __poll(hid);
+
+    const std::vector<SimConnectionUpdate>& updates = SimBLE::getConnectionUpdates();
+    CHECK_EQUAL(2u, updates.size());
+    CHECK_EQUAL(first_handle, updates[0].handle);
+    CHECK_EQUAL(SimBLE::getConnectionHandle(), updates[1].handle);
+    CHECK(updates[0].handle != updates[1].handle);
+    CHECK_EQUAL(0, updates[0].status);
+    CHECK_EQUAL(0, updates[1].status);
+    CHECK_EQUAL(0u, hid.getConnectionUpdateFailures());
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(reportsTheParametersTheHostPicked)
+{
+    BLE_HID hid;
+    BLEConnectionParameters parameters;
+    __connect(hid);
+    __poll(hid);
+
+    // The parameters the connection starts with are not known, nothing was requested yet
+    CHECK(!hid.getConnectionParameters(parameters));
+    CHECK(!hid.getRequestedConnectionParameters(parameters));
+
+    SimClock::advance(BLE_HID_PROFILE_HOLDOFF_US);
+    __poll(hid);
+    CHECK(hid.getRequestedConnectionParameters(parameters));
+    CHECK_EQUAL(BLE_HID_ACTIVE_MIN_INTERVAL, parameters.min_interval);
+    CHECK_EQUAL(BLE_HID_ACTIVE_MAX_INTERVAL, parameters.max_interval);
+
+    // Until the update completed the outcome is not known either
+    CHECK(!hid.getConnectionParameters(parameters));
+
+    // The host settles on one interval of the requested range
+    __poll(hid);
+    CHECK(hid.getConnectionParameters(parameters));
+    CHECK_EQUAL(BLE_HID_ACTIVE_MAX_INTERVAL, parameters.min_interval);
+    CHECK_EQUAL(BLE_HID_ACTIVE_MAX_INTERVAL, parameters.max_interval);
+    CHECK_EQUAL(BLE_HID_ACTIVE_LATENCY, parameters.latency);
+    CHECK_EQUAL(BLE_HID_ACTIVE_TIMEOUT, parameters.supervision_timeout);
+
+    SimBLE::disconnect();
+    __poll(hid);
+    CHECK(!hid.getConnectionParameters(parameters));
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(listensToTheHCIOnlyWhileAnUpdateIsOutstanding)
+{
+    BLE_HID hid;
+    __connect(hid);
+    __poll(hid);
+    CHECK(!SimBLE::isDumpingHCI());
+
+    SimClock::advance(BLE_HID_PROFILE_HOLDOFF_US);
+    __poll(hid);
+    CHECK(SimBLE::isDumpingHCI());
+    __poll(hid);
+    CHECK(!SimBLE::isDumpingHCI());
+
+    // A connection lost during an update takes the update with it
+    SimClock::advance(BLE_HID_IDLE_AFTER_US);
+    __poll(hid);
+    CHECK_EQUAL(BLE_HID_PROFILE_IDLE, hid.getConnectionProfile());
+    CHECK(SimBLE::isDumpingHCI());
+    SimBLE::disconnect();
+    __poll(hid);
+    CHECK(!SimBLE::isDumpingHCI());
+
+    // So does a request the controller refused right away
+    SimBLE::connect();
+    __poll(hid);
+    SimBLE::setCommandStatus(0x0C);
+    SimClock::advance(BLE_HID_PROFILE_HOLDOFF_US);
+    __poll(hid);
+    CHECK_EQUAL(1u, hid.getConnectionUpdateFailures());
+    CHECK(!SimBLE::isDumpingHCI());
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(requestsARejectedUpdateAgain)
+{
+    BLE_HID hid;
+    BLEConnectionParameters parameters;
+    __connect(hid);
+    hid.setAutoConnectionProfile(false);
+    __poll(hid);
+
+    // Unacceptable connection parameters, the connection keeps what it has
+    SimBLE::setUpdateStatus(0x3B);
+    SimClock::advance(BLE_HID_PROFILE_HOLDOFF_US);
+    __poll(hid);
+    __poll(hid);
+    CHECK_EQUAL(1u, hid.getConnectionUpdateFailures());
+    CHECK_EQUAL(BLE_HID_PROFILE_NONE, hid.getConnectionProfile());
+    CHECK(!hid.getConnectionParameters(parameters));
+    CHECK(!SimBLE::isDumpingHCI());
+
+    SimBLE::setUpdateStatus(0x00);
+    __poll(hid);
+    CHECK_EQUAL(1u, SimBLE::getConnectionUpdates().size());
+    SimClock::advance(BLE_HID_PROFILE_HOLDOFF_US);
+    __poll(hid);
+    __poll(hid);
+    CHECK_EQUAL(2u, SimBLE::getConnectionUpdates().size());
+    CHECK_EQUAL(BLE_HID_PROFILE_ACTIVE, hid.getConnectionProfile());
+    CHECK(hid.getConnectionParameters(parameters));
+}
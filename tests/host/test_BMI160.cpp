@@ -0,0 +1,264 @@
+/**********************************************************************
+ * test_BMI160.cpp
+ * 
+ * Tests of the BMI160 class against the register model of the sensor:
+ * decoding of canned FIFO contents, batch draining and the output data
+ * rates the reads keep up with. Also prints the size of the object
+ * against the sample histories it kept before the processing chain.
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#include "HostTest.hpp"
+#include "SimBMI160.hpp"
+#include "BMI160.hpp"
+#include <vector>
+
+// Gyroscope and accelerometer bits of FIFO_CONFIG_1, the FIFO is in use while they are set
+#define TEST_FIFO_DATA_ENABLE 0b11000000
+
+// The members of BMI160 before the processing chain, a history of SMOOTH_WINDOW_N data points per processing step
+struct BaselineMembers
+{
+    int8_t curr_n;
+    int16_t raw_data[SMOOTH_WINDOW_N][6];
+    float filtered_data[SMOOTH_WINDOW_N][6];
+    float grounded_data[SMOOTH_WINDOW_N][6];
+    float final_data[SMOOTH_WINDOW_N][6];
+    float grad_data[SMOOTH_WINDOW_N][6];
+};
+
+static std::vector<std::vector<int16_t>> _samples;
+
+//-----------------------------------------------------------------------------------------------------------------
+static void __collectSample(int16_t raw_data[6])
+{
+    _samples.push_back(std::vector<int16_t>(raw_data, raw_data + 6));
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+static void __startFifo(BMI160& bmi160, SimBMI160& sensor)
+{
+    CHECK(bmi160.configureBMI160());
+    CHECK(bmi160.enableFifo());
+    bmi160.setSampleCallback(__collectSample);
+    sensor.setSampling(false);
+    _samples.clear();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+static void __pushFrame(SimBMI160& sensor, const int16_t sample[6])
+{
+    uint8_t frame[BMI160_FIFO_FRAME_LEN];
+    for(int axis = 0; axis < 6; axis++)
+    {
+        frame[2 * axis] = sample[axis] & 0xFF;
+        frame[2 * axis + 1] = (sample[axis] >> 8) & 0xFF;
+    }
+    sensor.pushFifo(frame, sizeof(frame));
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(decodesCannedFifoFramesInOrder)
+{
+    SimBMI160 sensor(2);
+    BMI160 bmi160;
+    __startFifo(bmi160, sensor);
+
+    const int16_t frames[3][6] = {{1, -2, 3, -4, 5, 16384},
+                                  {-32768, 32767, 0, 256, -256, 255},
+                                  {100, 200, 300, 400, 500, 600}};
+    for(int i = 0; i < 3; i++)
+        __pushFrame(sensor, frames[i]);
+
+    CHECK_EQUAL(3, bmi160.fetchSensorData());
+    CHECK_EQUAL(3u, _samples.size());
+    for(size_t i = 0; i < _samples.size() && i < 3; i++)
+    {
+        for(int axis = 0; axis < 6; axis++)
+            CHECK_EQUAL(frames[i][axis], _samples[i][axis]);
+    }
+    CHECK_EQUAL(0u, sensor.getFifoLength());
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(drainsAtMostOneBatchPerRead)
+{
+    SimBMI160 sensor(2);
+    BMI160 bmi160;
+    __startFifo(bmi160, sensor);
+
+    for(int16_t i = 0; i < BMI160_FIFO_BATCH_N + 3; i++)
+    {
+        const int16_t frame[6] = {i, 0, 0, 0, 0, 0};
+        __pushFrame(sensor, frame);
+    }
+
+    CHECK_EQUAL(BMI160_FIFO_BATCH_N, bmi160.fetchSensorData());
+    CHECK_EQUAL(3, bmi160.fetchSensorData());
+    CHECK_EQUAL(0, bmi160.fetchSensorData());
+
+    // Nothing lost or repeated between the two batches
+    CHECK_EQUAL((size_t)BMI160_FIFO_BATCH_N + 3, _samples.size());
+    for(size_t i = 0; i < _samples.size(); i++)
+        CHECK_EQUAL((int16_t)i, _samples[i][GYR_X]);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(leavesAPartialFrameForTheNextRead)
+{
+    SimBMI160 sensor(2);
+    BMI160 bmi160;
+    __startFifo(bmi160, sensor);
+
+    const int16_t frame[6] = {7, 7, 7, 7, 7, 7};
+    __pushFrame(sensor, frame);
+    const uint8_t partial[5] = {1, 2, 3, 4, 5};
+    sensor.pushFifo(partial, sizeof(partial));
+
+    CHECK_EQUAL(1, bmi160.fetchSensorData());
+    CHECK_EQUAL((uint16_t)sizeof(partial), sensor.getFifoLength());
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(readsNothingFromAnEmptyFifo)
+{
+    SimBMI160 sensor(2);
+    BMI160 bmi160;
+    __startFifo(bmi160, sensor);
+
+    CHECK_EQUAL(0, bmi160.fetchSensorData());
+    CHECK(_samples.empty());
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(keepsUpWithTheSensorInFifoMode)
+{
+    SimBMI160 sensor(2);
+    BMI160 bmi160;
+    __startFifo(bmi160, sensor);
+    sensor.setSampling(true);
+
+    // Reading only every 50ms still gets every sample of the 100Hz sensor
+    uint32_t processed = 0;
+    uint32_t taken = sensor.getSampleCount();
+    for(int i = 0; i < 20; i++)
+    {
+        SimClock::advance(50000);
+        processed += bmi160.fetchSensorData();
+    }
+
+    // Samples taken during the last read are still in the FIFO
+    CHECK_EQUAL(sensor.getSampleCount() - taken, processed + sensor.getFifoLength() / BMI160_FIFO_FRAME_LEN);
+    CHECK_EQUAL(0u, sensor.getFifoOverflows());
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+// Runs the non-blocking read like the sensor task of modules.ino, once per millisecond
+static void __runSensorTask(BMI160& bmi160, uint32_t duration_us)
+{
+    for(uint32_t time = 0; time < duration_us; time += 1000)
+    {
+        if(bmi160.pollSensorRead() != BMI160_READ_BUSY)
+            bmi160.startSensorRead();
+        SimClock::advance(1000);
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(rejectsOutputDataRatesTheReadsCannotKeepUpWith)
+{
+    SimBMI160 sensor(2);
+    BMI160 bmi160;
+    CHECK(bmi160.configureBMI160());
+
+    BMI160Config config = BMI160_DEFAULT_CONFIG;
+    config.acc_odr = BMI160_ODR_200HZ;
+    config.gyr_odr = BMI160_ODR_200HZ;
+    CHECK(!bmi160.setConfig(config));
+
+    CHECK(bmi160.enableFifo());
+    config.acc_odr = BMI160_MAX_ODR_FIFO;
+    config.gyr_odr = BMI160_MAX_ODR_FIFO;
+    CHECK(bmi160.setConfig(config));
+    for(uint8_t odr = BMI160_MAX_ODR_FIFO + 1; odr <= BMI160_ODR_3200HZ; odr++)
+    {
+        config.gyr_odr = odr;
+        config.acc_odr = odr <= BMI160_ODR_1600HZ ? odr : BMI160_ODR_1600HZ;
+        CHECK(!bmi160.setConfig(config));
+    }
+    CHECK_EQUAL((int)BMI160_MAX_ODR_FIFO, (int)bmi160.getConfig().gyr_odr);
+
+    // Without the FIFO the rate would be too fast again
+    CHECK(!bmi160.disableFifo());
+    config = BMI160_DEFAULT_CONFIG;
+    CHECK(bmi160.setConfig(config));
+    CHECK(bmi160.disableFifo());
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(refusesTheFifoForDifferentOutputDataRates)
+{
+    SimBMI160 sensor(2);
+    BMI160 bmi160;
+    CHECK(bmi160.configureBMI160());
+
+    // Valid without the FIFO, but headerless frames cannot hold the accelerometer at half the rate
+    BMI160Config config = BMI160_DEFAULT_CONFIG;
+    config.acc_odr = BMI160_ODR_50HZ;
+    CHECK(bmi160.setConfig(config));
+    CHECK(!bmi160.enableFifo());
+    CHECK_EQUAL(0, sensor.getRegister(SIM_BMI160_REG_FIFO_CONFIG_1) & TEST_FIFO_DATA_ENABLE);
+
+    // The limits without the FIFO still apply
+    config.acc_odr = BMI160_MAX_ODR_FIFO;
+    config.gyr_odr = BMI160_MAX_ODR_FIFO;
+    CHECK(!bmi160.setConfig(config));
+
+    CHECK(bmi160.setConfig(BMI160_DEFAULT_CONFIG));
+    CHECK(bmi160.enableFifo());
+    CHECK_EQUAL(TEST_FIFO_DATA_ENABLE, sensor.getRegister(SIM_BMI160_REG_FIFO_CONFIG_1) & TEST_FIFO_DATA_ENABLE);
+    CHECK(bmi160.setConfig(config));
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(keepsUpWithTheFastestAcceptedRate)
+{
+    SimBMI160 sensor(2);
+    BMI160 bmi160;
+    CHECK(bmi160.configureBMI160());
+    bmi160.setReadTimeout(3000 + BMI160_READ_TIMEOUT_US);
+    CHECK(bmi160.enableFifo());
+    BMI160Config config = BMI160_DEFAULT_CONFIG;
+    config.acc_odr = BMI160_MAX_ODR_FIFO;
+    config.gyr_odr = BMI160_MAX_ODR_FIFO;
+    CHECK(bmi160.setConfig(config));
+    bmi160.enableDataReadyInterrupt(2);
+    bmi160.setSampleCallback(__collectSample);
+    _samples.clear();
+
+    uint32_t taken = sensor.getSampleCount();
+    __runSensorTask(bmi160, 2000000);
+
+    CHECK(sensor.getSampleCount() - taken >= 790);
+    CHECK_EQUAL(0u, sensor.getFifoOverflows());
+    CHECK_EQUAL(0u, bmi160.getDroppedSamples());
+    CHECK_EQUAL(0u, bmi160.getReadErrorCount(I2C_ERROR_TIMEOUT));
+
+    // Only what the last reads left in the FIFO is not processed yet
+    uint32_t pending = sensor.getFifoLength() / BMI160_FIFO_FRAME_LEN;
+    CHECK(pending <= 2 * BMI160_FIFO_BATCH_N);
+    CHECK_EQUAL(sensor.getSampleCount() - taken, (uint32_t)_samples.size() + pending);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(keepsLessProcessingStateThanTheHistories)
+{
+    // The chain and the latest raw, processed and gradient data replace the histories
+    size_t processing_size = sizeof(BMI160ProcessingChain) + 6 * sizeof(int16_t) + 12 * sizeof(float);
+    printf("  sizeof(BMI160): %zu bytes before, %zu bytes now (incl. bus, FIFO and interrupt state)\n",
+           sizeof(BaselineMembers), sizeof(BMI160));
+    printf("  processing state: %zu bytes before, %zu bytes now\n", sizeof(BaselineMembers), processing_size);
+    CHECK(processing_size < sizeof(BaselineMembers));
+}
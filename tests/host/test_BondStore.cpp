@@ -0,0 +1,274 @@
+/**********************************************************************
+ * test_BondStore.cpp
+ * 
+ * Tests of the BondStore class on a RAM storage: round trips, the
+ * replacement of the least recently used bond, and records which must
+ * not be loaded (broken CRC, other version, failed reads and writes).
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#include "HostTest.hpp"
+#include "BondStore.hpp"
+#include <string.h>
+
+static uint8_t _storage[sizeof(BondRecord)];
+static bool _storage_fails = false;
+static int _storage_writes = 0;
+
+//-----------------------------------------------------------------------------------------------------------------
+static bool __readStorage(uint8_t data[], uint16_t length)
+{
+    if(_storage_fails || length > sizeof(_storage))
+        return false;
+    memcpy(data, _storage, length);
+    return true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+static bool __writeStorage(const uint8_t data[], uint16_t length)
+{
+    if(_storage_fails || length > sizeof(_storage))
+        return false;
+    memcpy(_storage, data, length);
+    _storage_writes++;
+    return true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+// Erased flash reads as all ones
+static void __eraseStorage()
+{
+    memset(_storage, 0xFF, sizeof(_storage));
+    _storage_fails = false;
+    _storage_writes = 0;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+// Address and key of a host are derived from its number
+static void __address(uint8_t host, uint8_t address[BOND_ADDRESS_LEN])
+{
+    for(uint8_t i = 0; i < BOND_ADDRESS_LEN; i++)
+        address[i] = host * 16 + i;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+static void __key(uint8_t host, uint8_t key[BOND_KEY_LEN])
+{
+    for(uint8_t i = 0; i < BOND_KEY_LEN; i++)
+        key[i] = host ^ (i * 7);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+static void __bond(BondStore& store, uint8_t host)
+{
+    uint8_t address[BOND_ADDRESS_LEN];
+    uint8_t key[BOND_KEY_LEN];
+    __address(host, address);
+    __key(host, key);
+    store.storeLTK(address, key);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+static bool __isBonded(BondStore& store, uint8_t host)
+{
+    uint8_t address[BOND_ADDRESS_LEN];
+    uint8_t expected[BOND_KEY_LEN];
+    uint8_t key[BOND_KEY_LEN];
+    __address(host, address);
+    __key(host, expected);
+    return store.getLTK(address, key) && memcmp(key, expected, BOND_KEY_LEN) == 0;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(startsEmptyOnErasedStorage)
+{
+    __eraseStorage();
+    BondStore store(__readStorage, __writeStorage);
+
+    CHECK(!store.begin());
+    CHECK_EQUAL(0, (int)store.getBondCount());
+    CHECK(!store.isDirty());
+    CHECK(store.commit());
+    CHECK_EQUAL(0, _storage_writes);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(keepsBondsAcrossResets)
+{
+    __eraseStorage();
+    {
+        BondStore store(__readStorage, __writeStorage);
+        store.begin();
+        __bond(store, 1);
+        __bond(store, 2);
+        CHECK(store.isDirty());
+        CHECK(store.commit());
+        CHECK(!store.isDirty());
+    }
+
+    BondStore store(__readStorage, __writeStorage);
+    CHECK(store.begin());
+    CHECK_EQUAL(2, (int)store.getBondCount());
+    CHECK(__isBonded(store, 1));
+    CHECK(__isBonded(store, 2));
+    CHECK_EQUAL(1, _storage_writes);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(writesOnlyWhatChanged)
+{
+    __eraseStorage();
+    BondStore store(__readStorage, __writeStorage);
+    store.begin();
+    __bond(store, 1);
+    store.commit();
+
+    // The same key again and the key of the most recent host change nothing
+    __bond(store, 1);
+    CHECK(__isBonded(store, 1));
+    CHECK(!store.isDirty());
+    CHECK(store.commit());
+    CHECK_EQUAL(1, _storage_writes);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(replacesTheLeastRecentlyUsedBond)
+{
+    __eraseStorage();
+    BondStore store(__readStorage, __writeStorage);
+    store.begin();
+    for(uint8_t host = 1; host <= BOND_STORE_MAX_BONDS; host++)
+        __bond(store, host);
+
+    // Host 1 reconnects, so host 2 is the least recently used one now
+    CHECK(__isBonded(store, 1));
+    __bond(store, 10);
+
+    CHECK_EQUAL(BOND_STORE_MAX_BONDS, (int)store.getBondCount());
+    CHECK(!__isBonded(store, 2));
+    CHECK(__isBonded(store, 1));
+    CHECK(__isBonded(store, 10));
+    for(uint8_t host = 3; host <= BOND_STORE_MAX_BONDS; host++)
+        CHECK(__isBonded(store, host));
+
+    // The order survives the storage
+    uint8_t last[BOND_ADDRESS_LEN];
+    uint8_t expected[BOND_ADDRESS_LEN];
+    __bond(store, 3);
+    store.commit();
+    BondStore reloaded(__readStorage, __writeStorage);
+    CHECK(reloaded.begin());
+    CHECK(reloaded.getLastHost(last));
+    __address(3, expected);
+    CHECK(memcmp(last, expected, BOND_ADDRESS_LEN) == 0);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(rejectsARecordWithBrokenCrc)
+{
+    __eraseStorage();
+    {
+        BondStore store(__readStorage, __writeStorage);
+        store.begin();
+        __bond(store, 1);
+        store.commit();
+    }
+
+    // A single flipped bit in a key, e.g. from a write cut short by a reset
+    _storage[offsetof(BondRecord, bonds) + offsetof(BondEntry, ltk)] ^= 0x04;
+
+    BondStore store(__readStorage, __writeStorage);
+    CHECK(!store.begin());
+    CHECK_EQUAL(0, (int)store.getBondCount());
+    CHECK(!__isBonded(store, 1));
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(rejectsARecordOfAnotherVersion)
+{
+    __eraseStorage();
+    {
+        BondStore store(__readStorage, __writeStorage);
+        store.begin();
+        __bond(store, 1);
+        store.commit();
+    }
+
+    // Another layout with a valid CRC of its own
+    BondRecord record;
+    memcpy(&record, _storage, sizeof(record));
+    record.version = BOND_STORE_VERSION + 1;
+    record.crc = 0;
+    record.crc = crc16((const uint8_t*)&record, sizeof(record));
+    memcpy(_storage, &record, sizeof(record));
+
+    BondStore store(__readStorage, __writeStorage);
+    CHECK(!store.begin());
+    CHECK_EQUAL(0, (int)store.getBondCount());
+
+    // The next write replaces it with the current layout
+    __bond(store, 2);
+    CHECK(store.commit());
+    memcpy(&record, _storage, sizeof(record));
+    CHECK_EQUAL(BOND_STORE_VERSION, (int)record.version);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(rejectsARecordWithTooManyBonds)
+{
+    __eraseStorage();
+    BondRecord record;
+    memset(&record, 0, sizeof(record));
+    record.magic = BOND_STORE_MAGIC;
+    record.version = BOND_STORE_VERSION;
+    record.count = BOND_STORE_MAX_BONDS + 1;
+    record.crc = crc16((const uint8_t*)&record, sizeof(record));
+    memcpy(_storage, &record, sizeof(record));
+
+    BondStore store(__readStorage, __writeStorage);
+    CHECK(!store.begin());
+    CHECK_EQUAL(0, (int)store.getBondCount());
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(keepsChangesWhenTheWriteFails)
+{
+    __eraseStorage();
+    BondStore store(__readStorage, __writeStorage);
+    store.begin();
+    __bond(store, 1);
+
+    _storage_fails = true;
+    CHECK(!store.commit());
+    CHECK(store.isDirty());
+
+    _storage_fails = false;
+    CHECK(store.commit());
+    BondStore reloaded(__readStorage, __writeStorage);
+    CHECK(reloaded.begin());
+    CHECK(__isBonded(reloaded, 1));
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(removesBonds)
+{
+    __eraseStorage();
+    BondStore store(__readStorage, __writeStorage);
+    store.begin();
+    __bond(store, 1);
+    __bond(store, 2);
+    __bond(store, 3);
+    store.commit();
+
+    uint8_t address[BOND_ADDRESS_LEN];
+    __address(2, address);
+    CHECK(store.remove(address));
+    CHECK(!store.remove(address));
+    CHECK(store.isDirty());
+    CHECK_EQUAL(2, (int)store.getBondCount());
+    CHECK(__isBonded(store, 1));
+    CHECK(__isBonded(store, 3));
+    CHECK(!__isBonded(store, 2));
+}
@@ -0,0 +1,328 @@
+/**********************************************************************
+ * test_ButtonMatrix.cpp
+ * 
+ * Tests of the ButtonMatrix class on simulated switches: the debounce
+ * of bouncing contacts, the masking of ghost buttons in a matrix
+ * without diodes, and going idle and waking up on a button edge.
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#include "HostTest.hpp"
+#include "Sim.hpp"
+#include "ButtonMatrix.hpp"
+
+#define TEST_SCAN_US 1000
+
+static const uint8_t ROW_PINS[2] = {2, 3};
+static const uint8_t COL_PINS[3] = {10, 11, 12};
+
+typedef ButtonMatrix<2, 3> TestMatrix;
+
+//-----------------------------------------------------------------------------------------------------------------
+static void __setup(TestMatrix& matrix)
+{
+    for(uint8_t pin : ROW_PINS)
+        matrix.addRowPin(pin);
+    for(uint8_t pin : COL_PINS)
+        matrix.addColPin(pin);
+    matrix.setIdleTimeout(0);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+static void __setButton(uint8_t row, uint8_t col, bool closed)
+{
+    SimGPIO::setSwitch(ROW_PINS[row], COL_PINS[col], closed);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+static void __scan(TestMatrix& matrix, uint32_t duration_us, uint32_t period_us = TEST_SCAN_US)
+{
+    for(uint32_t time = 0; time < duration_us; time += period_us)
+    {
+        SimClock::advance(period_us);
+        matrix.fetchButtonPresses();
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(pressesAfterTheSettleTime)
+{
+    TestMatrix matrix;
+    __setup(matrix);
+    __scan(matrix, 10000);
+
+    __setButton(0, 1, true);
+    uint32_t pressed_at = micros();
+    while(!matrix.checkButtonPress(0, 1) && micros() - pressed_at < 20000)
+        __scan(matrix, TEST_SCAN_US);
+
+    // Scans take a few microseconds themselves, the press shows up on the scan which completes the settle time
+    uint32_t press_time = micros() - pressed_at;
+    CHECK(press_time >= BUTTON_DEFAULT_SETTLE_US && press_time < BUTTON_DEFAULT_SETTLE_US + TEST_SCAN_US);
+    ButtonEvent event = {0, 0, false, 0};
+    CHECK(matrix.popEvent(event));
+    CHECK_EQUAL(0, (int)event.row);
+    CHECK_EQUAL(1, (int)event.col);
+    CHECK(event.pressed);
+    CHECK(event.timestamp > pressed_at + BUTTON_DEFAULT_SETTLE_US - TEST_SCAN_US && event.timestamp <= micros());
+    CHECK(!matrix.popEvent(event));
+    CHECK_EQUAL(1, (int)matrix.getPressedCount());
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(turnsBouncingContactsIntoOneEvent)
+{
+    TestMatrix matrix;
+    __setup(matrix);
+    __scan(matrix, 10000);
+
+    // The contact bounces every scan for a while before it closes for good, and again when it opens
+    for(int i = 0; i < 8; i++)
+    {
+        __setButton(1, 2, i % 2 == 0);
+        __scan(matrix, TEST_SCAN_US);
+    }
+    __setButton(1, 2, true);
+    __scan(matrix, 20000);
+    for(int i = 0; i < 8; i++)
+    {
+        __setButton(1, 2, i % 2 == 1);
+        __scan(matrix, TEST_SCAN_US);
+    }
+    __setButton(1, 2, false);
+    __scan(matrix, 20000);
+
+    ButtonEvent event = {0, 0, false, 0};
+    CHECK(matrix.popEvent(event));
+    CHECK(event.pressed);
+    CHECK(matrix.popEvent(event));
+    CHECK(!event.pressed);
+    CHECK(!matrix.popEvent(event));
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(ignoresGlitchesShorterThanTheSettleTime)
+{
+    TestMatrix matrix;
+    __setup(matrix);
+    __scan(matrix, 10000);
+
+    __setButton(0, 0, true);
+    __scan(matrix, BUTTON_DEFAULT_SETTLE_US - 2 * TEST_SCAN_US);
+    __setButton(0, 0, false);
+    __scan(matrix, 20000);
+
+    ButtonEvent event;
+    CHECK(!matrix.popEvent(event));
+    CHECK(!matrix.checkButtonPress(0, 0));
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(integratesTimeNotScans)
+{
+    // Slow and fast scans see the press after the settle time, late by at most the first scan which has nothing to
+    // integrate from and the scan which completes the settle time
+    TestMatrix fast;
+    __setup(fast);
+    __setButton(0, 0, true);
+    uint32_t start = micros();
+    while(!fast.checkButtonPress(0, 0))
+        __scan(fast, 250, 250);
+    uint32_t fast_time = micros() - start;
+
+    Sim::reset();
+    TestMatrix slow;
+    __setup(slow);
+    __setButton(0, 0, true);
+    start = micros();
+    while(!slow.checkButtonPress(0, 0))
+        __scan(slow, 2000, 2000);
+    uint32_t slow_time = micros() - start;
+
+    CHECK(fast_time >= BUTTON_DEFAULT_SETTLE_US && fast_time <= BUTTON_DEFAULT_SETTLE_US + 2 * 250);
+    CHECK(slow_time >= BUTTON_DEFAULT_SETTLE_US && slow_time <= BUTTON_DEFAULT_SETTLE_US + 2 * 2000);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(holdsGhostButtonsAtTheirLastState)
+{
+    TestMatrix matrix;
+    __setup(matrix);
+
+    // Two buttons of row 0 are held, then a third one makes the rectangle which lets row 1 column 1 read pressed
+    __setButton(0, 0, true);
+    __setButton(0, 1, true);
+    __scan(matrix, 10000);
+    __setButton(1, 0, true);
+    __scan(matrix, 20000);
+
+    CHECK(matrix.checkButtonPress(0, 0));
+    CHECK(matrix.checkButtonPress(0, 1));
+    CHECK(!matrix.checkButtonPress(1, 1));
+    CHECK(!matrix.checkButtonPress(1, 0));
+    CHECK(matrix.getGhostScans() > 0);
+
+    // Once row 0 column 1 is released the reading is unambiguous again and the real button shows up
+    __setButton(0, 1, false);
+    __scan(matrix, 20000);
+    CHECK(matrix.checkButtonPress(0, 0));
+    CHECK(!matrix.checkButtonPress(0, 1));
+    CHECK(matrix.checkButtonPress(1, 0));
+    CHECK(!matrix.checkButtonPress(1, 1));
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(showsGhostsWithoutDetection)
+{
+    TestMatrix matrix;
+    __setup(matrix);
+    matrix.setGhostDetection(false);
+
+    __setButton(0, 0, true);
+    __setButton(0, 1, true);
+    __setButton(1, 0, true);
+    __scan(matrix, 20000);
+
+    // The simulated switches conduct like the real ones, the fourth corner reads pressed
+    CHECK(matrix.checkButtonPress(1, 1));
+    CHECK_EQUAL(4, (int)matrix.getPressedCount());
+    CHECK_EQUAL(0u, matrix.getGhostScans());
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(rollsOverCombinationsWithoutGhosts)
+{
+    TestMatrix matrix;
+    __setup(matrix);
+
+    // The rows share no column, so every button is real
+    __setButton(0, 0, true);
+    __setButton(0, 1, true);
+    __setButton(1, 2, true);
+    __scan(matrix, 20000);
+
+    CHECK_EQUAL(0x03, (int)matrix.getRowStates(0));
+    CHECK_EQUAL(0x04, (int)matrix.getRowStates(1));
+    CHECK_EQUAL((uint64_t)0x23, matrix.getButtonStates());
+    CHECK_EQUAL(0u, matrix.getGhostScans());
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(goesIdleWithoutActivity)
+{
+    TestMatrix matrix;
+    __setup(matrix);
+    matrix.setIdleTimeout(BUTTON_DEFAULT_IDLE_TIMEOUT_US);
+
+    __scan(matrix, BUTTON_DEFAULT_IDLE_TIMEOUT_US - 2 * TEST_SCAN_US);
+    CHECK(!matrix.isIdle());
+    __scan(matrix, 2 * TEST_SCAN_US);
+    CHECK(matrix.isIdle());
+    CHECK_EQUAL(3, (int)SimGPIO::getAttachedInterruptCount());
+
+    // Idle scans only look at the wake flag and leave the pins alone
+    uint32_t pin_calls = SimGPIO::getPinCallCount();
+    __scan(matrix, 50000);
+    CHECK_EQUAL(pin_calls, SimGPIO::getPinCallCount());
+    CHECK(matrix.isIdle());
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(staysAwakeWhileAButtonIsHeld)
+{
+    TestMatrix matrix;
+    __setup(matrix);
+    matrix.setIdleTimeout(BUTTON_DEFAULT_IDLE_TIMEOUT_US);
+
+    __setButton(1, 1, true);
+    __scan(matrix, 5 * BUTTON_DEFAULT_IDLE_TIMEOUT_US);
+    CHECK(!matrix.isIdle());
+    CHECK_EQUAL(0, (int)SimGPIO::getAttachedInterruptCount());
+
+    // The timeout starts with the release
+    __setButton(1, 1, false);
+    __scan(matrix, BUTTON_DEFAULT_IDLE_TIMEOUT_US);
+    CHECK(!matrix.isIdle());
+    __scan(matrix, BUTTON_DEFAULT_SETTLE_US + TEST_SCAN_US);
+    CHECK(matrix.isIdle());
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(wakesOnAButtonEdge)
+{
+    TestMatrix matrix;
+    __setup(matrix);
+    matrix.setIdleTimeout(BUTTON_DEFAULT_IDLE_TIMEOUT_US);
+    __scan(matrix, 2 * BUTTON_DEFAULT_IDLE_TIMEOUT_US);
+    CHECK(matrix.isIdle());
+
+    // The edge arrives right after a scan, the next scan wakes the matrix and takes the interrupts back
+    __setButton(0, 2, true);
+    CHECK(SimGPIO::getInterruptCount() > 0);
+    __scan(matrix, TEST_SCAN_US);
+    CHECK(!matrix.isIdle());
+    CHECK_EQUAL(0, (int)SimGPIO::getAttachedInterruptCount());
+    CHECK_EQUAL((uint32_t)TEST_SCAN_US, matrix.getWakeLatency());
+    CHECK_EQUAL(matrix.getWakeLatency(), matrix.getMaxWakeLatency());
+
+    // The time spent idle does not count for the debounce, the press needs the full settle time after waking
+    uint32_t woken_at = micros();
+    while(!matrix.checkButtonPress(0, 2) && micros() - woken_at < 20000)
+        __scan(matrix, TEST_SCAN_US);
+    CHECK((uint32_t)(micros() - woken_at) >= BUTTON_DEFAULT_SETTLE_US);
+
+    ButtonEvent event = {0, 0, false, 0};
+    CHECK(matrix.popEvent(event));
+    CHECK(event.pressed);
+    CHECK_EQUAL(2, (int)event.col);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(goesIdleAgainAfterWaking)
+{
+    TestMatrix matrix;
+    __setup(matrix);
+    matrix.setIdleTimeout(BUTTON_DEFAULT_IDLE_TIMEOUT_US);
+
+    for(int round = 0; round < 3; round++)
+    {
+        __scan(matrix, 2 * BUTTON_DEFAULT_IDLE_TIMEOUT_US);
+        CHECK(matrix.isIdle());
+        __setButton(1, 0, true);
+        __scan(matrix, 20000);
+        CHECK(!matrix.isIdle());
+        CHECK(matrix.checkButtonPress(1, 0));
+        __setButton(1, 0, false);
+        __scan(matrix, 20000);
+        CHECK(!matrix.checkButtonPress(1, 0));
+    }
+
+    ButtonEvent event;
+    int events = 0;
+    while(matrix.popEvent(event))
+        events++;
+    CHECK_EQUAL(6, events);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(leavesAnInterruptChannelForTheSensor)
+{
+    // The widest matrix next to the data ready interrupt of the BMI160 fits into the channels
+    ButtonMatrix<2, MATRIX_IO_INTERRUPT_CHANNELS - MATRIX_IO_RESERVED_CHANNELS> matrix;
+    matrix.addRowPin(ROW_PINS[0]);
+    matrix.addRowPin(ROW_PINS[1]);
+    for(uint8_t col = 0; col < MATRIX_IO_INTERRUPT_CHANNELS - MATRIX_IO_RESERVED_CHANNELS; col++)
+        matrix.addColPin(20 + col);
+    attachInterrupt(digitalPinToInterrupt(40), []() { }, RISING);
+
+    for(int i = 0; i < 300; i++)
+    {
+        SimClock::advance(TEST_SCAN_US);
+        matrix.fetchButtonPresses();
+    }
+
+    CHECK(matrix.isIdle());
+    CHECK_EQUAL(MATRIX_IO_INTERRUPT_CHANNELS, (int)SimGPIO::getMaxAttachedInterruptCount());
+}
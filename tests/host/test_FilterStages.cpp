@@ -0,0 +1,286 @@
+/**********************************************************************
+ * test_FilterStages.cpp
+ * 
+ * Tests of the filter stages against the processing the BMI160 class
+ * did before it was split into stages. BaselineBMI160 holds that code,
+ * copied unchanged from the class (only the bus read is left out), and
+ * both run over many passes of the sweep trace.
+ * The stages keep running sums where the baseline summed up its whole
+ * window on every sample, so the results may differ by a few float
+ * roundings but must not drift apart.
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#include "HostTest.hpp"
+#include "SimTrace.hpp"
+#include "BMI160.hpp"
+
+#include <float.h>
+
+// Passes over the sweep trace
+#define TEST_PASSES 20
+
+// Largest deviation from the baseline accepted, in float roundings of the largest magnitude of the axis in the
+// baseline output
+#define TEST_MAX_ROUNDINGS 4
+
+// The processing of BMI160.cpp before the stages, without the bus
+class BaselineBMI160
+{
+    public:
+    BaselineBMI160() :
+    _curr_n{0}
+    { }
+
+    void fetchSensorData(const int16_t raw_data[6])
+    {
+        int8_t prev_n = __getPrevN(_curr_n);
+
+        for(int i = 0; i < 6; i++)
+            _raw_data[_curr_n][i] = raw_data[i];
+        __normalizeData(_raw_data[_curr_n], _filtered_data[_curr_n]);
+        __filterData(_filtered_data[_curr_n], _filtered_data[prev_n], _filtered_data[_curr_n],
+                     (float)ALPHA_HIGH, (float)ALPHA_LOW);
+        __sqrRootData(_filtered_data[_curr_n], _filtered_data[_curr_n]);
+
+        __groundData(_filtered_data, _grounded_data[_curr_n]);
+        __smoothData(_grounded_data, _final_data[_curr_n]);
+
+        __computeGradient(_final_data[_curr_n], _final_data[prev_n], _grad_data[_curr_n]);
+
+        _curr_n = __getNextN(_curr_n);
+    }
+
+    void getProcessedData(float output[6])
+    {
+        int8_t fetched_data = __getPrevN(_curr_n);
+        for(int i = 0; i < 6; i++)
+            output[i] = _final_data[fetched_data][i];
+    }
+
+    void getGradientData(float output[6])
+    {
+        int8_t fetched_data = __getPrevN(_curr_n);
+        for(int i = 0; i < 6; i++)
+            output[i] = _grad_data[fetched_data][i];
+    }
+
+    private:
+    int8_t _curr_n;
+    int16_t _raw_data[SMOOTH_WINDOW_N][6];
+    float _filtered_data[SMOOTH_WINDOW_N][6];
+    float _grounded_data[SMOOTH_WINDOW_N][6];
+    float _final_data[SMOOTH_WINDOW_N][6];
+    float _grad_data[SMOOTH_WINDOW_N][6];
+
+    int8_t __getNextN(int8_t n, uint8_t steps = 1)
+    {
+        int8_t next_n = n + steps;
+        if(next_n >= SMOOTH_WINDOW_N)
+        {
+            next_n = next_n - SMOOTH_WINDOW_N;
+        }
+        return next_n;
+    }
+
+    int8_t __getPrevN(int8_t n, uint8_t steps = 1)
+    {
+        int8_t prev_n = n - steps;
+        if(prev_n < 0)
+        {
+            prev_n = prev_n + SMOOTH_WINDOW_N;
+        }
+        return prev_n;
+    }
+
+    void __normalizeData(int16_t input_data[6], float output_data[6])
+    {
+        output_data[GYR_X] = input_data[GYR_X] * 3.14 / 180.0 / 150.0;
+        output_data[GYR_Y] = input_data[GYR_Y] * 3.14 / 180.0 / 150.0;
+        output_data[GYR_Z] = input_data[GYR_Z] * 3.14 / 180.0 / 150.0;
+
+        output_data[ACC_X] = input_data[ACC_X] / 16384.0;
+        output_data[ACC_Y] = input_data[ACC_Y] / 16384.0;
+        output_data[ACC_Z] = input_data[ACC_Z] / 16384.0;
+
+        // To fix the constant gravity offset from the z axis.
+        output_data[ACC_Z] -= 1.0;
+    }
+
+    void __filterData(float input_data[6], float prev_input_data[6], float output_data[6],
+                      float alpha_high, float alpha_low)
+    {
+      for(int i = 0; i < 6; i++)
+      {
+        // High pass filter
+        output_data[i] = alpha_high * (prev_input_data[i] + input_data[i] - prev_input_data[i]);
+
+        // Low pass filter
+        output_data[i] = alpha_low * input_data[i] + (1 - alpha_low) * prev_input_data[i];
+      }
+    }
+
+    void __sqrRootData(float input_data[6], float output_data[6])
+    {
+        for(int i = 3; i < 6; i++)
+        {
+            bool is_neg = input_data[i] < 0;
+            int factor = 1;
+            if(is_neg) factor = -1;
+
+            output_data[i] = sqrt(input_data[i] * factor) * factor;
+        }
+    }
+
+    void __groundData(float input_data[][6], float output_data[])
+    {
+        float sum_value[6] = {0};
+        for(int i = 0; i < SMOOTH_WINDOW_N; i++)
+        {
+            for(int data_id = 3; data_id < 6; data_id++)
+            {
+                sum_value[data_id] += input_data[i][data_id];
+            }
+
+        }
+
+        for(int data_id = 0; data_id < 3; data_id++)
+        {
+            output_data[data_id] = input_data[_curr_n][data_id];
+        }
+        for(int data_id = 3; data_id < 6; data_id++)
+        {
+            float average_value = sum_value[data_id] / SMOOTH_WINDOW_N;
+            output_data[data_id] = input_data[_curr_n][data_id] - average_value;
+        }
+    }
+
+    void __smoothData(float input_data[][6], float output_data[])
+    {
+        float sum_value[6] = {0};
+        for(int i = 0; i < SMOOTH_WINDOW_N; i++)
+        {
+            for(int data_id = 0; data_id < 6; data_id++)
+            {
+                sum_value[data_id] += input_data[i][data_id];
+            }
+
+        }
+
+        for(int data_id = 0; data_id < 6; data_id++)
+        {
+            float average_value = sum_value[data_id] / SMOOTH_WINDOW_N;
+            output_data[data_id] = average_value;
+        }
+    }
+
+    void __computeGradient(float input_data[6], float prev_input_data[6], float output_data[6])
+    {
+        for(int i = 0; i < 6; i++)
+        {
+            output_data[i] = prev_input_data[i] - input_data[i];
+        }
+    }
+};
+
+// Largest deviation from the baseline and largest magnitude of the baseline output per axis
+struct Deviation
+{
+    double error[6];
+    double magnitude[6];
+};
+
+//-----------------------------------------------------------------------------------------------------------------
+static void __track(Deviation& deviation, const float baseline[6], const float actual[6])
+{
+    for(int i = 0; i < 6; i++)
+    {
+        deviation.error[i] = fmax(deviation.error[i], fabs((double)actual[i] - baseline[i]));
+        deviation.magnitude[i] = fmax(deviation.magnitude[i], fabs((double)baseline[i]));
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+static void __checkDeviation(const double error[6], const double magnitude[6], double roundings)
+{
+    for(int i = 0; i < 6; i++)
+        CHECK_NEAR(0.0, error[i], roundings * FLT_EPSILON * magnitude[i]);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+static std::vector<std::vector<int16_t>> __loadSweep()
+{
+    std::vector<std::vector<int16_t>> samples;
+    CHECK(SimTrace::load(SIM_TRACE_DIR "/sweep.csv", samples));
+    CHECK(!samples.empty());
+    return samples;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(chainFollowsTheBaselineFilters)
+{
+    // Both get the same normalized data, so only the filters are compared
+    std::vector<std::vector<int16_t>> samples = __loadSweep();
+    // Static like the global instance of the sketch, so its buffers start zeroed
+    static BaselineBMI160 baseline;
+    BMI160ProcessingChain chain;
+    chain.setSampleRate(100.0f);
+    Deviation deviation = {};
+
+    for(int pass = 0; pass < TEST_PASSES; pass++)
+    {
+        for(const std::vector<int16_t>& sample : samples)
+        {
+            baseline.fetchSensorData(sample.data());
+
+            float data[6];
+            for(int i = GYR_X; i <= GYR_Z; i++)
+                data[i] = sample[i] * 3.14 / 180.0 / 150.0;
+            for(int i = ACC_X; i <= ACC_Z; i++)
+                data[i] = sample[i] / 16384.0;
+            data[ACC_Z] -= 1.0;
+            chain.process(data);
+
+            float baseline_data[6];
+            baseline.getProcessedData(baseline_data);
+            __track(deviation, baseline_data, data);
+        }
+    }
+    __checkDeviation(deviation.error, deviation.magnitude, TEST_MAX_ROUNDINGS);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(processingFollowsTheBaseline)
+{
+    // The whole processing of a sample incl. normalization and gradient
+    std::vector<std::vector<int16_t>> samples = __loadSweep();
+    static BaselineBMI160 baseline;
+    BMI160 bmi160;
+    Deviation processed_deviation = {};
+    Deviation gradient_deviation = {};
+
+    for(int pass = 0; pass < TEST_PASSES; pass++)
+    {
+        for(const std::vector<int16_t>& sample : samples)
+        {
+            baseline.fetchSensorData(sample.data());
+            bmi160.processRawSample(sample.data(), 0);
+
+            float baseline_data[6];
+            float data[6];
+            baseline.getProcessedData(baseline_data);
+            bmi160.getProcessedData(data);
+            __track(processed_deviation, baseline_data, data);
+
+            baseline.getGradientData(baseline_data);
+            bmi160.getGradientData(data);
+            __track(gradient_deviation, baseline_data, data);
+        }
+    }
+    __checkDeviation(processed_deviation.error, processed_deviation.magnitude, TEST_MAX_ROUNDINGS);
+
+    // The gradient is the difference of two processed data points, so it carries the error of both
+    __checkDeviation(gradient_deviation.error, processed_deviation.magnitude, 2 * TEST_MAX_ROUNDINGS);
+}
@@ -0,0 +1,150 @@
+/**********************************************************************
+ * test_HCIEventTap.cpp
+ * 
+ * Tests of the HCIEventTap class on HCI dump lines as ArduinoBLE
+ * prints them.
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#include "HostTest.hpp"
+#include "HCIEventTap.hpp"
+
+// LE connection complete of handle 0x0001: interval 24, latency 0, timeout 72
+#define TEST_CONNECTION_COMPLETE "HCI EVENT RX <- 043E1301000100010066554433221118000000480000"
+// LE connection update complete of handle 0x0001: interval 6, latency 2, timeout 300
+#define TEST_CONNECTION_UPDATE_COMPLETE "HCI EVENT RX <- 043E0A03000100060002002C01"
+// Disconnection complete of handle 0x0001, remote user terminated
+#define TEST_DISCONNECTION_COMPLETE "HCI EVENT RX <- 04050400010013"
+
+//-----------------------------------------------------------------------------------------------------------------
+static void __dump(HCIEventTap& tap, const char* line)
+{
+    tap.println(line);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(expectsNothingAtFirst)
+{
+    HCIEventTap tap;
+    CHECK(!tap.isPending());
+    CHECK(!tap.isUpdated());
+
+    // An update nobody waits for is not taken
+    __dump(tap, TEST_CONNECTION_UPDATE_COMPLETE);
+    CHECK(!tap.isUpdated());
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(takesTheParametersOfTheUpdate)
+{
+    HCIEventTap tap;
+
+    tap.expectUpdate(0x0001);
+    CHECK(tap.isPending());
+    CHECK(!tap.isUpdated());
+
+    __dump(tap, TEST_CONNECTION_UPDATE_COMPLETE);
+    CHECK(!tap.isPending());
+    CHECK(tap.isUpdated());
+    CHECK_EQUAL(6, tap.getConnectionInterval());
+    CHECK_EQUAL(2, tap.getConnectionLatency());
+    CHECK_EQUAL(300, tap.getSupervisionTimeout());
+
+    // The next update starts over
+    tap.expectUpdate(0x0001);
+    CHECK(tap.isPending());
+    CHECK(!tap.isUpdated());
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(ignoresTheConnectionComplete)
+{
+    HCIEventTap tap;
+
+    // It carries the parameters the connection started with, not the outcome of the update
+    tap.expectUpdate(0x0001);
+    __dump(tap, TEST_CONNECTION_COMPLETE);
+    __dump(tap, "HCI EVENT RX <- 043E1F0A00010001006655443322110000000000000000000000000C000400900100");
+    CHECK(tap.isPending());
+    CHECK(!tap.isUpdated());
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(ignoresEventsOfOtherConnections)
+{
+    HCIEventTap tap;
+
+    // An update and a disconnect of handle 0x0002 while the update of 0x0001 is pending
+    tap.expectUpdate(0x0001);
+    __dump(tap, "HCI EVENT RX <- 043E0A03000200060002002C01");
+    __dump(tap, "HCI EVENT RX <- 04050400020013");
+    CHECK(tap.isPending());
+
+    __dump(tap, TEST_CONNECTION_UPDATE_COMPLETE);
+    CHECK(tap.isUpdated());
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(endsWithAFailedUpdate)
+{
+    HCIEventTap tap;
+
+    // Rejected with unacceptable connection parameters
+    tap.expectUpdate(0x0001);
+    __dump(tap, "HCI EVENT RX <- 043E0A033B0100180000004800");
+    CHECK(!tap.isPending());
+    CHECK(!tap.isUpdated());
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(endsWithTheConnection)
+{
+    HCIEventTap tap;
+
+    tap.expectUpdate(0x0001);
+    __dump(tap, TEST_DISCONNECTION_COMPLETE);
+    CHECK(!tap.isPending());
+    CHECK(!tap.isUpdated());
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(skipsEverythingButEvents)
+{
+    HCIEventTap tap;
+
+    // Commands, data and long packets around an update event split across several writes
+    tap.expectUpdate(0x0001);
+    __dump(tap, "HCI COMMAND TX -> 01132001000600060002002C0100000000");
+    __dump(tap, "HCI ACLDATA RX <- 0240000B000700040002043E0A03000100");
+    __dump(tap, "HCI EVENT RX <- 043E2C0D01000000000000000000000000000000000000000000000000000000"
+                "000000000000000000000000000000");
+    __dump(tap, "HCI EVENT RX <- 0F0400011320");
+    CHECK(tap.isPending());
+
+    tap.print("HCI EVENT RX <- 043E0A03");
+    tap.print("0001000600");
+    tap.println("02002C01");
+    CHECK(!tap.isPending());
+    CHECK(tap.isUpdated());
+    CHECK_EQUAL(6, tap.getConnectionInterval());
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(dropsBrokenLines)
+{
+    HCIEventTap tap;
+
+    // A truncated event, a length which does not match, half a byte and a line with garbage in it
+    tap.expectUpdate(0x0001);
+    __dump(tap, "HCI EVENT RX <- 043E0A030001000600");
+    __dump(tap, "HCI EVENT RX <- 043E0B03000100060002002C01");
+    __dump(tap, "HCI EVENT RX <- 043E0A03000100060002002C0");
+    __dump(tap, "HCI EVENT RX <- 043E0A030001000600x2002C01");
+    CHECK(tap.isPending());
+
+    // Lower case digits are fine
+    __dump(tap, "HCI EVENT RX <- 043e0a03000100060002002c01");
+    CHECK(tap.isUpdated());
+}
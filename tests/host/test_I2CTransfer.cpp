@@ -0,0 +1,188 @@
+/**********************************************************************
+ * test_I2CTransfer.cpp
+ * 
+ * Tests of the I2CTransfer class on the simulated bus, including the
+ * faults it has to survive: stalls, truncated reads and NAKs.
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#include "HostTest.hpp"
+#include "Sim.hpp"
+#include "I2CTransfer.hpp"
+
+#define TEST_ADDRESS 0x42
+
+// A device with 256 registers which are read with auto increment
+class TestDevice : public SimI2CDevice
+{
+    public:
+    TestDevice() : _address{0}
+    {
+        for(int i = 0; i < 256; i++)
+            _registers[i] = i ^ 0x5A;
+        SimI2C::addDevice(TEST_ADDRESS, *this);
+    }
+
+    bool write(const uint8_t data[], uint16_t length) override
+    {
+        if(length > 0)
+            _address = data[0];
+        return true;
+    }
+
+    uint16_t read(uint8_t data[], uint16_t length) override
+    {
+        for(uint16_t i = 0; i < length; i++)
+            data[i] = _registers[(uint8_t)(_address + i)];
+        return length;
+    }
+
+    uint8_t _registers[256];
+    uint8_t _address;
+};
+
+static int _callbacks = 0;
+
+//-----------------------------------------------------------------------------------------------------------------
+static void __countCallback(I2CTransfer& transfer, void* context)
+{
+    (void)transfer;
+    (void)context;
+    _callbacks++;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+static uint8_t __finish(I2CTransfer& transfer)
+{
+    uint8_t state;
+    while((state = transfer.poll()) == I2C_TRANSFER_BUSY)
+        SimClock::advance(100);
+    return state;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(advancesOneBusPhasePerPoll)
+{
+    TestDevice device;
+    I2CTransfer transfer(TEST_ADDRESS);
+    uint8_t buffer[4];
+
+    CHECK(transfer.start(0x10, buffer, sizeof(buffer)));
+    CHECK_EQUAL(I2C_TRANSFER_BUSY, transfer.poll());
+    CHECK_EQUAL(I2C_TRANSFER_BUSY, transfer.poll());
+    CHECK_EQUAL(I2C_TRANSFER_DONE, transfer.poll());
+    CHECK_EQUAL(4u, transfer.getReceived());
+    for(int i = 0; i < 4; i++)
+        CHECK_EQUAL((uint8_t)((0x10 + i) ^ 0x5A), buffer[i]);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(ignoresStartWhileBusy)
+{
+    TestDevice device;
+    I2CTransfer transfer(TEST_ADDRESS);
+    uint8_t buffer[4];
+
+    CHECK(transfer.start(0x10, buffer, sizeof(buffer)));
+    transfer.poll();
+    CHECK(!transfer.start(0x20, buffer, sizeof(buffer)));
+    CHECK_EQUAL(I2C_TRANSFER_DONE, __finish(transfer));
+    CHECK_EQUAL((uint8_t)(0x10 ^ 0x5A), buffer[0]);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(reportsMissingDeviceAsNak)
+{
+    I2CTransfer transfer(TEST_ADDRESS);
+    uint8_t buffer[4];
+
+    CHECK_EQUAL(0u, transfer.run(0x10, buffer, sizeof(buffer)));
+    CHECK_EQUAL(I2C_TRANSFER_ERROR, transfer.getState());
+    CHECK_EQUAL(I2C_ERROR_NAK, transfer.getLastError());
+    CHECK_EQUAL(1u, transfer.getErrorCount(I2C_ERROR_NAK));
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(reportsNakOfWriteAndRead)
+{
+    TestDevice device;
+    I2CTransfer transfer(TEST_ADDRESS);
+    transfer.setCallback(__countCallback, nullptr);
+    _callbacks = 0;
+    uint8_t buffer[4];
+
+    SimI2C::setFaults(SimI2CFaults{0, -1, true, false}, 1);
+    transfer.start(0x10, buffer, sizeof(buffer));
+    CHECK_EQUAL(I2C_TRANSFER_ERROR, transfer.poll());
+    CHECK_EQUAL(I2C_ERROR_NAK, transfer.getLastError());
+
+    SimI2C::setFaults(SimI2CFaults{0, -1, false, true});
+    transfer.start(0x10, buffer, sizeof(buffer));
+    CHECK_EQUAL(I2C_TRANSFER_ERROR, __finish(transfer));
+    CHECK_EQUAL(I2C_ERROR_NAK, transfer.getLastError());
+    CHECK_EQUAL(2u, transfer.getErrorCount(I2C_ERROR_NAK));
+    CHECK_EQUAL(2, _callbacks);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(reportsTruncatedReadAsShortRead)
+{
+    TestDevice device;
+    I2CTransfer transfer(TEST_ADDRESS);
+    uint8_t buffer[12];
+
+    SimI2C::setFaults(SimI2CFaults{0, 5, false, false});
+    transfer.start(0x00, buffer, sizeof(buffer));
+    CHECK_EQUAL(I2C_TRANSFER_ERROR, __finish(transfer));
+    CHECK_EQUAL(I2C_ERROR_SHORT_READ, transfer.getLastError());
+    CHECK_EQUAL(5u, transfer.getReceived());
+    CHECK(SimClock::now() > I2C_DEFAULT_TIMEOUT_US);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(abortsStalledTransferAfterTimeout)
+{
+    TestDevice device;
+    I2CTransfer transfer(TEST_ADDRESS);
+    uint8_t buffer[4];
+
+    SimI2C::setFaults(SimI2CFaults{I2C_DEFAULT_TIMEOUT_US + 500, -1, false, false});
+    transfer.start(0x00, buffer, sizeof(buffer));
+    CHECK_EQUAL(I2C_TRANSFER_ERROR, __finish(transfer));
+    CHECK_EQUAL(I2C_ERROR_TIMEOUT, transfer.getLastError());
+    CHECK_EQUAL(1u, transfer.getErrorCount(I2C_ERROR_TIMEOUT));
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(toleratesStallWithinTimeout)
+{
+    TestDevice device;
+    I2CTransfer transfer(TEST_ADDRESS);
+    transfer.setTimeout(10000);
+    uint8_t buffer[4];
+
+    SimI2C::setFaults(SimI2CFaults{3000, -1, false, false});
+    transfer.start(0x00, buffer, sizeof(buffer));
+    CHECK_EQUAL(I2C_TRANSFER_DONE, __finish(transfer));
+    CHECK_EQUAL(0u, transfer.getErrorCount(I2C_ERROR_TIMEOUT));
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(recoversAfterFault)
+{
+    TestDevice device;
+    I2CTransfer transfer(TEST_ADDRESS);
+    uint8_t buffer[8];
+
+    // The bytes a truncated read left behind must not show up in the next transfer
+    SimI2C::setFaults(SimI2CFaults{0, 3, false, false}, 2);
+    transfer.start(0x00, buffer, sizeof(buffer));
+    CHECK_EQUAL(I2C_TRANSFER_ERROR, __finish(transfer));
+
+    CHECK_EQUAL(8u, transfer.run(0x40, buffer, sizeof(buffer)));
+    CHECK_EQUAL(I2C_TRANSFER_DONE, transfer.getState());
+    for(int i = 0; i < 8; i++)
+        CHECK_EQUAL((uint8_t)((0x40 + i) ^ 0x5A), buffer[i]);
+}
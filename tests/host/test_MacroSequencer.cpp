@@ -0,0 +1,177 @@
+/**********************************************************************
+ * test_MacroSequencer.cpp
+ * 
+ * Tests of the MacroSequencer class and of the helpers which define
+ * macro steps. The timing runs on the simulated clock, ticked once per
+ * keyboard report.
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#include "HostTest.hpp"
+#include "Sim.hpp"
+#include "MacroSequencer.hpp"
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(mapsCharactersThroughTheAsciiTable)
+{
+    // A character given as key must never end up as usage ID, 'a' as usage ID would be 0x61
+    CHECK_EQUAL(KEY_A, (int)macroPress('a').keycode);
+    CHECK_EQUAL(MOD_NONE, (int)macroPress('a').modifier);
+    CHECK_EQUAL(KEY_A, (int)macroPress('A').keycode);
+    CHECK_EQUAL(MOD_LEFT_SHIFT, (int)macroPress('A').modifier);
+    CHECK_EQUAL(KEY_Z, (int)macroRelease('z').keycode);
+    CHECK_EQUAL(KEY_1, (int)macroHold('!', 10).keycode);
+    CHECK_EQUAL(MOD_LEFT_SHIFT, (int)macroHold('!', 10).modifier);
+    CHECK_EQUAL(10, (int)macroHold('!', 10).duration_ms);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(addsModifiersToTheImpliedOnes)
+{
+    MacroStep step = macroHold('C', MOD_LEFT_CTR, 20);
+    CHECK_EQUAL(KEY_A + 2, (int)step.keycode);
+    CHECK_EQUAL(MOD_LEFT_CTR | MOD_LEFT_SHIFT, (int)step.modifier);
+    CHECK_EQUAL(MOD_LEFT_ALT, (int)macroPress('c', MOD_LEFT_ALT).modifier);
+    CHECK_EQUAL(MOD_LEFT_GUI | MOD_LEFT_SHIFT, (int)macroRelease('C', MOD_LEFT_GUI).modifier);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(takesUsageIdsAsTheyAre)
+{
+    uint8_t keycode = KEY_F5;
+    CHECK_EQUAL(KEY_F5, (int)macroPress(keycode).keycode);
+    CHECK_EQUAL(KEY_ENTER, (int)macroRelease(KEY_ENTER).keycode);
+    CHECK_EQUAL(KEY_NONE, (int)macroPress(KEY_NONE, MOD_LEFT_CTR).keycode);
+    CHECK_EQUAL(MOD_LEFT_CTR, (int)macroPress(KEY_NONE, MOD_LEFT_CTR).modifier);
+    CHECK_EQUAL(KEY_DELETE, (int)macroHold(KEY_DELETE, MOD_NONE, 30).keycode);
+}
+
+// Time between two keyboard reports
+#define TEST_TICK_US 7500
+
+//-----------------------------------------------------------------------------------------------------------------
+// Ticks the sequencer until the held keys change and returns the time that took
+static uint32_t __ticksUntilChange(MacroSequencer& sequencer, uint32_t limit_us)
+{
+    uint32_t start = micros();
+    while((uint32_t)(micros() - start) < limit_us)
+    {
+        SimClock::advance(TEST_TICK_US);
+        if(sequencer.tick(micros()))
+            break;
+    }
+    return (uint32_t)(micros() - start);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(executesOneStepPerTick)
+{
+    MacroSequencer sequencer;
+    constexpr MacroStep macro[] = {macroPress(KEY_NONE, MOD_LEFT_CTR), macroPress('c'), macroRelease('c'),
+                                   macroRelease(KEY_NONE, MOD_LEFT_CTR)};
+    CHECK(sequencer.queue(macro, 4));
+
+    CHECK(sequencer.tick(micros()));
+    CHECK_EQUAL(MOD_LEFT_CTR, (int)sequencer.getModifier());
+    CHECK_EQUAL(0, (int)sequencer.getHeldKeyCount());
+
+    CHECK(sequencer.tick(micros()));
+    CHECK_EQUAL(1, (int)sequencer.getHeldKeyCount());
+    CHECK_EQUAL(KEY_A + 2, (int)sequencer.getHeldKey(0));
+
+    CHECK(sequencer.tick(micros()));
+    CHECK_EQUAL(0, (int)sequencer.getHeldKeyCount());
+    CHECK(sequencer.tick(micros()));
+    CHECK_EQUAL(MOD_NONE, (int)sequencer.getModifier());
+
+    CHECK(!sequencer.tick(micros()));
+    CHECK(!sequencer.isActive());
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(holdsKeysForTheDurationRoundedUpToTheNextTick)
+{
+    MacroSequencer sequencer;
+    constexpr MacroStep macro[] = {macroHold('x', 20), macroHold(KEY_ENTER, MOD_NONE, 30)};
+    sequencer.queue(macro, 2);
+
+    CHECK(sequencer.tick(micros()));
+    CHECK_EQUAL(1, (int)sequencer.getHeldKeyCount());
+
+    // 20ms are three ticks of 7.5ms, the key is released on the first tick past the duration
+    CHECK_EQUAL(3u * TEST_TICK_US, __ticksUntilChange(sequencer, 100000));
+    CHECK_EQUAL(0, (int)sequencer.getHeldKeyCount());
+
+    // 30ms are exactly four ticks
+    CHECK_EQUAL(1u * TEST_TICK_US, __ticksUntilChange(sequencer, 100000));
+    CHECK_EQUAL(KEY_ENTER, (int)sequencer.getHeldKey(0));
+    CHECK_EQUAL(4u * TEST_TICK_US, __ticksUntilChange(sequencer, 100000));
+    CHECK_EQUAL(0, (int)sequencer.getHeldKeyCount());
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(waitsWithoutChangingTheReport)
+{
+    MacroSequencer sequencer;
+    constexpr MacroStep macro[] = {macroPress('a'), macroWait(50), macroRelease('a')};
+    sequencer.queue(macro, 3);
+
+    CHECK(sequencer.tick(micros()));
+
+    // The wait starts on the next tick and ends on the first tick 50ms after that
+    CHECK_EQUAL(8u * TEST_TICK_US, __ticksUntilChange(sequencer, 100000));
+    CHECK_EQUAL(0, (int)sequencer.getHeldKeyCount());
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(releasesWhatAMacroLeftHeld)
+{
+    MacroSequencer sequencer;
+    constexpr MacroStep macro[] = {macroPress('A'), macroPress(KEY_TAB, MOD_LEFT_ALT)};
+    sequencer.queue(macro, 2);
+
+    sequencer.tick(micros());
+    sequencer.tick(micros());
+    CHECK_EQUAL(2, (int)sequencer.getHeldKeyCount());
+    CHECK_EQUAL(MOD_LEFT_SHIFT | MOD_LEFT_ALT, (int)sequencer.getModifier());
+    CHECK(sequencer.isActive());
+
+    // An additional tick releases everything once the queue runs empty
+    CHECK(sequencer.tick(micros()));
+    CHECK_EQUAL(0, (int)sequencer.getHeldKeyCount());
+    CHECK_EQUAL(MOD_NONE, (int)sequencer.getModifier());
+    CHECK(!sequencer.isActive());
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(timesAcrossTheWrapAroundOfTheClock)
+{
+    MacroSequencer sequencer;
+    constexpr MacroStep macro[] = {macroHold('q', 40)};
+    sequencer.queue(macro, 1);
+
+    SimClock::advance(0xFFFFFFFFu - 10000);
+    CHECK(sequencer.tick(micros()));
+    CHECK_EQUAL(6u * TEST_TICK_US, __ticksUntilChange(sequencer, 100000));
+    CHECK(micros() < 100000);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(rejectsMacrosWhichDoNotFit)
+{
+    MacroSequencer sequencer;
+    MacroStep macro[MACRO_QUEUE_N];
+    for(int i = 0; i < MACRO_QUEUE_N; i++)
+        macro[i] = macroHold('a');
+
+    CHECK(sequencer.queue(macro, MACRO_QUEUE_N - 2));
+    CHECK_EQUAL(2, (int)sequencer.getFreeSteps());
+    CHECK(!sequencer.queue(macro, 3));
+    CHECK_EQUAL(2, (int)sequencer.getFreeSteps());
+
+    sequencer.reset();
+    CHECK_EQUAL(MACRO_QUEUE_N, (int)sequencer.getFreeSteps());
+    CHECK(!sequencer.isActive());
+}
@@ -0,0 +1,179 @@
+/**********************************************************************
+ * test_PointerBallistics.cpp
+ * 
+ * Tests of the PointerBallistics class. Over long runs every bit of
+ * motion has to end up in a report, in the residual or, beyond the
+ * backlog, in the dropped pixels.
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#include "HostTest.hpp"
+#include "PointerBallistics.hpp"
+
+#define TEST_MAX_STEP 64
+
+// Motion added to a PointerBallistics and taken out of it in reports, per axis
+struct MotionBalance
+{
+    double added;
+    int64_t reported;
+};
+
+//-----------------------------------------------------------------------------------------------------------------
+static void __add(PointerBallistics& pointer, float velocity_x, float velocity_y, float sample_scale,
+                  MotionBalance balance[2])
+{
+    float speed = sqrtf(velocity_x * velocity_x + velocity_y * velocity_y);
+    double gain = (double)PointerBallistics::getGain(speed) * sample_scale;
+    balance[POINTER_X].added += velocity_x * gain;
+    balance[POINTER_Y].added += velocity_y * gain;
+    pointer.addMotion(velocity_x, velocity_y, 0);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+static void __take(PointerBallistics& pointer, MotionBalance balance[2])
+{
+    int8_t x;
+    int8_t y;
+    uint32_t sample_time;
+    pointer.takeReport(x, y, sample_time);
+    balance[POINTER_X].reported += x;
+    balance[POINTER_Y].reported += y;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(losesNoMotionOverALongTrace)
+{
+    PointerBallistics pointer(TEST_MAX_STEP);
+    MotionBalance balance[2] = {{0.0, 0}, {0.0, 0}};
+
+    // An hour at 100Hz of slow wrist movement with some tremor, reported every third sample
+    for(uint32_t i = 0; i < 360000; i++)
+    {
+        float t = i * 0.01f;
+        float velocity_x = 0.05f * sinf(t * 0.7f) + 0.002f * sinf(t * 13.0f);
+        float velocity_y = 0.02f * cosf(t * 0.23f) - 0.001f;
+        __add(pointer, velocity_x, velocity_y, 1.0f, balance);
+        if(i % 3 == 2)
+            __take(pointer, balance);
+    }
+
+    CHECK_EQUAL(0.0f, pointer.getDroppedPixels());
+    for(uint8_t axis = POINTER_X; axis <= POINTER_Y; axis++)
+    {
+        double accounted = balance[axis].reported + (double)pointer.getResidual(axis);
+        CHECK_NEAR(balance[axis].added, accounted, 0.5);
+        CHECK(fabsf(pointer.getResidual(axis)) < 1.0f);
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(addsUpSubPixelMotion)
+{
+    PointerBallistics pointer(TEST_MAX_STEP);
+    MotionBalance balance[2] = {{0.0, 0}, {0.0, 0}};
+
+    // Far below one pixel per sample, which truncating every sample would turn into no movement at all
+    float velocity = 0.3f / PointerBallistics::getGain(0.3f / POINTER_GAIN_LOW);
+    for(int i = 0; i < 1000; i++)
+    {
+        __add(pointer, velocity, -velocity, 1.0f, balance);
+        __take(pointer, balance);
+    }
+
+    CHECK(balance[POINTER_X].reported > 290);
+    CHECK(balance[POINTER_Y].reported < -290);
+    for(uint8_t axis = POINTER_X; axis <= POINTER_Y; axis++)
+        CHECK_NEAR(balance[axis].added, balance[axis].reported + (double)pointer.getResidual(axis), 1e-3);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(carriesOverMotionBeyondTheMaximumStep)
+{
+    PointerBallistics pointer(TEST_MAX_STEP);
+    MotionBalance balance[2] = {{0.0, 0}, {0.0, 0}};
+
+    // One fast sample, several reports to send it
+    __add(pointer, 1.0f, 0.0f, 1.0f, balance);
+    int reports = 0;
+    int8_t x;
+    int8_t y;
+    uint32_t sample_time;
+    while(pointer.takeReport(x, y, sample_time))
+    {
+        CHECK(x <= TEST_MAX_STEP);
+        balance[POINTER_X].reported += x;
+        reports++;
+    }
+
+    CHECK_EQUAL((int)(POINTER_GAIN_HIGH / TEST_MAX_STEP), reports);
+    CHECK_NEAR(balance[POINTER_X].added, (double)balance[POINTER_X].reported, 1.0);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(accountsForTheCappedBacklog)
+{
+    PointerBallistics pointer(TEST_MAX_STEP);
+    MotionBalance balance[2] = {{0.0, 0}, {0.0, 0}};
+
+    // Nobody takes reports for a while, everything beyond the backlog is counted as dropped
+    for(int i = 0; i < 50; i++)
+        __add(pointer, 1.0f, -0.5f, 1.0f, balance);
+    for(int i = 0; i < 100; i++)
+        __take(pointer, balance);
+
+    CHECK(pointer.getDroppedPixels() > 0.0f);
+    double added = fabs(balance[POINTER_X].added) + fabs(balance[POINTER_Y].added);
+    double reported = fabs((double)balance[POINTER_X].reported) + fabs((double)balance[POINTER_Y].reported);
+    double residual = fabsf(pointer.getResidual(POINTER_X)) + fabsf(pointer.getResidual(POINTER_Y));
+    CHECK_NEAR(added, reported + residual + pointer.getDroppedPixels(), 0.5);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(movesTheSameDistanceAtAnySampleRate)
+{
+    MotionBalance at_100hz[2] = {{0.0, 0}, {0.0, 0}};
+    MotionBalance at_400hz[2] = {{0.0, 0}, {0.0, 0}};
+    PointerBallistics pointer_100hz(TEST_MAX_STEP);
+    PointerBallistics pointer_400hz(TEST_MAX_STEP);
+    pointer_400hz.setSampleRate(400.0f);
+
+    // The same second of movement, sampled four times as often
+    for(int i = 0; i < 400; i++)
+    {
+        float velocity = 0.1f * sinf(i * 3.14159f / 400.0f);
+        __add(pointer_400hz, velocity, 0.0f, 0.25f, at_400hz);
+        if(i % 4 == 0)
+            __add(pointer_100hz, velocity, 0.0f, 1.0f, at_100hz);
+        __take(pointer_400hz, at_400hz);
+        __take(pointer_100hz, at_100hz);
+    }
+
+    CHECK_NEAR(at_100hz[POINTER_X].added, at_400hz[POINTER_X].added, 1.0);
+    CHECK_NEAR((double)at_100hz[POINTER_X].reported, (double)at_400hz[POINTER_X].reported, 1.0);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(tagsReportsWithTheOldestSample)
+{
+    PointerBallistics pointer(TEST_MAX_STEP);
+    int8_t x;
+    int8_t y;
+    uint32_t sample_time;
+
+    // Three samples complete the first pixel, the report carries the time of the first one
+    float velocity = 0.4f / POINTER_GAIN_LOW;
+    pointer.addMotion(velocity, 0.0f, 1000);
+    CHECK(!pointer.takeReport(x, y, sample_time));
+    pointer.addMotion(velocity, 0.0f, 2000);
+    pointer.addMotion(velocity, 0.0f, 3000);
+    CHECK(pointer.takeReport(x, y, sample_time));
+    CHECK_EQUAL(1, x);
+    CHECK_EQUAL(1000u, sample_time);
+
+    pointer.addMotion(velocity, 0.0f, 4000);
+    pointer.takeReport(x, y, sample_time);
+    CHECK_EQUAL(4000u, sample_time);
+}
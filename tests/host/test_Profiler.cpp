@@ -0,0 +1,119 @@
+/**********************************************************************
+ * test_Profiler.cpp
+ * 
+ * Tests of the Profiler class and of the profiling of the filter stage
+ * chains. Built with ENABLE_PROFILING, unlike the other tests.
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#include "HostTest.hpp"
+#include "BMI160.hpp"
+#include "Profiler.hpp"
+
+#ifndef ENABLE_PROFILING
+#error "test_Profiler has to be built with ENABLE_PROFILING"
+#endif
+
+// Collects what is printed
+class TestText : public Print
+{
+    public:
+    size_t write(uint8_t c) override
+    {
+        if(c != '\r')
+            text += (char)c;
+        return 1;
+    }
+
+    std::string text;
+};
+
+//-----------------------------------------------------------------------------------------------------------------
+static void __runChains(int processing_n, int one_euro_n)
+{
+    BMI160ProcessingChain chain;
+    BMI160OneEuroChain one_euro_chain;
+    float data[6] = {0.1f, -0.2f, 0.3f, 0.01f, -0.02f, 0.03f};
+
+    for(int i = 0; i < processing_n; i++)
+        chain.process(data);
+    for(int i = 0; i < one_euro_n; i++)
+        one_euro_chain.process(data);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+static bool __contains(const std::string& text, const char* part)
+{
+    return text.find(part) != std::string::npos;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(chainsProfileTheirStagesInTheirOwnZones)
+{
+    Profiler::reset();
+    __runChains(10, 4);
+
+    for(uint8_t stage = 0; stage < PROFILE_PROCESSING_STAGE_N; stage++)
+        CHECK_EQUAL(10u, Profiler::getCount(PROFILE_PROCESSING_STAGE + stage));
+    for(uint8_t stage = 0; stage < PROFILE_ONE_EURO_STAGE_N; stage++)
+        CHECK_EQUAL(4u, Profiler::getCount(PROFILE_ONE_EURO_STAGE + stage));
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(printsTheStagesByChainAndName)
+{
+    Profiler::reset();
+    __runChains(10, 4);
+
+    TestText output;
+    Profiler::print(output);
+    CHECK(__contains(output.text, "processing chain low pass: n 10 |"));
+    CHECK(__contains(output.text, "processing chain ground: n 10 |"));
+    CHECK(__contains(output.text, "processing chain smooth: n 10 |"));
+    CHECK(__contains(output.text, "one euro chain one euro: n 4 |"));
+    CHECK(__contains(output.text, "one euro chain gain: n 4 |"));
+    CHECK(__contains(output.text, "one euro chain low pass: n 4 |"));
+    CHECK(__contains(output.text, "one euro chain ground: n 4 |"));
+    CHECK(__contains(output.text, "one euro chain smooth: n 4 |"));
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(printsOnlyMeasuredZones)
+{
+    Profiler::reset();
+    Profiler::record(PROFILE_MATRIX_SCAN, 5);
+    Profiler::record(PROFILE_MATRIX_SCAN, 100);
+
+    TestText output;
+    Profiler::print(output);
+    CHECK(__contains(output.text, "matrix scan: n 2 | mean 52 | max 100 | p50 <128 | p99 <128\n"));
+    CHECK(__contains(output.text, " <2^3:1 <2^7:1\n"));
+    CHECK(!__contains(output.text, "chain"));
+    CHECK(!__contains(output.text, "hid"));
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(ignoresUnknownZones)
+{
+    Profiler::reset();
+    Profiler::record(PROFILE_ZONE_N, 5);
+    Profiler::record(0xFF, 5);
+
+    for(uint8_t zone = 0; zone < PROFILE_ZONE_N; zone++)
+        CHECK_EQUAL(0u, Profiler::getCount(zone));
+    CHECK_EQUAL(0u, Profiler::getCount(PROFILE_ZONE_N));
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(resetClearsAllZones)
+{
+    Profiler::reset();
+    __runChains(3, 3);
+    Profiler::record(PROFILE_HID_WRITE, 5);
+    Profiler::reset();
+
+    for(uint8_t zone = 0; zone < PROFILE_ZONE_N; zone++)
+        CHECK_EQUAL(0u, Profiler::getCount(zone));
+}
@@ -0,0 +1,116 @@
+/**********************************************************************
+ * test_SPSCRing.cpp
+ * 
+ * Tests of the SPSCRing class: full and empty ring, wrap around of the
+ * slots and of the 16 bit indices, and a producer and a consumer on two
+ * threads.
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#include "HostTest.hpp"
+#include "SPSCRing.hpp"
+#include <thread>
+
+#define TEST_THREAD_ITEMS 200000
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(startsEmpty)
+{
+    SPSCRing<uint32_t, 4> ring;
+    uint32_t value = 7;
+
+    CHECK(ring.empty());
+    CHECK_EQUAL(0u, ring.size());
+    CHECK(!ring.pop(value));
+    CHECK_EQUAL(7u, value);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(dropsPushesWhenFull)
+{
+    SPSCRing<uint32_t, 4> ring;
+    for(uint32_t i = 0; i < 4; i++)
+        CHECK(ring.push(i));
+
+    CHECK_EQUAL(4u, ring.size());
+    CHECK(!ring.push(99));
+
+    // The elements which fit are kept in order, the dropped one never shows up
+    uint32_t value = 0;
+    for(uint32_t i = 0; i < 4; i++)
+    {
+        CHECK(ring.pop(value));
+        CHECK_EQUAL(i, value);
+    }
+    CHECK(!ring.pop(value));
+
+    // Room again after popping
+    CHECK(ring.push(5));
+    CHECK_EQUAL(1u, ring.size());
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(keepsOrderAcrossTheWrapAround)
+{
+    SPSCRing<uint32_t, 8> ring;
+    uint32_t next_push = 0;
+    uint32_t next_pop = 0;
+    uint32_t value = 0;
+
+    // Uneven push and pop counts move the indices over every slot and past the 16 bit wrap of the indices
+    while(next_push < 200000)
+    {
+        for(int i = 0; i < 5 && ring.push(next_push); i++)
+            next_push++;
+        for(int i = 0; i < 3 && ring.pop(value); i++)
+        {
+            CHECK_EQUAL(next_pop, value);
+            next_pop++;
+        }
+        CHECK(ring.size() <= 8);
+    }
+    while(ring.pop(value))
+    {
+        CHECK_EQUAL(next_pop, value);
+        next_pop++;
+    }
+    CHECK_EQUAL(next_push, next_pop);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(passesEveryElementBetweenTwoThreads)
+{
+    SPSCRing<uint32_t, 16> ring;
+
+    // Both sides give way to the other while they cannot go on, so the test also runs on a single core
+    std::thread producer([&]()
+    {
+        for(uint32_t i = 0; i < TEST_THREAD_ITEMS; i++)
+        {
+            while(!ring.push(i))
+                std::this_thread::yield();
+        }
+    });
+
+    uint32_t expected = 0;
+    uint32_t out_of_order = 0;
+    uint32_t value = 0;
+    while(expected < TEST_THREAD_ITEMS)
+    {
+        if(!ring.pop(value))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        if(value != expected)
+            out_of_order++;
+        expected = value + 1;
+    }
+    producer.join();
+
+    CHECK_EQUAL(0u, out_of_order);
+    CHECK_EQUAL((uint32_t)TEST_THREAD_ITEMS, expected);
+    CHECK(ring.empty());
+}
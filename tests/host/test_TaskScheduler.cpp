@@ -0,0 +1,189 @@
+/**********************************************************************
+ * test_TaskScheduler.cpp
+ * 
+ * Tests of the TaskScheduler class against a scripted clock: earliest
+ * deadline first ordering, overruns, skipped releases and wrap around.
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#include "HostTest.hpp"
+#include "TaskScheduler.hpp"
+#include <string>
+
+static uint32_t _now = 0;
+static std::string _order;
+
+// Time each task takes, advanced on the scripted clock while it runs
+static uint32_t _runtime_a = 0;
+static uint32_t _runtime_b = 0;
+
+//-----------------------------------------------------------------------------------------------------------------
+static uint32_t __clock()
+{
+    return _now;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+static void __taskA()
+{
+    _order += "a";
+    _now += _runtime_a;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+static void __taskB()
+{
+    _order += "b";
+    _now += _runtime_b;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+static void __reset(uint32_t now)
+{
+    _now = now;
+    _order.clear();
+    _runtime_a = 0;
+    _runtime_b = 0;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(runsEarliestDeadlineFirst)
+{
+    __reset(0);
+    TaskScheduler scheduler(__clock);
+    scheduler.addTask(__taskA, 1000);
+    scheduler.addTask(__taskB, 500);
+
+    // Both are released at 0, B is due first
+    CHECK(scheduler.run());
+    CHECK(scheduler.run());
+    CHECK(!scheduler.run());
+    CHECK_EQUAL(std::string("ba"), _order);
+
+    // At 1000, B has its releases at 500 and 1000 pending (due at 1000 and 1500), A is due at 2000
+    _now = 1000;
+    _order.clear();
+    while(scheduler.run());
+    CHECK_EQUAL(std::string("bba"), _order);
+    CHECK_EQUAL(0u, scheduler.getStats(1).skipped);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(prefersTheEarlierDeadlineOverTheEarlierRelease)
+{
+    __reset(0);
+    TaskScheduler scheduler(__clock);
+    scheduler.addTask(__taskA, 1000);
+    _now = 600;
+    scheduler.addTask(__taskB, 300);
+
+    // A was released first but is due at 1000, B is due at 900
+    _now = 800;
+    while(scheduler.run());
+    CHECK_EQUAL(std::string("ba"), _order);
+    CHECK_EQUAL(800u, scheduler.getStats(0).max_jitter_us);
+    CHECK_EQUAL(200u, scheduler.getStats(1).max_jitter_us);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(runsNothingBeforeTheNextRelease)
+{
+    __reset(0);
+    TaskScheduler scheduler(__clock);
+    scheduler.addTask(__taskA, 1000);
+    CHECK(scheduler.run());
+
+    _now = 999;
+    CHECK(!scheduler.run());
+    _now = 1000;
+    CHECK(scheduler.run());
+    CHECK_EQUAL(2u, scheduler.getStats(0).runs);
+    CHECK_EQUAL(0u, scheduler.getStats(0).max_jitter_us);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(countsOverrunsPastTheDeadline)
+{
+    __reset(0);
+    TaskScheduler scheduler(__clock);
+    scheduler.addTask(__taskA, 1000);
+
+    // Finishing right at the deadline still holds it
+    _runtime_a = 1000;
+    scheduler.run();
+    CHECK_EQUAL(0u, scheduler.getStats(0).overruns);
+
+    _runtime_a = 1200;
+    scheduler.run();
+    CHECK_EQUAL(1u, scheduler.getStats(0).overruns);
+    CHECK_EQUAL(0u, scheduler.getStats(0).skipped);
+    CHECK_EQUAL(1200u, scheduler.getStats(0).max_runtime_us);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(skipsReleasesInsteadOfCatchingUp)
+{
+    __reset(0);
+    TaskScheduler scheduler(__clock);
+    scheduler.addTask(__taskA, 1000);
+
+    // Ends at 3500, the releases at 1000 and 2000 are over and 3000 is next
+    _runtime_a = 3500;
+    scheduler.run();
+    CHECK_EQUAL(1u, scheduler.getStats(0).overruns);
+    CHECK_EQUAL(2u, scheduler.getStats(0).skipped);
+
+    _runtime_a = 0;
+    CHECK(scheduler.run());
+    CHECK_EQUAL(500u, scheduler.getStats(0).max_jitter_us);
+    CHECK(!scheduler.run());
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(overrunDelaysButDoesNotStarveOtherTasks)
+{
+    __reset(0);
+    TaskScheduler scheduler(__clock);
+    scheduler.addTask(__taskA, 1000);
+    scheduler.addTask(__taskB, 5000);
+
+    // A overruns every period, B still gets its turn once its deadline is the earliest
+    _runtime_a = 1100;
+    for(int i = 0; i < 10; i++)
+        scheduler.run();
+    CHECK(_order.find('b') != std::string::npos);
+    CHECK(scheduler.getStats(0).overruns > 0);
+    CHECK_EQUAL(1u, scheduler.getStats(1).runs);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(survivesTheClockWrapAround)
+{
+    __reset(UINT32_MAX - 1500);
+    TaskScheduler scheduler(__clock);
+    scheduler.addTask(__taskA, 1000);
+    scheduler.addTask(__taskB, 700);
+
+    while(scheduler.run());
+    CHECK_EQUAL(std::string("ba"), _order);
+
+    // A is due after the wrap, B right before it
+    _now += 1000;
+    _order.clear();
+    while(scheduler.run());
+    CHECK_EQUAL(std::string("ba"), _order);
+    CHECK_EQUAL(0u, scheduler.getStats(0).overruns);
+    CHECK_EQUAL(0u, scheduler.getStats(1).overruns);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(rejectsTasksBeyondTheLimit)
+{
+    __reset(0);
+    TaskScheduler scheduler(__clock);
+    for(int i = 0; i < SCHEDULER_MAX_TASKS; i++)
+        CHECK_EQUAL(i, scheduler.addTask(__taskA, 1000));
+    CHECK_EQUAL(-1, scheduler.addTask(__taskA, 1000));
+}
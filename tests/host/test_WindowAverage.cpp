@@ -0,0 +1,140 @@
+/**********************************************************************
+ * test_WindowAverage.cpp
+ * 
+ * Tests of the WindowAverage class. The running sums are compared
+ * against summing up the whole window again on every data point, over
+ * many passes of the sweep trace, so rounding errors which pile up over
+ * long runs show.
+ * 
+ * Author: agent
+ * Created: October 2026
+ **********************************************************************/
+
+#include "HostTest.hpp"
+#include "BMI160.hpp"
+#include "SimTrace.hpp"
+#include "WindowAverage.hpp"
+
+// Passes over the sweep trace, about 30000 data points
+#define TEST_PASSES 100
+
+// Scale of the raw values. Unlike the raw integers, the scaled values do not add up exactly in floats.
+#define TEST_SCALE BMI160_GYR_SCALE_2000DPS
+
+// Largest deviation from the re-summed average accepted, relative to the largest magnitude of the axis. About two
+// roundings of a float, so any error which grows with the length of the run fails.
+#define TEST_MAX_RELATIVE_ERROR 2.5e-7
+
+//-----------------------------------------------------------------------------------------------------------------
+static std::vector<std::vector<int16_t>> __loadSweep()
+{
+    std::vector<std::vector<int16_t>> samples;
+    CHECK(SimTrace::load(SIM_TRACE_DIR "/sweep.csv", samples));
+    CHECK(!samples.empty());
+    return samples;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+template<uint16_t N>
+static void __checkAgainstResummation()
+{
+    std::vector<std::vector<int16_t>> samples = __loadSweep();
+
+    double max_magnitude[SIM_TRACE_AXES] = {0};
+    for(const std::vector<int16_t>& sample : samples)
+    {
+        for(int axis = 0; axis < SIM_TRACE_AXES; axis++)
+            max_magnitude[axis] = fmax(max_magnitude[axis], fabs(sample[axis] * TEST_SCALE));
+    }
+
+    WindowAverage<N, SIM_TRACE_AXES> average;
+    float window[SIM_TRACE_AXES][N] = {{0}};
+    uint16_t curr_n = 0;
+    double max_error[SIM_TRACE_AXES] = {0};
+
+    for(int pass = 0; pass < TEST_PASSES; pass++)
+    {
+        for(const std::vector<int16_t>& sample : samples)
+        {
+            float data[SIM_TRACE_AXES];
+            for(int axis = 0; axis < SIM_TRACE_AXES; axis++)
+            {
+                data[axis] = (float)(sample[axis] * TEST_SCALE);
+                window[axis][curr_n] = data[axis];
+            }
+            curr_n = (curr_n + 1) % N;
+            average.push(data);
+
+            float averages[SIM_TRACE_AXES];
+            average.getAverages(averages);
+            for(int axis = 0; axis < SIM_TRACE_AXES; axis++)
+            {
+                double sum = 0.0;
+                for(uint16_t i = 0; i < N; i++)
+                    sum += window[axis][i];
+                max_error[axis] = fmax(max_error[axis], fabs(sum / N - averages[axis]));
+            }
+        }
+    }
+
+    for(int axis = 0; axis < SIM_TRACE_AXES; axis++)
+        CHECK_NEAR(0.0, max_error[axis], TEST_MAX_RELATIVE_ERROR * max_magnitude[axis]);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(followsTheResummationOver6)
+{
+    __checkAgainstResummation<6>();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(followsTheResummationOver32)
+{
+    __checkAgainstResummation<32>();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(followsTheResummationOver64)
+{
+    __checkAgainstResummation<64>();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(startsFromZeros)
+{
+    WindowAverage<4, 2> average;
+    float data[2] = {8.0f, -4.0f};
+
+    average.push(data);
+    CHECK_EQUAL(2.0f, average.getAverage(0));
+    CHECK_EQUAL(-1.0f, average.getAverage(1));
+
+    average.reset();
+    CHECK_EQUAL(0.0f, average.getAverage(0));
+    CHECK_EQUAL(0.0f, average.getAverage(1));
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+TEST(settlesAfterALongRun)
+{
+    std::vector<std::vector<int16_t>> samples = __loadSweep();
+    WindowAverage<32, SIM_TRACE_AXES> average;
+
+    for(int pass = 0; pass < TEST_PASSES; pass++)
+    {
+        for(const std::vector<int16_t>& sample : samples)
+        {
+            float data[SIM_TRACE_AXES];
+            for(int axis = 0; axis < SIM_TRACE_AXES; axis++)
+                data[axis] = (float)(sample[axis] * TEST_SCALE);
+            average.push(data);
+        }
+    }
+
+    // Once the window holds a constant again, nothing of the run before is left in the sum
+    float data[SIM_TRACE_AXES] = {0.5f, -0.5f, 0.0f, 0.25f, -0.25f, 1.0f};
+    for(int i = 0; i < 32; i++)
+        average.push(data);
+    for(int axis = 0; axis < SIM_TRACE_AXES; axis++)
+        CHECK_EQUAL(data[axis], average.getAverage(axis));
+}
@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+"""
+telemetry_decode.py
+
+Decodes the binary telemetry stream of modules/src/Telemetry.cpp into a
+CSV trace. Reads either a raw capture file or a serial port directly
+(needs pyserial). Frames with a broken CRC are skipped, gaps in the
+sequence numbers are counted as lost frames.
+
+Usage:
+    telemetry_decode.py capture.bin -o trace.csv
+    telemetry_decode.py /dev/ttyACM0 --serial -o trace.csv
+
+Author: agent
+Created: October 2026
+"""
+
+import argparse
+import struct
+import sys
+
+TELEMETRY_SAMPLE = 0x01
+
+HEADER = struct.Struct("<BBI")          # type, sequence number, timestamp
+SAMPLE = struct.Struct("<6h6f")         # raw data, processed data
+AXES = ["gyr_x", "gyr_y", "gyr_z", "acc_x", "acc_y", "acc_z"]
+
+
+def crc16(data):
+    """CRC-16/CCITT with polynomial 0x1021 and initial value 0xFFFF."""
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def decode_cobs(encoded):
+    """Decodes one COBS frame without its zero delimiter. Returns None for malformed frames."""
+    decoded = bytearray()
+    i = 0
+    while i < len(encoded):
+        code = encoded[i]
+        if code == 0 or i + code > len(encoded) + 1:
+            return None
+        decoded += encoded[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(encoded):
+            decoded.append(0)
+    return bytes(decoded)
+
+
+def read_frames(stream):
+    """Yields the raw frames between zero delimiters."""
+    buffer = bytearray()
+    while True:
+        chunk = stream.read(256)
+        if not chunk:
+            break
+        buffer += chunk
+        while True:
+            end = buffer.find(0)
+            if end < 0:
+                break
+            frame = bytes(buffer[:end])
+            del buffer[:end + 1]
+            if frame:
+                yield frame
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode the binary telemetry stream into a CSV trace.")
+    parser.add_argument("source", help="capture file or serial port")
+    parser.add_argument("--serial", action="store_true", help="read from a serial port instead of a file")
+    parser.add_argument("-o", "--output", help="CSV file to write, stdout if not given")
+    args = parser.parse_args()
+
+    if args.serial:
+        import serial
+        stream = serial.Serial(args.source, timeout=1)
+    else:
+        stream = open(args.source, "rb")
+
+    output = open(args.output, "w") if args.output else sys.stdout
+    output.write("timestamp_us,sequence," + ",".join("raw_" + a for a in AXES) + ","
+                 + ",".join("processed_" + a for a in AXES) + "\n")
+
+    frames = 0
+    crc_errors = 0
+    lost = 0
+    last_sequence = None
+    try:
+        for encoded in read_frames(stream):
+            frame = decode_cobs(encoded)
+            if frame is None or len(frame) < HEADER.size + 2 or crc16(frame[:-2]) != struct.unpack("<H", frame[-2:])[0]:
+                crc_errors += 1
+                continue
+
+            frame_type, sequence, timestamp = HEADER.unpack_from(frame)
+            if last_sequence is not None:
+                lost += (sequence - last_sequence - 1) & 0xFF
+            last_sequence = sequence
+            frames += 1
+
+            payload = frame[HEADER.size:-2]
+            if frame_type == TELEMETRY_SAMPLE and len(payload) == SAMPLE.size:
+                values = SAMPLE.unpack(payload)
+                output.write("%d,%d," % (timestamp, sequence) + ",".join("%d" % v for v in values[:6]) + ","
+                             + ",".join("%.6g" % v for v in values[6:]) + "\n")
+    except KeyboardInterrupt:
+        pass
+
+    print("frames %d, crc errors %d, lost frames %d" % (frames, crc_errors, lost), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()